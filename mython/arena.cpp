@@ -0,0 +1,54 @@
+#include "arena.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace ast {
+
+namespace {
+// Блоки растут вдвое от первого до последнего размера, чтобы небольшие программы не занимали
+// лишнего, а большие выделяли память редко
+constexpr size_t FIRST_BLOCK_SIZE = 4 * 1024;
+constexpr size_t MAX_BLOCK_SIZE = 1024 * 1024;
+}  // namespace
+
+Arena::~Arena() {
+    for (Finalizer* finalizer = finalizers_; finalizer != nullptr; finalizer = finalizer->next) {
+        finalizer->destroy(finalizer->object);
+    }
+    while (blocks_ != nullptr) {
+        Block* next = blocks_->next;
+        ::operator delete(blocks_);
+        blocks_ = next;
+    }
+}
+
+void Arena::Adopt(unique_ptr<Arena> other) {
+    adopted_.push_back(std::move(other));
+}
+
+size_t Arena::ReservedBytes() const {
+    size_t result = reserved_bytes_;
+    for (const auto& arena : adopted_) {
+        result += arena->ReservedBytes();
+    }
+    return result;
+}
+
+void* Arena::AllocateInNewBlock(size_t size, size_t alignment) {
+    next_block_size_ = next_block_size_ == 0 ? FIRST_BLOCK_SIZE : min(next_block_size_ * 2, MAX_BLOCK_SIZE);
+    // Объект, который не помещается в обычный блок, получает собственный блок
+    const size_t block_size = max(next_block_size_, sizeof(Block) + size + alignment);
+
+    auto* block = static_cast<Block*>(::operator new(block_size));
+    block->next = blocks_;
+    blocks_ = block;
+    reserved_bytes_ += block_size;
+
+    current_ = reinterpret_cast<char*>(block + 1);
+    end_ = reinterpret_cast<char*>(block) + block_size;
+    return Allocate(size, alignment);
+}
+
+}  // namespace ast
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ast {
+
+// Нужно ли арене вызывать деструктор объекта типа T при освобождении. Специализации со значением
+// false объявляются для узлов, деструкторы которых освобождают только память самой арены
+template <typename T>
+struct ArenaNeedsDestructor : std::bool_constant<!std::is_trivially_destructible_v<T>> {};
+
+// Монотонная арена для узлов дерева программы. Память выделяется подряд из больших блоков
+// и возвращается только вместе с ареной, поэтому узлы одной программы лежат рядом в порядке
+// разбора, а освобождение программы не удаляет узлы по одному. Арена также служит
+// memory_resource для массивов дочерних узлов (std::pmr::vector).
+// Арена не потокобезопасна: в каждом потоке разбора используется своя арена
+class Arena : public std::pmr::memory_resource {
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena() override;
+
+    // Создаёт в арене объект типа T. Объект живёт, пока жива арена
+    template <typename T, typename... Args>
+    T* Make(Args&&... args) {
+        T* object = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (ArenaNeedsDestructor<T>::value) {
+            auto* finalizer = new (Allocate(sizeof(Finalizer), alignof(Finalizer))) Finalizer{
+                finalizers_, object, [](void* p) {
+                    static_cast<T*>(p)->~T();
+                }};
+            finalizers_ = finalizer;
+        }
+        return object;
+    }
+
+    // Копирует items в массив, память которого выделена в арене
+    template <typename T>
+    std::pmr::vector<T> MakeVector(const std::vector<T>& items) {
+        return std::pmr::vector<T>(items.begin(), items.end(), this);
+    }
+
+    // Копирует text в память арены и возвращает копию
+    std::string_view CopyText(std::string_view text) {
+        if (text.empty()) {
+            return {};
+        }
+        auto* data = static_cast<char*>(Allocate(text.size(), 1));
+        std::memcpy(data, text.data(), text.size());
+        return {data, text.size()};
+    }
+
+    // Продлевает жизнь арены other до конца жизни этой арены. Узлы, созданные в other, могут
+    // ссылаться на узлы этой арены и наоборот
+    void Adopt(std::unique_ptr<Arena> other);
+
+    // Возвращает объём памяти, полученной ареной под блоки, включая присоединённые арены
+    [[nodiscard]] std::size_t ReservedBytes() const;
+
+private:
+    struct Block {
+        Block* next;
+    };
+
+    struct Finalizer {
+        Finalizer* next;
+        void* object;
+        void (*destroy)(void*);
+    };
+
+    void* Allocate(std::size_t size, std::size_t alignment) {
+        const auto address = reinterpret_cast<std::uintptr_t>(current_);
+        const std::uintptr_t aligned = (address + alignment - 1) & ~(alignment - 1);
+        if (current_ != nullptr && aligned + size <= reinterpret_cast<std::uintptr_t>(end_)) {
+            current_ = reinterpret_cast<char*>(aligned + size);
+            return current_ - size;
+        }
+        return AllocateInNewBlock(size, alignment);
+    }
+
+    void* AllocateInNewBlock(std::size_t size, std::size_t alignment);
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        return Allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* /*p*/, std::size_t /*bytes*/, std::size_t /*alignment*/) override {
+    }
+
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    char* current_ = nullptr;
+    char* end_ = nullptr;
+    Block* blocks_ = nullptr;
+    // Объекты, деструкторы которых нужно вызвать, в порядке, обратном созданию
+    Finalizer* finalizers_ = nullptr;
+    std::size_t next_block_size_ = 0;
+    std::size_t reserved_bytes_ = 0;
+    std::vector<std::unique_ptr<Arena>> adopted_;
+};
+
+}  // namespace ast
@@ -0,0 +1,124 @@
+#include "arena.h"
+#include "test_runner_p.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace ast {
+
+namespace {
+// Записывает номер объекта в log при его уничтожении
+struct Tracked {
+    Tracked(vector<int>& log, int id)
+        : log(log)
+        , id(id) {
+    }
+    ~Tracked() {
+        log.push_back(id);
+    }
+
+    vector<int>& log;
+    int id;
+};
+
+// Такой же объект, но арена его не уничтожает
+struct Untracked : Tracked {
+    using Tracked::Tracked;
+};
+}  // namespace
+
+template <>
+struct ArenaNeedsDestructor<Untracked> : std::false_type {};
+
+namespace {
+void TestObjectsAreAlignedAndDistinct() {
+    Arena arena;
+    vector<char*> chars;
+    vector<double*> doubles;
+    for (int i = 0; i < 10'000; ++i) {
+        chars.push_back(arena.Make<char>(static_cast<char>(i)));
+        doubles.push_back(arena.Make<double>(i));
+    }
+    for (int i = 0; i < 10'000; ++i) {
+        ASSERT_EQUAL(*chars[i], static_cast<char>(i));
+        ASSERT_EQUAL(*doubles[i], static_cast<double>(i));
+        ASSERT_EQUAL(reinterpret_cast<uintptr_t>(doubles[i]) % alignof(double), 0U);
+    }
+    // Память выделяется блоками, а не под каждый объект
+    ASSERT(arena.ReservedBytes() < 10'000 * (sizeof(char) + sizeof(double)) * 4);
+}
+
+void TestLargeObjects() {
+    Arena arena;
+    auto* small = arena.Make<int>(1);
+    auto* large = arena.Make<array<char, 3'000'000>>();
+    large->fill('x');
+    auto* after = arena.Make<int>(2);
+    ASSERT_EQUAL(*small, 1);
+    ASSERT_EQUAL(*after, 2);
+    ASSERT_EQUAL(large->back(), 'x');
+    ASSERT(arena.ReservedBytes() >= large->size());
+}
+
+void TestDestructorsRunInReverseOrder() {
+    vector<int> log;
+    {
+        Arena arena;
+        arena.Make<Tracked>(log, 1);
+        arena.Make<Untracked>(log, 2);
+        arena.Make<Tracked>(log, 3);
+        ASSERT(log.empty());
+    }
+    ASSERT_EQUAL(log, (vector<int>{3, 1}));
+}
+
+void TestVectorsLiveInArena() {
+    Arena arena;
+    const vector<string> items = {"one"s, "two"s, "three"s};
+    const size_t reserved = arena.ReservedBytes();
+    pmr::vector<string> copy = arena.MakeVector(items);
+    ASSERT(copy.get_allocator().resource() == &arena);
+    ASSERT_EQUAL(vector<string>(copy.begin(), copy.end()), items);
+    ASSERT(arena.ReservedBytes() > reserved);
+}
+
+void TestCopiesText() {
+    Arena arena;
+    string text = "method body"s;
+    const string_view copy = arena.CopyText(text);
+    text.assign(text.size(), '?');
+    ASSERT_EQUAL(copy, "method body"sv);
+    ASSERT(arena.CopyText({}).empty());
+}
+
+void TestAdoptedArenaLivesAsLong() {
+    vector<int> log;
+    {
+        Arena arena;
+        auto other = make_unique<Arena>();
+        int* value = other->Make<int>(42);
+        other->Make<Tracked>(log, 1);
+        arena.Adopt(std::move(other));
+        ASSERT_EQUAL(*value, 42);
+        ASSERT(log.empty());
+    }
+    ASSERT_EQUAL(log, vector<int>{1});
+}
+}  // namespace
+
+void RunArenaTests(TestRunner& tr) {
+    RUN_TEST(tr, TestObjectsAreAlignedAndDistinct);
+    RUN_TEST(tr, TestLargeObjects);
+    RUN_TEST(tr, TestDestructorsRunInReverseOrder);
+    RUN_TEST(tr, TestVectorsLiveInArena);
+    RUN_TEST(tr, TestCopiesText);
+    RUN_TEST(tr, TestAdoptedArenaLivesAsLong);
+}
+
+}  // namespace ast
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Общие вспомогательные средства для бенчмарков: замер времени, статистика по выборке,
+// разбор общих параметров командной строки и вывод результатов в JSON
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+// Выполняет action и возвращает время его работы в миллисекундах
+template <typename Action>
+double MeasureMs(Action&& action) {
+    const auto start = Clock::now();
+    action();
+    const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    return elapsed.count();
+}
+
+// Не даёт компилятору выбросить вычисление value как неиспользуемое
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Stats {
+    size_t samples = 0;
+    double min = 0;
+    double median = 0;
+    double p99 = 0;
+    double mean = 0;
+};
+
+// Считает статистику по выборке. Перцентили берутся по методу ближайшего ранга
+inline Stats Summarize(std::vector<double> samples) {
+    Stats result;
+    if (samples.empty()) {
+        return result;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    auto rank = [&samples](double percent) {
+        const double position = percent / 100.0 * static_cast<double>(samples.size());
+        const auto index = static_cast<size_t>(position + 0.999999);
+        return samples[std::clamp<size_t>(index, 1, samples.size()) - 1];
+    };
+
+    result.samples = samples.size();
+    result.min = samples.front();
+    result.median = rank(50);
+    result.p99 = rank(99);
+    double sum = 0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    result.mean = sum / static_cast<double>(samples.size());
+    return result;
+}
+
+// Параметры, общие для всех бенчмарков
+struct Options {
+    int warmup = 3;
+    int repeat = 20;
+    // Запускаются только те замеры, в имени которых встречается filter
+    std::string filter;
+    // Имя файла для JSON-отчёта. Пустая строка означает стандартный вывод
+    std::string out;
+
+    [[nodiscard]] bool Selected(std::string_view name) const {
+        return filter.empty() || name.find(filter) != std::string_view::npos;
+    }
+};
+
+// Разбирает --warmup N, --repeat N, --filter S, --out FILE.
+// Неизвестные параметры передаются в extra(arg, next_value); тот возвращает true, если
+// использовал next_value
+template <typename ExtraHandler>
+Options ParseOptions(int argc, char* argv[], Options defaults, ExtraHandler&& extra) {
+    using namespace std::literals;
+
+    Options options = std::move(defaults);
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const char* next = i + 1 < argc ? argv[i + 1] : nullptr;
+        auto value = [&]() -> std::string {
+            if (next == nullptr) {
+                throw std::invalid_argument("Missing value for "s + std::string(arg));
+            }
+            ++i;
+            return next;
+        };
+
+        if (arg == "--warmup"sv) {
+            options.warmup = std::stoi(value());
+        } else if (arg == "--repeat"sv) {
+            options.repeat = std::max(1, std::stoi(value()));
+        } else if (arg == "--filter"sv) {
+            options.filter = value();
+        } else if (arg == "--out"sv) {
+            options.out = value();
+        } else if (extra(arg, next)) {
+            ++i;
+        }
+    }
+    return options;
+}
+
+// Минимальный потоковый генератор JSON: следит за запятыми и экранированием строк
+class JsonWriter {
+public:
+    explicit JsonWriter(std::ostream& os)
+        : os_(os) {
+        os_ << std::setprecision(6) << std::fixed;
+    }
+
+    JsonWriter& BeginObject() {
+        Separate();
+        os_ << '{';
+        first_ = true;
+        return *this;
+    }
+
+    JsonWriter& EndObject() {
+        os_ << '}';
+        first_ = false;
+        return *this;
+    }
+
+    JsonWriter& BeginArray() {
+        Separate();
+        os_ << '[';
+        first_ = true;
+        return *this;
+    }
+
+    JsonWriter& EndArray() {
+        os_ << ']';
+        first_ = false;
+        return *this;
+    }
+
+    JsonWriter& Key(std::string_view key) {
+        Separate();
+        String(key);
+        os_ << ':';
+        after_key_ = true;
+        return *this;
+    }
+
+    JsonWriter& Value(std::string_view value) {
+        Separate();
+        String(value);
+        return *this;
+    }
+
+    JsonWriter& Value(const char* value) {
+        return Value(std::string_view(value));
+    }
+
+    JsonWriter& Value(double value) {
+        Separate();
+        os_ << value;
+        return *this;
+    }
+
+    JsonWriter& Value(size_t value) {
+        Separate();
+        os_ << value;
+        return *this;
+    }
+
+    JsonWriter& Value(int value) {
+        Separate();
+        os_ << value;
+        return *this;
+    }
+
+    JsonWriter& Value(bool value) {
+        Separate();
+        os_ << (value ? "true" : "false");
+        return *this;
+    }
+
+    // Записывает статистику в виде объекта {"samples":..,"min_ms":..,...}.
+    // unit задаёт суффикс имён полей, например "_ns" для замеров в наносекундах
+    JsonWriter& Value(const Stats& stats, std::string_view unit = "_ms") {
+        using namespace std::literals;
+
+        BeginObject();
+        Key("samples"sv).Value(stats.samples);
+        Key("min"s.append(unit)).Value(stats.min);
+        Key("median"s.append(unit)).Value(stats.median);
+        Key("p99"s.append(unit)).Value(stats.p99);
+        Key("mean"s.append(unit)).Value(stats.mean);
+        return EndObject();
+    }
+
+private:
+    void Separate() {
+        if (after_key_) {
+            after_key_ = false;
+        } else if (!first_) {
+            os_ << ',';
+        }
+        first_ = false;
+    }
+
+    void String(std::string_view s) {
+        os_ << '"';
+        for (char c : s) {
+            switch (c) {
+            case '"':
+                os_ << "\\\"";
+                break;
+            case '\\':
+                os_ << "\\\\";
+                break;
+            case '\n':
+                os_ << "\\n";
+                break;
+            case '\t':
+                os_ << "\\t";
+                break;
+            default:
+                os_ << c;
+            }
+        }
+        os_ << '"';
+    }
+
+    std::ostream& os_;
+    bool first_ = true;
+    bool after_key_ = false;
+};
+
+}  // namespace bench
@@ -0,0 +1,380 @@
+#include "bench_runner_p.h"
+#include "bytecode.h"
+#include "closure_compiler.h"
+#include "lexer.h"
+#include "optimize.h"
+#include "parse.h"
+#include "runtime.h"
+#include "statement.h"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Программа из корпуса и вывод, который она обязана напечатать
+struct Workload {
+    string name;
+    string source;
+    string expected_output;
+};
+
+// Рекурсия в стиле примера Factorial из описания языка
+Workload RecursionWorkload() {
+    return {"recursion"s, R"(
+class Factorial:
+  def calc(n):
+    if n == 0:
+      return 1
+    return n * self.calc(n - 1)
+
+class Fib:
+  def calc(n):
+    if n < 2:
+      return n
+    return self.calc(n - 1) + self.calc(n - 2)
+
+class Repeat:
+  def run(n, fact):
+    if n > 0:
+      fact.calc(12)
+      self.run(n - 1, fact)
+
+fact = Factorial()
+fib = Fib()
+r = Repeat()
+r.run(300, fact)
+print fact.calc(10), fib.calc(18)
+)"s,
+            "3628800 2584\n"s};
+}
+
+// Много созданий объектов (NewInstance) и присваиваний полям (FieldAssignment)
+Workload ObjectsWorkload() {
+    return {"objects"s, R"(
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+  def shift(d):
+    self.x = self.x + d
+    self.y = self.y - d
+
+class Segment:
+  def __init__(a, b):
+    self.a = a
+    self.b = b
+    self.length = b.x - a.x
+
+class Builder:
+  def build(n, acc):
+    if n == 0:
+      return acc
+    p = Point(n, n * 2)
+    p.shift(1)
+    q = Point(p.x, p.y)
+    q.shift(2)
+    s = Segment(p, q)
+    return self.build(n - 1, acc + p.x + q.y + s.length)
+
+b = Builder()
+print b.build(500, 0)
+)"s,
+            "375750\n"s};
+}
+
+// Конкатенация строк через ast::Add
+Workload StringsWorkload() {
+    return {"strings"s, R"(
+class Append:
+  def run(n, s):
+    if n == 0:
+      return s
+    return self.run(n - 1, s + "ab" + str(n))
+
+class Prepend:
+  def run(i, n, s):
+    if i > n:
+      return s
+    return self.run(i + 1, n, "ab" + str(i) + s)
+
+a = Append()
+p = Prepend()
+x = a.run(400, "")
+y = p.run(1, 400, "")
+print x == y, "<" + str(x < y + "!") + ">"
+)"s,
+            "True <True>\n"s};
+}
+
+// Глубокая цепочка наследования: методы ищутся через всех предков
+Workload InheritanceWorkload() {
+    constexpr int depth = 16;
+
+    string source = R"(
+class Level0:
+  def __init__():
+    self.calls = 0
+
+  def root_value():
+    return 1
+
+  def __str__():
+    return "leaf with " + str(self.calls) + " calls"
+)"s;
+    for (int i = 1; i < depth; ++i) {
+        const string level = to_string(i);
+        source += "\nclass Level"s + level + "(Level"s + to_string(i - 1) + "):\n"s;
+        source += "  def value_"s + level + "():\n"s;
+        source += "    return "s + level + "\n"s;
+    }
+    source += R"(
+class Walker:
+  def run(n, obj, acc):
+    if n == 0:
+      return acc
+    obj.calls = obj.calls + 1
+    return self.run(n - 1, obj, acc + obj.root_value() + obj.value_1())
+)"s;
+    source += "\nleaf = Level"s + to_string(depth - 1) + "()\n"s;
+    source += R"(w = Walker()
+print w.run(500, leaf, 0)
+print leaf
+)"s;
+    return {"inheritance"s, std::move(source), "1000\nleaf with 500 calls\n"s};
+}
+
+// Сравнения пользовательских объектов через __lt__ и __eq__
+Workload ComparisonWorkload() {
+    return {"comparison"s, R"(
+class Version:
+  def __init__(major, minor):
+    self.major = major
+    self.minor = minor
+
+  def __eq__(other):
+    return self.major == other.major and self.minor == other.minor
+
+  def __lt__(other):
+    if self.major == other.major:
+      return self.minor < other.minor
+    return self.major < other.major
+
+class Counter:
+  def run(n, a, b, count):
+    if n == 0:
+      return count
+    if a < b:
+      count = count + 1
+    if a == b:
+      count = count + 10
+    if a <= b:
+      count = count + 100
+    if b > a:
+      count = count + 1000
+    if not a != b or a >= b:
+      count = count + 10000
+    return self.run(n - 1, a, b, count)
+
+older = Version(1, 4)
+newer = Version(1, 7)
+c = Counter()
+print c.run(400, older, newer, 0)
+)"s,
+            "440400\n"s};
+}
+
+// Выражения из одних констант: после ast::Optimize их значения вычислены до исполнения
+Workload ConstantsWorkload() {
+    return {"constants"s, R"(
+class Calc:
+  def run(n, acc):
+    if n == 0:
+      return acc
+    x = 2 * 5 + 10 / 2 - (3 - 1) * 4
+    s = "ab" + "cd" + str(12 * 12)
+    if 1 < 2 and not False:
+      acc = acc + x + 1
+    return self.run(n - 1, acc - -1)
+
+c = Calc()
+print c.run(500, 0), "ab" + "cd" + str(12 * 12)
+)"s,
+            "4500 abcd144\n"s};
+}
+
+// Большая библиотека классов, из которой программа использует два: время уходит на разбор
+// тел методов, которые никогда не вызываются
+Workload LibraryWorkload() {
+    constexpr int CLASS_COUNT = 400;
+    string source;
+    for (int i = 0; i < CLASS_COUNT; ++i) {
+        const string name = "Shape"s + to_string(i);
+        source += "class "s + name + ":\n"s
+                  "  def __init__(w, h):\n"s
+                  "    self.w = w\n"s
+                  "    self.h = h\n"s
+                  "  def area():\n"s
+                  "    return self.w * self.h + "s + to_string(i) + "\n"s
+                  "  def grow(d):\n"s
+                  "    if d > 0:\n"s
+                  "      self.w = self.w + d\n"s
+                  "      self.h = self.h + d\n"s
+                  "    else:\n"s
+                  "      self.w = self.w - 1\n"s
+                  "    return self\n"s
+                  "  def __str__():\n"s
+                  "    return '"s + name + "(' + str(self.w) + ', ' + str(self.h) + ')'\n"s
+                  "  def __eq__(other):\n"s
+                  "    return self.area() == other.area()\n"s;
+    }
+    source += "a = Shape0(2, 3)\n"s
+              "b = Shape1(4, 5)\n"s
+              "print a, b, a.area() + b.area()\n"s;
+    return {"library"s, std::move(source), "Shape0(2, 3) Shape1(4, 5) 27\n"s};
+}
+
+vector<Workload> Corpus() {
+    return {RecursionWorkload(), ObjectsWorkload(), StringsWorkload(), InheritanceWorkload(),
+            ComparisonWorkload(), ConstantsWorkload(), LibraryWorkload()};
+}
+
+struct PhaseSamples {
+    vector<double> lex;
+    vector<double> parse;
+    vector<double> optimize;
+    vector<double> compile;
+    vector<double> execute;
+    vector<double> total;
+};
+
+// Прогоняет программу один раз, раздельно замеряя фазы. Возвращает напечатанный программой текст.
+// Лексер выдаёт токены по запросу парсера, поэтому фаза parse включает в себя лексический разбор,
+// а фаза lex замеряется отдельным проходом по всем токенам. Как и интерпретатор, бенчмарк
+// разбирает тела методов при первом вызове, поэтому их разбор попадает в фазы optimize и execute.
+// Движки vm и closure компилируют программу (фаза compile) в байт-код или замыкания,
+// движок tree выполняет дерево
+string RunOnce(const Workload& workload, string_view engine, PhaseSamples* samples) {
+    unique_ptr<ast::Program> program;
+    ostringstream output;
+
+    const double lex_ms = bench::MeasureMs([&] {
+        parse::Lexer lexer(string_view{workload.source});
+        while (!lexer.CurrentToken().Is<parse::token_type::Eof>()) {
+            lexer.NextToken();
+        }
+    });
+    const double parse_ms = bench::MeasureMs([&] {
+        parse::Lexer lexer(string_view{workload.source});
+        program = ParseProgram(lexer, BodyParsing::LAZY);
+    });
+    const double optimize_ms = bench::MeasureMs([&] {
+        ast::Optimize(*program);
+    });
+    unique_ptr<runtime::Executable> compiled;
+    const double compile_ms = bench::MeasureMs([&] {
+        if (engine == "vm"sv) {
+            compiled = vm::Compile(*program);
+        } else if (engine == "closure"sv) {
+            compiled = closure_compiler::Compile(*program);
+        }
+    });
+    runtime::Executable& executable = compiled != nullptr ? *compiled : *program;
+    const double execute_ms = bench::MeasureMs([&] {
+        runtime::SimpleContext context{output};
+        runtime::Closure closure;
+        executable.Execute(closure, context);
+    });
+
+    if (samples != nullptr) {
+        samples->lex.push_back(lex_ms);
+        samples->parse.push_back(parse_ms);
+        samples->optimize.push_back(optimize_ms);
+        samples->compile.push_back(compile_ms);
+        samples->execute.push_back(execute_ms);
+        samples->total.push_back(parse_ms + optimize_ms + compile_ms + execute_ms);
+    }
+    return output.str();
+}
+
+void RunBenchmarks(const bench::Options& options, string_view engine, ostream& report) {
+    bench::JsonWriter json(report);
+    json.BeginObject();
+    json.Key("benchmark").Value("mython_workloads");
+    json.Key("warmup").Value(options.warmup);
+    json.Key("repeat").Value(options.repeat);
+    json.Key("engine").Value(engine);
+    json.Key("results").BeginArray();
+
+    for (const Workload& workload : Corpus()) {
+        if (!options.Selected(workload.name)) {
+            continue;
+        }
+        cerr << "Running "s << workload.name << "..."s << endl;
+
+        for (int i = 0; i < options.warmup; ++i) {
+            RunOnce(workload, engine, nullptr);
+        }
+        PhaseSamples samples;
+        bool output_ok = true;
+        for (int i = 0; i < options.repeat; ++i) {
+            output_ok = RunOnce(workload, engine, &samples) == workload.expected_output && output_ok;
+        }
+        if (!output_ok) {
+            cerr << workload.name << ": unexpected program output"s << endl;
+        }
+
+        json.BeginObject();
+        json.Key("name").Value(workload.name);
+        json.Key("source_bytes").Value(workload.source.size());
+        json.Key("output_ok").Value(output_ok);
+        json.Key("phases").BeginObject();
+        json.Key("lex").Value(bench::Summarize(samples.lex));
+        json.Key("parse").Value(bench::Summarize(samples.parse));
+        json.Key("optimize").Value(bench::Summarize(samples.optimize));
+        json.Key("compile").Value(bench::Summarize(samples.compile));
+        json.Key("execute").Value(bench::Summarize(samples.execute));
+        json.Key("total").Value(bench::Summarize(samples.total));
+        json.EndObject();
+        json.EndObject();
+    }
+
+    json.EndArray();
+    json.EndObject();
+    report << endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        string_view engine = "tree"sv;
+        auto extra = [&engine](string_view arg, const char* next) -> bool {
+            if (arg == "--engine"sv && next != nullptr
+                && (next == "tree"sv || next == "vm"sv || next == "closure"sv)) {
+                engine = next;
+                return true;
+            }
+            throw invalid_argument("Unknown option "s + string(arg));
+        };
+        const bench::Options options = bench::ParseOptions(argc, argv, {}, extra);
+
+        if (options.out.empty()) {
+            RunBenchmarks(options, engine, cout);
+        } else {
+            ofstream report(options.out);
+            RunBenchmarks(options, engine, report);
+        }
+    } catch (const std::exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
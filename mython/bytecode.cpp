@@ -0,0 +1,749 @@
+#include "bytecode.h"
+#include "resolve.h"
+
+#include <iterator>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+// Диспетчеризация команд переходом по таблице адресов меток (расширение GCC и Clang): каждый
+// обработчик сам переходит к следующему, и предсказатель переходов видит отдельный переход на
+// каждую команду. Другие компиляторы выбирают обработчик через switch
+#if defined(__GNUC__) || defined(__clang__)
+#define MYTHON_THREADED_DISPATCH 1
+#endif
+
+namespace vm {
+
+using runtime::ClassInstance;
+using runtime::Closure;
+using runtime::Context;
+using runtime::Number;
+using runtime::ObjectHolder;
+using runtime::Symbol;
+
+using engine::FALSE_VALUE;
+using engine::StackGuard;
+using engine::ToBool;
+using engine::TRUE_VALUE;
+
+namespace {
+
+const Symbol INIT_METHOD = "__init__"sv;
+const Symbol SELF = "self"sv;
+
+class Compiler {
+public:
+    // Код верхнего уровня: переменные хранятся в closure программы
+    explicit Compiler(Code& code)
+        : code_(code) {
+    }
+
+    // Тело метода: self, параметры и локальные переменные хранятся в ячейках, номера которых
+    // записаны в узлах тела (см. ast::MethodBody::ResolveSlots)
+    Compiler(Code& code, uint32_t argument_count, uint32_t slot_count)
+        : code_(code) {
+        code_.argument_count = argument_count;
+        code_.slot_count = slot_count;
+    }
+
+    void CompileProgram(ast::Statement* body) {
+        CompileStatement(body);
+        Emit(OpCode::END);
+    }
+
+    void CompileMethod(ast::Statement* body) {
+        CompileStatement(body);
+        Emit(OpCode::LOAD_NONE);
+        Emit(OpCode::RETURN);
+    }
+
+private:
+    // Инструкция, значение которой не нужно
+    void CompileStatement(ast::Statement* node) {
+        if (auto* compound = dynamic_cast<ast::Compound*>(node)) {
+            for (ast::Statement* statement : compound->Statements()) {
+                CompileStatement(statement);
+            }
+        } else if (auto* assignment = dynamic_cast<ast::Assignment*>(node)) {
+            CompileExpression(assignment->Value());
+            Store(assignment->GetName(), assignment->GetSlot());
+        } else if (auto* field_assignment = dynamic_cast<ast::FieldAssignment*>(node)) {
+            CompileFieldAssignment(*field_assignment, false);
+        } else if (auto* print = dynamic_cast<ast::Print*>(node)) {
+            const auto& args = print->Args();
+            for (size_t i = 0; i < args.size(); ++i) {
+                CompileExpression(args[i]);
+                Emit(OpCode::PRINT, 0, i + 1 < args.size() ? 1 : 0);
+            }
+            Emit(OpCode::NEWLINE);
+        } else if (auto* if_else = dynamic_cast<ast::IfElse*>(node)) {
+            CompileExpression(if_else->Condition());
+            const size_t to_else = Emit(OpCode::JUMP_IF_FALSE);
+            CompileStatement(if_else->IfBody());
+            if (if_else->ElseBody() != nullptr) {
+                const size_t to_end = Emit(OpCode::JUMP);
+                PatchJump(to_else);
+                CompileStatement(if_else->ElseBody());
+                PatchJump(to_end);
+            } else {
+                PatchJump(to_else);
+            }
+        } else if (auto* ret = dynamic_cast<ast::Return*>(node)) {
+            CompileExpression(ret->Value());
+            Emit(OpCode::RETURN);
+        } else if (auto* definition = dynamic_cast<ast::ClassDefinition*>(node)) {
+            CompileClass(*definition);
+            Store(definition->GetClass().GetSymbol(), definition->GetSlot());
+        } else {
+            CompileExpression(node);
+            Emit(OpCode::POP);
+        }
+    }
+
+    // Выражение, значение которого остаётся на вершине стека
+    void CompileExpression(ast::Statement* node) {
+        if (const auto* number = dynamic_cast<ast::NumericConst*>(node)) {
+            Emit(OpCode::LOAD_CONST, AddConstant(ObjectHolder::Own(Number(number->GetValue()))));
+        } else if (const auto* boolean = dynamic_cast<ast::BoolConst*>(node)) {
+            Emit(OpCode::LOAD_CONST, AddConstant(ToBool(boolean->GetValue().GetValue())));
+        } else if (const auto* str = dynamic_cast<ast::StringConst*>(node)) {
+            // Объект строки общий с константой дерева
+            Emit(OpCode::LOAD_CONST, AddConstant(str->GetValue()));
+        } else if (dynamic_cast<ast::None*>(node) != nullptr) {
+            Emit(OpCode::LOAD_NONE);
+        } else if (auto* variable = dynamic_cast<ast::VariableValue*>(node)) {
+            CompileVariable(*variable);
+        } else if (auto* assignment = dynamic_cast<ast::Assignment*>(node)) {
+            CompileExpression(assignment->Value());
+            Emit(OpCode::DUP);
+            Store(assignment->GetName(), assignment->GetSlot());
+        } else if (auto* field_assignment = dynamic_cast<ast::FieldAssignment*>(node)) {
+            CompileFieldAssignment(*field_assignment, true);
+        } else if (auto* call = dynamic_cast<ast::MethodCall*>(node)) {
+            // Аргументы вычисляются раньше объекта
+            for (ast::Statement* arg : call->Args()) {
+                CompileExpression(arg);
+            }
+            CompileExpression(call->Object());
+            Emit(OpCode::CALL, AddCall(call->GetMethod(), call->Args().size()));
+        } else if (auto* new_instance = dynamic_cast<ast::NewInstance*>(node)) {
+            CompileNewInstance(*new_instance);
+        } else if (auto* stringify = dynamic_cast<ast::Stringify*>(node)) {
+            CompileExpression(stringify->Argument());
+            Emit(OpCode::STRINGIFY);
+        } else if (auto* negate = dynamic_cast<ast::Negate*>(node)) {
+            CompileExpression(negate->Argument());
+            Emit(OpCode::NEG);
+        } else if (auto* negation = dynamic_cast<ast::Not*>(node)) {
+            CompileExpression(negation->Argument());
+            Emit(OpCode::NOT);
+        } else if (auto* disjunction = dynamic_cast<ast::Or*>(node)) {
+            CompileLogical(*disjunction, OpCode::JUMP_IF_TRUE, TRUE_VALUE);
+        } else if (auto* conjunction = dynamic_cast<ast::And*>(node)) {
+            CompileLogical(*conjunction, OpCode::JUMP_IF_FALSE, FALSE_VALUE);
+        } else if (auto* comparison = dynamic_cast<ast::Comparison*>(node)) {
+            CompileExpression(comparison->Lhs());
+            CompileExpression(comparison->Rhs());
+            CompileComparator(comparison->GetComparator());
+        } else if (auto* binary = dynamic_cast<ast::BinaryOperation*>(node)) {
+            CompileExpression(binary->Lhs());
+            CompileExpression(binary->Rhs());
+            Emit(ArithmeticOpCode(*binary));
+        } else if (auto* definition = dynamic_cast<ast::ClassDefinition*>(node)) {
+            CompileClass(*definition);
+            Emit(OpCode::DUP);
+            Store(definition->GetClass().GetSymbol(), definition->GetSlot());
+        } else if (auto* if_else = dynamic_cast<ast::IfElse*>(node)) {
+            // Значение ветвления - значение выполненной ветки
+            CompileExpression(if_else->Condition());
+            const size_t to_else = Emit(OpCode::JUMP_IF_FALSE);
+            CompileExpression(if_else->IfBody());
+            const size_t to_end = Emit(OpCode::JUMP);
+            PatchJump(to_else);
+            if (if_else->ElseBody() != nullptr) {
+                CompileExpression(if_else->ElseBody());
+            } else {
+                Emit(OpCode::LOAD_NONE);
+            }
+            PatchJump(to_end);
+        } else if (dynamic_cast<ast::Compound*>(node) != nullptr || dynamic_cast<ast::Print*>(node) != nullptr
+                   || dynamic_cast<ast::Return*>(node) != nullptr) {
+            CompileStatement(node);
+            Emit(OpCode::LOAD_NONE);
+        } else {
+            throw invalid_argument("Statement cannot be compiled to bytecode"s);
+        }
+    }
+
+    void CompileVariable(ast::VariableValue& variable) {
+        const auto& ids = variable.Ids();
+        Load(ids.front(), variable.GetSlot());
+        for (size_t i = 1; i < ids.size(); ++i) {
+            Emit(OpCode::GET_FIELD, AddName(ids[i]));
+        }
+    }
+
+    void CompileFieldAssignment(ast::FieldAssignment& assignment, bool keep_value) {
+        CompileVariable(assignment.Object());
+        CompileExpression(assignment.Value());
+        Emit(OpCode::SET_FIELD, AddName(assignment.GetFieldName()), keep_value ? 1 : 0);
+    }
+
+    // Аргументы вычисляются, только если у класса есть подходящий __init__
+    void CompileNewInstance(ast::NewInstance& new_instance) {
+        runtime::ClassInstance& instance = new_instance.Instance();
+        const uint32_t site = static_cast<uint32_t>(code_.instances.size());
+        code_.instances.push_back(InstanceSite{
+            &instance, ObjectHolder::Share(instance),
+            CallSite{INIT_METHOD, static_cast<uint32_t>(new_instance.Args().size())}});
+
+        const size_t to_end = Emit(OpCode::NEW, site);
+        for (ast::Statement* arg : new_instance.Args()) {
+            CompileExpression(arg);
+        }
+        Emit(OpCode::INIT, site);
+        code_.instructions[to_end].b = CurrentPosition();
+    }
+
+    // or и and: если значение левого аргумента определяет результат, правый не вычисляется
+    void CompileLogical(ast::BinaryOperation& operation, OpCode short_circuit, const ObjectHolder& result) {
+        CompileExpression(operation.Lhs());
+        const size_t to_result = Emit(short_circuit);
+        CompileExpression(operation.Rhs());
+        Emit(OpCode::TO_BOOL);
+        const size_t to_end = Emit(OpCode::JUMP);
+        PatchJump(to_result);
+        Emit(OpCode::LOAD_CONST, AddConstant(result));
+        PatchJump(to_end);
+    }
+
+    // Сравнения рантайма получают свои команды, в которых числа сравниваются без вызова функции
+    void CompileComparator(ast::Comparison::Comparator comparator) {
+        static const pair<ast::Comparison::Comparator, OpCode> KNOWN[] = {
+            {&runtime::Equal, OpCode::EQUAL},
+            {&runtime::NotEqual, OpCode::NOT_EQUAL},
+            {&runtime::Less, OpCode::LESS},
+            {&runtime::Greater, OpCode::GREATER},
+            {&runtime::LessOrEqual, OpCode::LESS_OR_EQUAL},
+            {&runtime::GreaterOrEqual, OpCode::GREATER_OR_EQUAL},
+        };
+        for (const auto& [known, op] : KNOWN) {
+            if (comparator == known) {
+                Emit(op);
+                return;
+            }
+        }
+        code_.comparators.push_back(comparator);
+        Emit(OpCode::COMPARE, code_.comparators.size() - 1);
+    }
+
+    static OpCode ArithmeticOpCode(ast::BinaryOperation& operation) {
+        if (dynamic_cast<ast::Add*>(&operation) != nullptr) {
+            return OpCode::ADD;
+        } else if (dynamic_cast<ast::Sub*>(&operation) != nullptr) {
+            return OpCode::SUB;
+        } else if (dynamic_cast<ast::Mult*>(&operation) != nullptr) {
+            return OpCode::MUL;
+        } else if (dynamic_cast<ast::Div*>(&operation) != nullptr) {
+            return OpCode::DIV;
+        }
+        throw invalid_argument("Statement cannot be compiled to bytecode"s);
+    }
+
+    // Объявление класса: его методы тоже будут исполняться байт-кодом
+    void CompileClass(ast::ClassDefinition& definition) {
+        engine::WrapMethods<MethodCode>(definition.GetClass());
+        code_.classes.push_back(&definition.GetClass());
+        Emit(OpCode::CLASS, code_.classes.size() - 1);
+    }
+
+    // Переменные без ячейки (ast::NO_SLOT) - переменные верхнего уровня
+    void Load(Symbol name, uint32_t slot) {
+        if (slot == ast::NO_SLOT) {
+            Emit(OpCode::LOAD_GLOBAL, AddName(name));
+            return;
+        }
+        // self и параметры получают значения при вызове, проверять их не нужно
+        Emit(slot <= code_.argument_count ? OpCode::LOAD_ARG : OpCode::LOAD_LOCAL, slot);
+    }
+
+    void Store(Symbol name, uint32_t slot) {
+        if (slot == ast::NO_SLOT) {
+            Emit(OpCode::STORE_GLOBAL, AddName(name));
+        } else {
+            Emit(OpCode::STORE_LOCAL, slot);
+        }
+    }
+
+    uint32_t AddName(Symbol name) {
+        const auto [it, inserted] = names_.emplace(name, static_cast<uint32_t>(code_.names.size()));
+        if (inserted) {
+            code_.names.push_back(name);
+        }
+        return it->second;
+    }
+
+    uint32_t AddConstant(ObjectHolder value) {
+        code_.constants.push_back(std::move(value));
+        return static_cast<uint32_t>(code_.constants.size() - 1);
+    }
+
+    uint32_t AddCall(Symbol method, size_t argument_count) {
+        code_.calls.push_back(CallSite{method, static_cast<uint32_t>(argument_count)});
+        return static_cast<uint32_t>(code_.calls.size() - 1);
+    }
+
+    size_t Emit(OpCode op, size_t a = 0, size_t b = 0) {
+        code_.instructions.push_back(Instruction{op, static_cast<uint32_t>(a), static_cast<uint32_t>(b)});
+        return code_.instructions.size() - 1;
+    }
+
+    uint32_t CurrentPosition() const {
+        return static_cast<uint32_t>(code_.instructions.size());
+    }
+
+    // Направляет переход jump на следующую команду
+    void PatchJump(size_t jump) {
+        code_.instructions[jump].a = CurrentPosition();
+    }
+
+    Code& code_;
+    unordered_map<Symbol, uint32_t> names_;
+};
+
+// Стек значений виртуальной машины. Кадр метода начинается с его параметров, за ними следуют
+// self, локальные переменные и промежуточные значения выражений. Стек один на поток: методы,
+// вызванные из рантайма (print, сравнения), продолжают его
+class Machine {
+public:
+    static Machine& Current() {
+        thread_local Machine machine;
+        return machine;
+    }
+
+    vector<ObjectHolder>& Stack() {
+        return stack_;
+    }
+
+    // Выполняет метод, аргументы и self которого лежат в стеке начиная с позиции base.
+    // Стек после возврата нужно сократить до base
+    ObjectHolder Invoke(MethodCode& method, size_t base, Context& context) {
+        Code& code = method.GetCode();
+        stack_.resize(base + code.slot_count, ast::UNASSIGNED);
+        return Run(code, base, nullptr, context);
+    }
+
+    ObjectHolder Run(Code& code, size_t base, Closure* globals, Context& context);
+
+private:
+    Machine() {
+        stack_.reserve(1024);
+    }
+
+    ObjectHolder Pop() {
+        ObjectHolder value = std::move(stack_.back());
+        stack_.pop_back();
+        return value;
+    }
+
+    // Вызывает метод site у объекта на вершине стека и заменяет объект и аргументы под ним
+    // результатом
+    void Call(CallSite& site, Context& context) {
+        auto* instance = stack_.back().TryAs<ClassInstance>();
+        if (instance == nullptr) {
+            throw runtime_error("There is no such method!"s);
+        }
+        site.Resolve(instance->GetClass());
+
+        const size_t base = stack_.size() - site.argument_count - 1;
+        ObjectHolder result;
+        if (site.target != nullptr) {
+            result = Invoke(*site.target, base, context);
+        } else {
+            const vector<ObjectHolder> args(make_move_iterator(stack_.begin() + static_cast<ptrdiff_t>(base)),
+                                            make_move_iterator(stack_.end() - 1));
+            result = instance->Call(site.method, args, context);
+        }
+        stack_.resize(base);
+        stack_.push_back(std::move(result));
+    }
+
+    // Обработчики команд, которым нужны временные ObjectHolder. Переход по адресу метки не вызывает
+    // деструкторы локальных переменных блока, из которого выходит, поэтому в цикле диспетчеризации
+    // ObjectHolder не объявляются
+
+    void Add(Context& context) {
+        const ObjectHolder rhs = Pop();
+        const ObjectHolder lhs = Pop();
+        stack_.push_back(engine::AddObjects(lhs, rhs, context));
+    }
+
+    void Compare(const ast::Comparison::Comparator& comparator, Context& context) {
+        const ObjectHolder rhs = Pop();
+        const ObjectHolder lhs = Pop();
+        stack_.push_back(ToBool(comparator(lhs, rhs, context)));
+    }
+
+    void GetField(Symbol name) {
+        auto* instance = stack_.back().TryAs<ClassInstance>();
+        if (instance == nullptr) {
+            throw runtime_error("No such variable!"s);
+        }
+        const auto it = instance->Fields().find(name);
+        if (it == instance->Fields().end()) {
+            throw runtime_error("No such variable!"s);
+        }
+        // Объект может держать только вершина стека, поэтому значение копируется до её замены
+        ObjectHolder value = it->second;
+        stack_.back() = std::move(value);
+    }
+
+    void SetField(Symbol name, bool keep_value) {
+        ObjectHolder value = Pop();
+        auto* instance = stack_.back().TryAs<ClassInstance>();
+        if (instance == nullptr) {
+            throw runtime_error("No such variable!"s);
+        }
+        instance->Fields()[name] = value;
+        if (keep_value) {
+            stack_.back() = std::move(value);
+        } else {
+            stack_.pop_back();
+        }
+    }
+
+    void Print(bool space, Context& context) {
+        const ObjectHolder value = Pop();
+        ostream& out = context.GetOutputStream();
+        if (value) {
+            value->Print(out, context);
+        } else {
+            out << "None"sv;
+        }
+        if (space) {
+            out.put(' ');
+        }
+    }
+
+    vector<ObjectHolder> stack_;
+};
+
+#ifdef MYTHON_THREADED_DISPATCH
+#define VM_CASE(name) label_##name
+#define VM_NEXT() goto* LABELS[static_cast<size_t>(pc->op)]
+#else
+#define VM_CASE(name) case OpCode::name
+#define VM_NEXT() continue
+#endif
+
+// Арифметика над двумя числами на вершине стека. Результат заменяет левый аргумент
+#define VM_ARITHMETIC(name, expression)                                             \
+    VM_CASE(name) : {                                                              \
+        const auto* rhs = stack_.back().TryAs<Number>();                           \
+        const auto* lhs = stack_[stack_.size() - 2].TryAs<Number>();               \
+        if (lhs == nullptr || rhs == nullptr) {                                    \
+            throw runtime_error("Wrong types!"s);                                  \
+        }                                                                          \
+        const int l = lhs->GetValue();                                             \
+        const int r = rhs->GetValue();                                             \
+        stack_.pop_back();                                                         \
+        stack_.back() = ObjectHolder::Own(Number(expression));                     \
+        ++pc;                                                                      \
+        VM_NEXT();                                                                 \
+    }
+
+// Сравнение: числа сравниваются на месте, остальные значения - функцией рантайма, которая
+// может вызвать метод объекта
+#define VM_COMPARISON(name, function, int_operator)                                 \
+    VM_CASE(name) : {                                                              \
+        const auto* rhs = stack_.back().TryAs<Number>();                           \
+        const auto* lhs = stack_[stack_.size() - 2].TryAs<Number>();               \
+        if (lhs != nullptr && rhs != nullptr) {                                    \
+            const bool result = lhs->GetValue() int_operator rhs->GetValue();      \
+            stack_.pop_back();                                                     \
+            stack_.back() = ToBool(result);                                        \
+        } else {                                                                   \
+            const ObjectHolder r = Pop();                                          \
+            const ObjectHolder l = Pop();                                          \
+            stack_.push_back(ToBool(function(l, r, context)));                     \
+        }                                                                          \
+        ++pc;                                                                      \
+        VM_NEXT();                                                                 \
+    }
+
+ObjectHolder Machine::Run(Code& code, const size_t base, Closure* globals, Context& context) {
+    const Instruction* const instructions = code.instructions.data();
+    const Instruction* pc = instructions;
+
+#ifdef MYTHON_THREADED_DISPATCH
+    static const void* const LABELS[] = {
+#define MYTHON_OPCODE_LABEL(name) &&label_##name,
+        MYTHON_OPCODES(MYTHON_OPCODE_LABEL)
+#undef MYTHON_OPCODE_LABEL
+    };
+    VM_NEXT();
+#else
+    for (;;) {
+        switch (pc->op) {
+#endif
+
+    VM_CASE(LOAD_CONST) : {
+        stack_.push_back(code.constants[pc->a]);
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(LOAD_NONE) : {
+        stack_.emplace_back();
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(LOAD_ARG) : {
+        stack_.push_back(stack_[base + pc->a]);
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(LOAD_LOCAL) : {
+        const ObjectHolder& value = stack_[base + pc->a];
+        if (ast::IsUnassigned(value)) {
+            throw runtime_error("No such variable!"s);
+        }
+        stack_.push_back(value);
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(STORE_LOCAL) : {
+        stack_[base + pc->a] = Pop();
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(LOAD_GLOBAL) : {
+        const auto it = globals->find(code.names[pc->a]);
+        if (it == globals->end()) {
+            throw runtime_error("No such variable!"s);
+        }
+        stack_.push_back(it->second);
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(STORE_GLOBAL) : {
+        (*globals)[code.names[pc->a]] = Pop();
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(GET_FIELD) : {
+        GetField(code.names[pc->a]);
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(SET_FIELD) : {
+        SetField(code.names[pc->a], pc->b != 0);
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(DUP) : {
+        stack_.push_back(stack_.back());
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(POP) : {
+        stack_.pop_back();
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(ADD) : {
+        Add(context);
+        ++pc;
+        VM_NEXT();
+    }
+    VM_ARITHMETIC(SUB, l - r)
+    VM_ARITHMETIC(MUL, l * r)
+    VM_CASE(DIV) : {
+        const auto* rhs = stack_.back().TryAs<Number>();
+        const auto* lhs = stack_[stack_.size() - 2].TryAs<Number>();
+        if (lhs == nullptr || rhs == nullptr) {
+            throw runtime_error("Wrong types!"s);
+        }
+        if (rhs->GetValue() == 0) {
+            throw runtime_error("Zero division!"s);
+        }
+        const int result = lhs->GetValue() / rhs->GetValue();
+        stack_.pop_back();
+        stack_.back() = ObjectHolder::Own(Number(result));
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(NEG) : {
+        const auto* number = stack_.back().TryAs<Number>();
+        if (number == nullptr) {
+            throw runtime_error("Wrong types!"s);
+        }
+        stack_.back() = ObjectHolder::Own(Number(-number->GetValue()));
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(NOT) : {
+        stack_.back() = ToBool(!runtime::IsTrue(stack_.back()));
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(TO_BOOL) : {
+        stack_.back() = ToBool(runtime::IsTrue(stack_.back()));
+        ++pc;
+        VM_NEXT();
+    }
+    VM_COMPARISON(EQUAL, runtime::Equal, ==)
+    VM_COMPARISON(NOT_EQUAL, runtime::NotEqual, !=)
+    VM_COMPARISON(LESS, runtime::Less, <)
+    VM_COMPARISON(GREATER, runtime::Greater, >)
+    VM_COMPARISON(LESS_OR_EQUAL, runtime::LessOrEqual, <=)
+    VM_COMPARISON(GREATER_OR_EQUAL, runtime::GreaterOrEqual, >=)
+    VM_CASE(COMPARE) : {
+        Compare(code.comparators[pc->a], context);
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(JUMP) : {
+        pc = instructions + pc->a;
+        VM_NEXT();
+    }
+    VM_CASE(JUMP_IF_FALSE) : {
+        const bool condition = runtime::IsTrue(stack_.back());
+        stack_.pop_back();
+        pc = condition ? pc + 1 : instructions + pc->a;
+        VM_NEXT();
+    }
+    VM_CASE(JUMP_IF_TRUE) : {
+        const bool condition = runtime::IsTrue(stack_.back());
+        stack_.pop_back();
+        pc = condition ? instructions + pc->a : pc + 1;
+        VM_NEXT();
+    }
+    VM_CASE(CALL) : {
+        Call(code.calls[pc->a], context);
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(NEW) : {
+        InstanceSite& site = code.instances[pc->a];
+        if (site.instance->HasMethod(INIT_METHOD, site.init.argument_count)) {
+            ++pc;
+        } else {
+            stack_.push_back(site.holder);
+            pc = instructions + pc->b;
+        }
+        VM_NEXT();
+    }
+    VM_CASE(INIT) : {
+        InstanceSite& site = code.instances[pc->a];
+        stack_.push_back(site.holder);
+        Call(site.init, context);
+        stack_.back() = site.holder;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(CLASS) : {
+        stack_.push_back(ObjectHolder::Own(ClassInstance(*code.classes[pc->a])));
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(STRINGIFY) : {
+        stack_.back() = engine::Stringify(stack_.back(), context);
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(PRINT) : {
+        Print(pc->b != 0, context);
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(NEWLINE) : {
+        context.GetOutputStream().put('\n');
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(RETURN) : {
+        // return вне метода, как и при обходе дерева, выбрасывает исключение из программы
+        if (globals != nullptr) {
+            throw ast::ReturnException(Pop());
+        }
+        return Pop();
+    }
+    VM_CASE(END) : {
+        return {};
+    }
+
+#ifndef MYTHON_THREADED_DISPATCH
+        }
+    }
+#endif
+}
+
+#undef VM_COMPARISON
+#undef VM_ARITHMETIC
+#undef VM_NEXT
+#undef VM_CASE
+
+}  // namespace
+
+string_view OpCodeName(OpCode op) {
+    static const string_view NAMES[] = {
+#define MYTHON_OPCODE_NAME(name) string_view(#name),
+        MYTHON_OPCODES(MYTHON_OPCODE_NAME)
+#undef MYTHON_OPCODE_NAME
+    };
+    return NAMES[static_cast<size_t>(op)];
+}
+
+MethodCode::MethodCode(vector<Symbol> formal_params, unique_ptr<runtime::Executable> body)
+    : formal_params_(std::move(formal_params)), body_(std::move(body)) {
+}
+
+ObjectHolder MethodCode::Execute(Closure& closure, Context& context) {
+    Machine& machine = Machine::Current();
+    vector<ObjectHolder>& stack = machine.Stack();
+    const StackGuard guard(stack);
+    for (const Symbol param : formal_params_) {
+        stack.push_back(closure.at(param));
+    }
+    stack.push_back(closure.at(SELF));
+    return machine.Invoke(*this, guard.Size(), context);
+}
+
+ObjectHolder MethodCode::ExecuteMethod(const vector<Symbol>& formal_params, const ObjectHolder& self,
+                                       const ObjectHolder* actual_args, Context& context) {
+    Machine& machine = Machine::Current();
+    vector<ObjectHolder>& stack = machine.Stack();
+    const StackGuard guard(stack);
+    stack.insert(stack.end(), actual_args, actual_args + formal_params.size());
+    stack.push_back(self);
+    return machine.Invoke(*this, guard.Size(), context);
+}
+
+Code& MethodCode::GetCode() {
+    if (code_ == nullptr) {
+        ast::MethodBody& body = engine::ParsedBody(*body_);
+        const uint32_t slot_count = body.ResolveSlots(formal_params_);
+        auto code = make_unique<Code>();
+        Compiler(*code, static_cast<uint32_t>(formal_params_.size()), slot_count).CompileMethod(body.Body());
+        code_ = std::move(code);
+    }
+    return *code_;
+}
+
+Program::Program(ast::Program& program) {
+    Compiler(code_).CompileProgram(program.Body());
+}
+
+ObjectHolder Program::Execute(Closure& closure, Context& context) {
+    Machine& machine = Machine::Current();
+    const StackGuard guard(machine.Stack());
+    return machine.Run(code_, guard.Size(), &closure, context);
+}
+
+unique_ptr<Program> Compile(ast::Program& program) {
+    return make_unique<Program>(program);
+}
+
+}  // namespace vm
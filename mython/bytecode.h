@@ -0,0 +1,177 @@
+#pragma once
+
+#include "engine.h"
+#include "runtime.h"
+#include "statement.h"
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Компилятор дерева программы в байт-код и виртуальная машина, которая его выполняет.
+// Альтернатива обходу дерева (Statement::Execute): вывод и ошибки времени исполнения совпадают
+namespace vm {
+
+// Команды виртуальной машины. Машина работает со стеком значений, a и b - операнды команды:
+//   LOAD_CONST a          кладёт константу a
+//   LOAD_NONE             кладёт None
+//   LOAD_ARG a            кладёт значение ячейки a (параметр метода или self)
+//   LOAD_LOCAL a          кладёт значение ячейки a; если переменной ещё не присвоено значение,
+//                         выбрасывает ошибку, как чтение неизвестной переменной
+//   STORE_LOCAL a         снимает значение и записывает его в ячейку a
+//   LOAD_GLOBAL a         кладёт переменную верхнего уровня с именем names[a]
+//   STORE_GLOBAL a        снимает значение и записывает его в переменную верхнего уровня names[a]
+//   GET_FIELD a           заменяет объект на вершине значением его поля names[a]
+//   SET_FIELD a, b        снимает значение и объект и присваивает полю names[a] объекта значение;
+//                         при b != 0 кладёт значение обратно
+//   DUP, POP              дублирует и снимает вершину
+//   ADD ... NEG, NOT      арифметика и not над вершиной стека
+//   TO_BOOL               заменяет вершину результатом IsTrue
+//   EQUAL ... COMPARE a   снимают rhs и lhs и кладут результат сравнения; COMPARE вызывает
+//                         функцию comparators[a]
+//   JUMP a                переходит к команде a
+//   JUMP_IF_FALSE a       снимает значение и переходит к команде a, если оно ложно
+//   JUMP_IF_TRUE a        снимает значение и переходит к команде a, если оно истинно
+//   CALL a                вызывает метод calls[a] у объекта на вершине, под которым лежат
+//                         аргументы, и заменяет их результатом
+//   NEW a, b              если у класса instances[a] нет __init__ с нужным числом параметров,
+//                         кладёт объект и переходит к команде b (аргументы не вычисляются)
+//   INIT a                вызывает __init__ объекта instances[a] с аргументами со стека и кладёт
+//                         объект вместо них
+//   CLASS a               кладёт новый объект класса classes[a]
+//   STRINGIFY             заменяет вершину её строковым представлением
+//   PRINT b               снимает значение и выводит его, при b != 0 - с пробелом после
+//   NEWLINE               завершает строку вывода print
+//   RETURN                снимает значение и возвращает его из метода
+//   END                   завершает программу
+#define MYTHON_OPCODES(X) \
+    X(LOAD_CONST)         \
+    X(LOAD_NONE)          \
+    X(LOAD_ARG)           \
+    X(LOAD_LOCAL)         \
+    X(STORE_LOCAL)        \
+    X(LOAD_GLOBAL)        \
+    X(STORE_GLOBAL)       \
+    X(GET_FIELD)          \
+    X(SET_FIELD)          \
+    X(DUP)                \
+    X(POP)                \
+    X(ADD)                \
+    X(SUB)                \
+    X(MUL)                \
+    X(DIV)                \
+    X(NEG)                \
+    X(NOT)                \
+    X(TO_BOOL)            \
+    X(EQUAL)              \
+    X(NOT_EQUAL)          \
+    X(LESS)               \
+    X(GREATER)            \
+    X(LESS_OR_EQUAL)      \
+    X(GREATER_OR_EQUAL)   \
+    X(COMPARE)            \
+    X(JUMP)               \
+    X(JUMP_IF_FALSE)      \
+    X(JUMP_IF_TRUE)       \
+    X(CALL)               \
+    X(NEW)                \
+    X(INIT)               \
+    X(CLASS)              \
+    X(STRINGIFY)          \
+    X(PRINT)              \
+    X(NEWLINE)            \
+    X(RETURN)             \
+    X(END)
+
+enum class OpCode : std::uint8_t {
+#define MYTHON_OPCODE_ENUM(name) name,
+    MYTHON_OPCODES(MYTHON_OPCODE_ENUM)
+#undef MYTHON_OPCODE_ENUM
+};
+
+// Возвращает имя команды, например "LOAD_LOCAL"
+std::string_view OpCodeName(OpCode op);
+
+struct Instruction {
+    OpCode op;
+    std::uint32_t a = 0;
+    std::uint32_t b = 0;
+};
+
+class MethodCode;
+
+using CallSite = engine::CallSite<MethodCode>;
+
+// Место создания объекта: инструкция NewInstance возвращает при каждом выполнении один и тот же
+// объект, поэтому байт-код работает с объектом самой инструкции
+struct InstanceSite {
+    runtime::ClassInstance* instance;
+    runtime::ObjectHolder holder;
+    CallSite init;
+};
+
+// Байт-код программы или тела метода с таблицами операндов команд
+struct Code {
+    std::vector<Instruction> instructions;
+    std::vector<runtime::ObjectHolder> constants;
+    // Имена переменных верхнего уровня и полей
+    std::vector<runtime::Symbol> names;
+    std::vector<ast::Comparison::Comparator> comparators;
+    std::vector<CallSite> calls;
+    std::vector<InstanceSite> instances;
+    std::vector<const runtime::Class*> classes;
+    // Число параметров метода. В ячейках 0..argument_count-1 лежат параметры, в ячейке
+    // argument_count - self, дальше - локальные переменные
+    std::uint32_t argument_count = 0;
+    std::uint32_t slot_count = 0;
+};
+
+// Тело метода, исполняемое виртуальной машиной. Заменяет MethodBody и LazyMethodBody в классах
+// скомпилированной программы и компилирует исходное тело при первом вызове метода
+class MethodCode : public runtime::Executable {
+public:
+    MethodCode(std::vector<runtime::Symbol> formal_params, std::unique_ptr<runtime::Executable> body);
+
+    // Вызов, в котором self и параметры берутся из closure
+    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+    // Вызов из рантайма (print, str, сравнения, сложение): аргументы и self кладутся прямо
+    // в стек виртуальной машины, без Closure. actual_args не должны указывать в этот стек
+    runtime::ObjectHolder ExecuteMethod(const std::vector<runtime::Symbol>& formal_params,
+                                        const runtime::ObjectHolder& self, const runtime::ObjectHolder* actual_args,
+                                        runtime::Context& context) override;
+
+    // Компилирует тело, если оно ещё не скомпилировано. Отложенное тело при этом разбирается,
+    // ошибка разбора выбрасывается при каждом обращении
+    Code& GetCode();
+
+private:
+    std::vector<runtime::Symbol> formal_params_;
+    std::unique_ptr<runtime::Executable> body_;
+    std::unique_ptr<Code> code_;
+};
+
+// Программа, скомпилированная в байт-код. Переменные верхнего уровня хранятся в closure, как при
+// обходе дерева, локальные переменные методов - в ячейках стека виртуальной машины.
+// Тела методов классов программы заменяются на MethodCode, поэтому методы исполняются байт-кодом
+// и при вызове из рантайма. Дерево программы должно жить дольше скомпилированной программы,
+// а после компиляции его не следует оптимизировать
+class Program : public runtime::Executable {
+public:
+    explicit Program(ast::Program& program);
+
+    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+    [[nodiscard]] const Code& GetCode() const {
+        return code_;
+    }
+
+private:
+    Code code_;
+};
+
+// Компилирует программу program в байт-код
+std::unique_ptr<Program> Compile(ast::Program& program);
+
+}  // namespace vm
@@ -0,0 +1,305 @@
+#include "bytecode.h"
+#include "test_programs_p.h"
+#include "test_runner_p.h"
+
+#include <algorithm>
+#include <string>
+
+using namespace std;
+
+namespace vm {
+
+namespace {
+using test_programs::ParseText;
+using test_programs::Run;
+
+// Выполняет программу обходом дерева и байт-кодом, проверяет, что вывод совпадает, и возвращает его
+string RunBoth(const string& text) {
+    return test_programs::RunBoth(text, Compile);
+}
+
+// Возвращает байт-код метода method класса, объявленного на верхнем уровне
+Code& MethodCodeOf(ast::Program& program, string_view method) {
+    for (ast::Statement* statement : dynamic_cast<ast::Compound*>(program.Body())->Statements()) {
+        auto* definition = dynamic_cast<ast::ClassDefinition*>(statement);
+        if (definition == nullptr || definition->GetClass().GetMethod(method) == nullptr) {
+            continue;
+        }
+        auto* body = dynamic_cast<MethodCode*>(definition->GetClass().GetMethod(method)->body.get());
+        ASSERT(body != nullptr);
+        return body->GetCode();
+    }
+    throw runtime_error("No method "s + string(method));
+}
+
+bool Contains(const Code& code, OpCode op) {
+    return any_of(code.instructions.begin(), code.instructions.end(), [op](const Instruction& instruction) {
+        return instruction.op == op;
+    });
+}
+
+void TestRunsRecursion() {
+    ASSERT_EQUAL(RunBoth(R"(class Factorial:
+  def calc(n):
+    if n == 0:
+      return 1
+    return n * self.calc(n - 1)
+class Fib:
+  def calc(n):
+    if n < 2:
+      return n
+    return self.calc(n - 1) + self.calc(n - 2)
+fact = Factorial()
+fib = Fib()
+print fact.calc(10), fib.calc(15)
+)"s),
+                 "3628800 610\n"s);
+}
+
+void TestLocalsLiveInSlots() {
+    auto program = ParseText(R"(class Calc:
+  def f(a, b):
+    x = a + b
+    y = x * 2
+    return y - self.k
+  def __init__():
+    self.k = 1
+c = Calc()
+print c.f(2, 3)
+)"s);
+    auto* definition = dynamic_cast<ast::ClassDefinition*>(
+        dynamic_cast<ast::Compound*>(program->Body())->Statements().front());
+    auto* tree_body = dynamic_cast<ast::MethodBody*>(definition->GetClass().GetMethod("f"sv)->body.get());
+    auto compiled = Compile(*program);
+    ASSERT_EQUAL(Run(*compiled), "9\n"s);
+    // Ячейки назначены узлам тела, как при обходе дерева
+    ASSERT_EQUAL(tree_body->GetSlotCount(), 5U);
+
+    // a, b, self, x, y
+    const Code& f = MethodCodeOf(*program, "f"sv);
+    ASSERT_EQUAL(f.argument_count, 2U);
+    ASSERT_EQUAL(f.slot_count, 5U);
+    ASSERT(Contains(f, OpCode::LOAD_ARG));
+    ASSERT(Contains(f, OpCode::STORE_LOCAL));
+    ASSERT(Contains(f, OpCode::LOAD_LOCAL));
+    ASSERT(!Contains(f, OpCode::LOAD_GLOBAL));
+    // Переменные верхнего уровня по-прежнему хранятся по именам
+    ASSERT(Contains(compiled->GetCode(), OpCode::STORE_GLOBAL));
+    ASSERT_EQUAL(OpCodeName(OpCode::LOAD_LOCAL), "LOAD_LOCAL"sv);
+}
+
+void TestUnassignedLocals() {
+    ASSERT_EQUAL(RunBoth(R"(class C:
+  def f(c):
+    if c:
+      x = 1
+    return x
+  def g():
+    x = None
+    return x
+o = C()
+print o.g(), o.f(True)
+print o.f(False)
+)"s),
+                 "None 1\n<error: No such variable!>"s);
+}
+
+void TestGlobals() {
+    auto program = ParseText(R"(x = 'text'
+y = x
+class C:
+  def get():
+    return x
+c = C()
+z = c.get()
+)"s);
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    try {
+        Compile(*program)->Execute(closure, context);
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        // В методе видны только self и параметры
+        ASSERT_EQUAL(string(e.what()), "No such variable!"s);
+    }
+    ASSERT(closure.at("x"s).Get() == closure.at("y"s).Get());
+    ASSERT_EQUAL(closure.at("x"s).TryAs<runtime::String>()->GetValue(), "text"s);
+    ASSERT(closure.count("z"s) == 0);
+}
+
+void TestEvaluationOrder() {
+    ASSERT_EQUAL(RunBoth(R"(class Log:
+  def say(text):
+    print text
+    return text
+class Target:
+  def __init__(a):
+    print 'init', a
+  def call(a, b):
+    return a + b
+class NoInit:
+  def value():
+    return 1
+log = Log()
+t = Target(log.say('arg'))
+print log.say('first'), log.say('second')
+print t.call(log.say('a'), log.say('b'))
+# У NoInit нет __init__, поэтому аргумент не вычисляется
+n = NoInit(log.say('skipped'))
+print n.value()
+)"s),
+                 "arg\ninit arg\nfirst\nfirst second\nsecond\na\nb\nab\n1\n"s);
+}
+
+void TestNewInstanceReturnsSameObject() {
+    // Инструкция создания объекта при каждом выполнении возвращает один и тот же объект
+    ASSERT_EQUAL(RunBoth(R"(class Box:
+  def __init__(v):
+    self.v = v
+class Maker:
+  def make(v):
+    return Box(v)
+m = Maker()
+a = m.make(1)
+b = m.make(2)
+print a.v, b.v
+)"s),
+                 "2 2\n"s);
+}
+
+void TestMethodsCalledFromRuntime() {
+    auto program = ParseText(R"(class V:
+  def __init__(x):
+    self.x = x
+  def __str__():
+    return 'V(' + str(self.x) + ')'
+  def __eq__(other):
+    return self.x == other.x
+  def __lt__(other):
+    return self.x < other.x
+  def __add__(other):
+    return self.x + other.x
+class W(V):
+  def __str__():
+    return 'W' + str(self.x)
+a = V(1)
+b = W(2)
+print a, b, str(a), a + b
+print a == b, a != b, a < b, a > b, a <= b, a >= b
+)"s);
+    auto compiled = Compile(*program);
+    ASSERT_EQUAL(Run(*compiled), "V(1) W2 V(1) 3\nFalse True True False True False\n"s);
+    // print и сравнения вызывают методы через рантайм, и методы выполняются байт-кодом
+    ASSERT(Contains(MethodCodeOf(*program, "__str__"sv), OpCode::RETURN));
+    ASSERT(Contains(MethodCodeOf(*program, "__lt__"sv), OpCode::LESS));
+
+    // Методы, вызванные рантаймом напрямую, получают аргументы через стек исполнителя
+    runtime::DummyContext context;
+    runtime::Closure globals;
+    compiled->Execute(globals, context);
+    auto* a = globals.at("a"sv).TryAs<runtime::ClassInstance>();
+    ASSERT_EQUAL(a->Call("__add__"sv, {globals.at("b"sv)}, context).TryAs<runtime::Number>()->GetValue(), 3);
+    ASSERT(a->Call("__eq__"sv, {globals.at("a"sv)}, context).TryAs<runtime::Bool>()->GetValue());
+}
+
+void TestRuntimeErrors() {
+    ASSERT_EQUAL(RunBoth("print 1\nprint 2 / 0\n"s), "1\n<error: Zero division!>"s);
+    ASSERT_EQUAL(RunBoth("x = 'a' - 1\n"s), "<error: Wrong types!>"s);
+    ASSERT_EQUAL(RunBoth("x = None + None\n"s), "<error: Wrong types!>"s);
+    ASSERT_EQUAL(RunBoth("print missing\n"s), "<error: No such variable!>"s);
+    ASSERT_EQUAL(RunBoth(R"(class C:
+  def f():
+    return 1
+c = C()
+print c.f(1)
+)"s),
+                 "<error: There is no such method!>"s);
+    ASSERT_EQUAL(RunBoth(R"(class C:
+  def f():
+    return self.missing.x
+c = C()
+print c.f()
+)"s),
+                 "<error: No such variable!>"s);
+    // return вне метода завершает программу исключением
+    ASSERT_EQUAL(RunBoth("print 1\nreturn 2\nprint 3\n"s), "1\n<error: >"s);
+}
+
+void TestLogicalOperations() {
+    // print выводит каждый аргумент сразу после его вычисления
+    ASSERT_EQUAL(RunBoth(R"(class Log:
+  def say(value):
+    print 'say', value
+    return value
+l = Log()
+print l.say(0) or l.say('x'), l.say(1) or l.say(2)
+print l.say('') and l.say(3), l.say(True) and l.say(0)
+print not l.say(None), 1 < 2 and 'a' < 'b', not 1 == 1
+)"s),
+                 "say 0\nsay x\nTrue say 1\nTrue\nsay \nFalse say True\nsay 0\nFalse\nsay None\nTrue True False\n"s);
+}
+
+void TestClassesAndInheritance() {
+    ASSERT_EQUAL(RunBoth(R"(class Base:
+  def __init__(n):
+    self.n = n
+  def name():
+    return 'base'
+  def describe():
+    return self.name() + ' ' + str(self.n)
+class Derived(Base):
+  def name():
+    return 'derived'
+class Factory:
+  def make():
+    class Local:
+      def get():
+        return 42
+    l = Local()
+    return l.get()
+b = Base(1)
+d = Derived(2)
+print b.describe(), d.describe()
+f = Factory()
+print f.make()
+)"s),
+                 "base 1 derived 2\n42\n"s);
+}
+
+void TestLazyBodies() {
+    // Ошибка в теле метода выбрасывается при каждом вызове, тело неиспользуемого метода не разбирается
+    const string text = R"(class C:
+  def good():
+    return 'good'
+  def bad():
+    return +
+  def unused():
+    return *
+c = C()
+print c.good()
+print c.bad()
+)"s;
+    auto program = ParseText(text, BodyParsing::LAZY);
+    auto compiled = Compile(*program);
+    ASSERT_EQUAL(Run(*compiled).substr(0, 5), "good\n"s);
+    ASSERT_EQUAL(Run(*compiled).substr(0, 5), "good\n"s);
+    ASSERT(Run(*compiled).find("<error: "s) != string::npos);
+}
+
+}  // namespace
+
+void RunBytecodeTests(TestRunner& tr) {
+    RUN_TEST(tr, TestRunsRecursion);
+    RUN_TEST(tr, TestLocalsLiveInSlots);
+    RUN_TEST(tr, TestUnassignedLocals);
+    RUN_TEST(tr, TestGlobals);
+    RUN_TEST(tr, TestEvaluationOrder);
+    RUN_TEST(tr, TestNewInstanceReturnsSameObject);
+    RUN_TEST(tr, TestMethodsCalledFromRuntime);
+    RUN_TEST(tr, TestRuntimeErrors);
+    RUN_TEST(tr, TestLogicalOperations);
+    RUN_TEST(tr, TestClassesAndInheritance);
+    RUN_TEST(tr, TestLazyBodies);
+}
+
+}  // namespace vm
@@ -0,0 +1,545 @@
+#include "closure_compiler.h"
+#include "engine.h"
+#include "resolve.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace closure_compiler {
+
+using runtime::ClassInstance;
+using runtime::Closure;
+using runtime::Context;
+using runtime::Number;
+using runtime::ObjectHolder;
+using runtime::Symbol;
+
+using engine::StackGuard;
+using engine::ToBool;
+
+namespace {
+
+const Symbol INIT_METHOD = "__init__"sv;
+const Symbol SELF = "self"sv;
+
+using CallSite = engine::CallSite<MethodClosure>;
+
+// Стек ячеек методов. Он один на поток: методы, вызванные из рантайма (print, сравнения),
+// продолжают его
+vector<ObjectHolder>& Stack() {
+    thread_local vector<ObjectHolder> stack = [] {
+        vector<ObjectHolder> result;
+        result.reserve(1024);
+        return result;
+    }();
+    return stack;
+}
+
+// Выполняет метод, аргументы и self которого лежат в стеке начиная с позиции base.
+// Стек после возврата нужно сократить до base
+ObjectHolder Invoke(MethodClosure& method, vector<ObjectHolder>& stack, size_t base, Context& context) {
+    const MethodCode& code = method.GetCode();
+    stack.resize(base + code.slot_count, ast::UNASSIGNED);
+    Frame frame{nullptr, &stack, base, context, {}};
+    if (code.body(frame)) {
+        return std::move(frame.result);
+    }
+    return {};
+}
+
+// Вызывает метод site у instance. Аргументы лежат в стеке начиная с позиции base,
+// за ними - сам объект receiver
+ObjectHolder Call(CallSite& site, ClassInstance& instance, vector<ObjectHolder>& stack, size_t base,
+                  Context& context) {
+    site.Resolve(instance.GetClass());
+    if (site.target != nullptr) {
+        return Invoke(*site.target, stack, base, context);
+    }
+    const vector<ObjectHolder> args(stack.begin() + static_cast<ptrdiff_t>(base), stack.end() - 1);
+    return instance.Call(site.method, args, context);
+}
+
+const Number& AsNumber(const ObjectHolder& object) {
+    const auto* number = object.TryAs<Number>();
+    if (number == nullptr) {
+        throw runtime_error("Wrong types!"s);
+    }
+    return *number;
+}
+
+// Операции над числами. Деление на ноль проверяет вызывающий код
+struct SubOperation {
+    static int Apply(int lhs, int rhs) {
+        return lhs - rhs;
+    }
+};
+
+struct MultOperation {
+    static int Apply(int lhs, int rhs) {
+        return lhs * rhs;
+    }
+};
+
+struct DivOperation {
+    static int Apply(int lhs, int rhs) {
+        return lhs / rhs;
+    }
+};
+
+// Сравнения рантайма и соответствующие им сравнения чисел
+template <bool (*Function)(const ObjectHolder&, const ObjectHolder&, Context&), typename IntCompare>
+struct KnownComparison {
+    static bool Apply(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+        if (const auto* l = lhs.TryAs<Number>(), *r = rhs.TryAs<Number>(); l != nullptr && r != nullptr) {
+            return IntCompare{}(l->GetValue(), r->GetValue());
+        }
+        return Function(lhs, rhs, context);
+    }
+};
+
+class Compiler {
+public:
+    // Код верхнего уровня: переменные хранятся в closure программы
+    Compiler()
+        : code_(nullptr) {
+    }
+
+    // Тело метода: self, параметры и локальные переменные хранятся в ячейках, номера которых
+    // записаны в узлах тела (см. ast::MethodBody::ResolveSlots)
+    Compiler(MethodCode& code, uint32_t argument_count, uint32_t slot_count)
+        : code_(&code) {
+        code.argument_count = argument_count;
+        code.slot_count = slot_count;
+    }
+
+    Action CompileStatement(ast::Statement* node) {
+        if (auto* compound = dynamic_cast<ast::Compound*>(node)) {
+            return CompileCompound(*compound);
+        } else if (auto* print = dynamic_cast<ast::Print*>(node)) {
+            return CompilePrint(*print);
+        } else if (auto* if_else = dynamic_cast<ast::IfElse*>(node)) {
+            return CompileIfElse(*if_else);
+        } else if (auto* ret = dynamic_cast<ast::Return*>(node)) {
+            return CompileReturn(*ret);
+        }
+        // Значение выражения, использованного как инструкция, не нужно
+        return [expression = CompileExpression(node)](Frame& frame) {
+            expression(frame);
+            return false;
+        };
+    }
+
+private:
+    Action CompileCompound(ast::Compound& compound) {
+        vector<Action> actions;
+        for (ast::Statement* statement : compound.Statements()) {
+            actions.push_back(CompileStatement(statement));
+        }
+        if (actions.size() == 1) {
+            return std::move(actions.front());
+        }
+        return [actions = std::move(actions)](Frame& frame) {
+            for (const Action& action : actions) {
+                if (action(frame)) {
+                    return true;
+                }
+            }
+            return false;
+        };
+    }
+
+    // print выводит каждый аргумент сразу после его вычисления
+    Action CompilePrint(ast::Print& print) {
+        vector<Expression> args;
+        for (ast::Statement* arg : print.Args()) {
+            args.push_back(CompileExpression(arg));
+        }
+        return [args = std::move(args)](Frame& frame) {
+            ostream& out = frame.context.GetOutputStream();
+            for (size_t i = 0; i < args.size(); ++i) {
+                const ObjectHolder value = args[i](frame);
+                if (value) {
+                    value->Print(out, frame.context);
+                } else {
+                    out << "None"sv;
+                }
+                if (i + 1 < args.size()) {
+                    out.put(' ');
+                }
+            }
+            out.put('\n');
+            return false;
+        };
+    }
+
+    Action CompileIfElse(ast::IfElse& if_else) {
+        Expression condition = CompileExpression(if_else.Condition());
+        Action if_body = CompileStatement(if_else.IfBody());
+        if (if_else.ElseBody() == nullptr) {
+            return [condition = std::move(condition), if_body = std::move(if_body)](Frame& frame) {
+                return runtime::IsTrue(condition(frame)) && if_body(frame);
+            };
+        }
+        return [condition = std::move(condition), if_body = std::move(if_body),
+                else_body = CompileStatement(if_else.ElseBody())](Frame& frame) {
+            return runtime::IsTrue(condition(frame)) ? if_body(frame) : else_body(frame);
+        };
+    }
+
+    Action CompileReturn(ast::Return& ret) {
+        Expression value = CompileExpression(ret.Value());
+        if (code_ == nullptr) {
+            // return вне метода, как и при обходе дерева, выбрасывает исключение из программы
+            return [value = std::move(value)](Frame& frame) -> bool {
+                throw ast::ReturnException(value(frame));
+            };
+        }
+        return [value = std::move(value)](Frame& frame) {
+            frame.result = value(frame);
+            return true;
+        };
+    }
+
+    Expression CompileExpression(ast::Statement* node) {
+        if (const auto* number = dynamic_cast<ast::NumericConst*>(node)) {
+            return Constant(ObjectHolder::Own(Number(number->GetValue())));
+        } else if (const auto* boolean = dynamic_cast<ast::BoolConst*>(node)) {
+            return Constant(ToBool(boolean->GetValue().GetValue()));
+        } else if (const auto* str = dynamic_cast<ast::StringConst*>(node)) {
+            // Объект строки общий с константой дерева
+            return Constant(str->GetValue());
+        } else if (dynamic_cast<ast::None*>(node) != nullptr) {
+            return Constant({});
+        } else if (auto* variable = dynamic_cast<ast::VariableValue*>(node)) {
+            return CompileVariable(*variable);
+        } else if (auto* assignment = dynamic_cast<ast::Assignment*>(node)) {
+            return CompileAssignment(assignment->GetName(), assignment->GetSlot(),
+                                     CompileExpression(assignment->Value()));
+        } else if (auto* field_assignment = dynamic_cast<ast::FieldAssignment*>(node)) {
+            return CompileFieldAssignment(*field_assignment);
+        } else if (auto* call = dynamic_cast<ast::MethodCall*>(node)) {
+            return CompileMethodCall(*call);
+        } else if (auto* new_instance = dynamic_cast<ast::NewInstance*>(node)) {
+            return CompileNewInstance(*new_instance);
+        } else if (auto* stringify = dynamic_cast<ast::Stringify*>(node)) {
+            return [argument = CompileExpression(stringify->Argument())](Frame& frame) {
+                return engine::Stringify(argument(frame), frame.context);
+            };
+        } else if (auto* negate = dynamic_cast<ast::Negate*>(node)) {
+            return [argument = CompileExpression(negate->Argument())](Frame& frame) {
+                return ObjectHolder::Own(Number(-AsNumber(argument(frame)).GetValue()));
+            };
+        } else if (auto* negation = dynamic_cast<ast::Not*>(node)) {
+            return [argument = CompileExpression(negation->Argument())](Frame& frame) {
+                return ToBool(!runtime::IsTrue(argument(frame)));
+            };
+        } else if (auto* disjunction = dynamic_cast<ast::Or*>(node)) {
+            return [lhs = CompileExpression(disjunction->Lhs()),
+                    rhs = CompileExpression(disjunction->Rhs())](Frame& frame) {
+                return ToBool(runtime::IsTrue(lhs(frame)) || runtime::IsTrue(rhs(frame)));
+            };
+        } else if (auto* conjunction = dynamic_cast<ast::And*>(node)) {
+            return [lhs = CompileExpression(conjunction->Lhs()),
+                    rhs = CompileExpression(conjunction->Rhs())](Frame& frame) {
+                return ToBool(runtime::IsTrue(lhs(frame)) && runtime::IsTrue(rhs(frame)));
+            };
+        } else if (auto* comparison = dynamic_cast<ast::Comparison*>(node)) {
+            return CompileComparison(*comparison);
+        } else if (auto* add = dynamic_cast<ast::Add*>(node)) {
+            return CompileAdd(*add);
+        } else if (auto* sub = dynamic_cast<ast::Sub*>(node)) {
+            return CompileArithmetic<SubOperation>(*sub);
+        } else if (auto* mult = dynamic_cast<ast::Mult*>(node)) {
+            return CompileArithmetic<MultOperation>(*mult);
+        } else if (auto* div = dynamic_cast<ast::Div*>(node)) {
+            return CompileDiv(*div);
+        } else if (auto* definition = dynamic_cast<ast::ClassDefinition*>(node)) {
+            // Методы класса тоже будут выполняться замыканиями
+            runtime::Class& cls = definition->GetClass();
+            engine::WrapMethods<MethodClosure>(cls);
+            return CompileAssignment(cls.GetSymbol(), definition->GetSlot(), [&cls](Frame& /*frame*/) {
+                return ObjectHolder::Own(ClassInstance(cls));
+            });
+        }
+        throw invalid_argument("Statement cannot be compiled to closures"s);
+    }
+
+    static Expression Constant(ObjectHolder value) {
+        return [value = std::move(value)](Frame& /*frame*/) {
+            return value;
+        };
+    }
+
+    // Число, известное при компиляции
+    static const Number* ConstantNumber(ast::Statement* node) {
+        const auto* number = dynamic_cast<ast::NumericConst*>(node);
+        return number != nullptr ? &number->GetValue() : nullptr;
+    }
+
+    Expression CompileVariable(ast::VariableValue& variable) {
+        const auto& ids = variable.Ids();
+        Expression load = Load(ids.front(), variable.GetSlot());
+        if (ids.size() == 1) {
+            return load;
+        }
+        return [load = std::move(load), fields = vector<Symbol>(ids.begin() + 1, ids.end())](Frame& frame) {
+            ObjectHolder value = load(frame);
+            for (const Symbol field : fields) {
+                auto* instance = value.TryAs<ClassInstance>();
+                if (instance == nullptr) {
+                    throw runtime_error("No such variable!"s);
+                }
+                const auto it = instance->Fields().find(field);
+                if (it == instance->Fields().end()) {
+                    throw runtime_error("No such variable!"s);
+                }
+                // Объект может держать только value, поэтому значение копируется до замены
+                ObjectHolder next = it->second;
+                value = std::move(next);
+            }
+            return value;
+        };
+    }
+
+    // Переменные без ячейки (ast::NO_SLOT) - переменные верхнего уровня
+    Expression Load(Symbol name, uint32_t slot) {
+        if (slot == ast::NO_SLOT) {
+            return [name](Frame& frame) {
+                const auto it = frame.globals->find(name);
+                if (it == frame.globals->end()) {
+                    throw runtime_error("No such variable!"s);
+                }
+                return it->second;
+            };
+        }
+        if (slot <= code_->argument_count) {
+            // self и параметры получают значения при вызове, проверять их не нужно
+            return [slot](Frame& frame) {
+                return (*frame.stack)[frame.base + slot];
+            };
+        }
+        return [slot](Frame& frame) {
+            const ObjectHolder& value = (*frame.stack)[frame.base + slot];
+            if (ast::IsUnassigned(value)) {
+                throw runtime_error("No such variable!"s);
+            }
+            return value;
+        };
+    }
+
+    Expression CompileAssignment(Symbol name, uint32_t slot, Expression value) {
+        if (slot == ast::NO_SLOT) {
+            return [name, value = std::move(value)](Frame& frame) {
+                return (*frame.globals)[name] = value(frame);
+            };
+        }
+        return [slot, value = std::move(value)](Frame& frame) {
+            // Вычисление значения может расширить стек, поэтому ячейка берётся после него
+            ObjectHolder result = value(frame);
+            return (*frame.stack)[frame.base + slot] = std::move(result);
+        };
+    }
+
+    Expression CompileFieldAssignment(ast::FieldAssignment& assignment) {
+        return [object = CompileVariable(assignment.Object()), field = assignment.GetFieldName(),
+                value = CompileExpression(assignment.Value())](Frame& frame) {
+            const ObjectHolder target = object(frame);
+            ObjectHolder result = value(frame);
+            auto* instance = target.TryAs<ClassInstance>();
+            if (instance == nullptr) {
+                throw runtime_error("No such variable!"s);
+            }
+            return instance->Fields()[field] = std::move(result);
+        };
+    }
+
+    // Аргументы вычисляются раньше объекта и складываются в стек, за ними кладётся объект:
+    // так они сразу оказываются в ячейках вызываемого метода
+    Expression CompileMethodCall(ast::MethodCall& call) {
+        vector<Expression> args;
+        for (ast::Statement* arg : call.Args()) {
+            args.push_back(CompileExpression(arg));
+        }
+        return [args = std::move(args), object = CompileExpression(call.Object()),
+                site = CallSite{call.GetMethod(), static_cast<uint32_t>(call.Args().size())}](Frame& frame) mutable {
+            vector<ObjectHolder>& stack = *frame.stack;
+            const StackGuard guard(stack);
+            for (const Expression& arg : args) {
+                ObjectHolder value = arg(frame);
+                stack.push_back(std::move(value));
+            }
+            ObjectHolder receiver = object(frame);
+            auto* instance = receiver.TryAs<ClassInstance>();
+            if (instance == nullptr) {
+                throw runtime_error("There is no such method!"s);
+            }
+            stack.push_back(std::move(receiver));
+            return Call(site, *instance, stack, guard.Size(), frame.context);
+        };
+    }
+
+    // Инструкция NewInstance возвращает при каждом выполнении один и тот же объект.
+    // Аргументы вычисляются, только если у класса есть подходящий __init__
+    Expression CompileNewInstance(ast::NewInstance& new_instance) {
+        ClassInstance& instance = new_instance.Instance();
+        vector<Expression> args;
+        for (ast::Statement* arg : new_instance.Args()) {
+            args.push_back(CompileExpression(arg));
+        }
+        return [&instance, holder = ObjectHolder::Share(instance), args = std::move(args),
+                site = CallSite{INIT_METHOD, static_cast<uint32_t>(new_instance.Args().size())}](Frame& frame) mutable {
+            if (instance.HasMethod(INIT_METHOD, site.argument_count)) {
+                vector<ObjectHolder>& stack = *frame.stack;
+                const StackGuard guard(stack);
+                for (const Expression& arg : args) {
+                    ObjectHolder value = arg(frame);
+                    stack.push_back(std::move(value));
+                }
+                stack.push_back(holder);
+                Call(site, instance, stack, guard.Size(), frame.context);
+            }
+            return holder;
+        };
+    }
+
+    Expression CompileComparison(ast::Comparison& comparison) {
+        const ast::Comparison::Comparator comparator = comparison.GetComparator();
+        if (comparator == &runtime::Equal) {
+            return CompileKnownComparison<KnownComparison<runtime::Equal, equal_to<int>>>(comparison);
+        } else if (comparator == &runtime::NotEqual) {
+            return CompileKnownComparison<KnownComparison<runtime::NotEqual, not_equal_to<int>>>(comparison);
+        } else if (comparator == &runtime::Less) {
+            return CompileKnownComparison<KnownComparison<runtime::Less, less<int>>>(comparison);
+        } else if (comparator == &runtime::Greater) {
+            return CompileKnownComparison<KnownComparison<runtime::Greater, greater<int>>>(comparison);
+        } else if (comparator == &runtime::LessOrEqual) {
+            return CompileKnownComparison<KnownComparison<runtime::LessOrEqual, less_equal<int>>>(comparison);
+        } else if (comparator == &runtime::GreaterOrEqual) {
+            return CompileKnownComparison<KnownComparison<runtime::GreaterOrEqual, greater_equal<int>>>(comparison);
+        }
+        return [comparator, lhs = CompileExpression(comparison.Lhs()),
+                rhs = CompileExpression(comparison.Rhs())](Frame& frame) {
+            const ObjectHolder l = lhs(frame);
+            const ObjectHolder r = rhs(frame);
+            return ToBool(comparator(l, r, frame.context));
+        };
+    }
+
+    template <typename Comparison>
+    Expression CompileKnownComparison(ast::Comparison& comparison) {
+        return [lhs = CompileExpression(comparison.Lhs()), rhs = CompileExpression(comparison.Rhs())](Frame& frame) {
+            const ObjectHolder l = lhs(frame);
+            const ObjectHolder r = rhs(frame);
+            return ToBool(Comparison::Apply(l, r, frame.context));
+        };
+    }
+
+    // Если правый аргумент - числовая константа, её тип проверять не нужно
+    Expression CompileAdd(ast::Add& add) {
+        Expression lhs = CompileExpression(add.Lhs());
+        if (ConstantNumber(add.Rhs()) != nullptr) {
+            return [lhs = std::move(lhs), rhs = ConstantNumber(add.Rhs())->GetValue(),
+                    rhs_holder = ObjectHolder::Own(Number(ConstantNumber(add.Rhs())->GetValue()))](Frame& frame) {
+                const ObjectHolder l = lhs(frame);
+                if (const auto* number = l.TryAs<Number>()) {
+                    return ObjectHolder::Own(Number(number->GetValue() + rhs));
+                }
+                return engine::AddObjects(l, rhs_holder, frame.context);
+            };
+        }
+        return [lhs = std::move(lhs), rhs = CompileExpression(add.Rhs())](Frame& frame) {
+            const ObjectHolder l = lhs(frame);
+            const ObjectHolder r = rhs(frame);
+            return engine::AddObjects(l, r, frame.context);
+        };
+    }
+
+    template <typename Operation>
+    Expression CompileArithmetic(ast::BinaryOperation& operation) {
+        Expression lhs = CompileExpression(operation.Lhs());
+        if (const Number* rhs = ConstantNumber(operation.Rhs())) {
+            return [lhs = std::move(lhs), rhs = rhs->GetValue()](Frame& frame) {
+                return ObjectHolder::Own(Number(Operation::Apply(AsNumber(lhs(frame)).GetValue(), rhs)));
+            };
+        }
+        return [lhs = std::move(lhs), rhs = CompileExpression(operation.Rhs())](Frame& frame) {
+            const ObjectHolder l = lhs(frame);
+            const ObjectHolder r = rhs(frame);
+            return ObjectHolder::Own(Number(Operation::Apply(AsNumber(l).GetValue(), AsNumber(r).GetValue())));
+        };
+    }
+
+    // Деление на ненулевую константу не проверяет делитель
+    Expression CompileDiv(ast::Div& div) {
+        if (const Number* rhs = ConstantNumber(div.Rhs()); rhs != nullptr && rhs->GetValue() != 0) {
+            return CompileArithmetic<DivOperation>(div);
+        }
+        return [lhs = CompileExpression(div.Lhs()), rhs = CompileExpression(div.Rhs())](Frame& frame) {
+            const ObjectHolder l = lhs(frame);
+            const ObjectHolder r = rhs(frame);
+            const int dividend = AsNumber(l).GetValue();
+            const int divisor = AsNumber(r).GetValue();
+            if (divisor == 0) {
+                throw runtime_error("Zero division!"s);
+            }
+            return ObjectHolder::Own(Number(dividend / divisor));
+        };
+    }
+
+    // Тело метода или nullptr для кода верхнего уровня
+    MethodCode* code_;
+};
+
+}  // namespace
+
+MethodClosure::MethodClosure(vector<Symbol> formal_params, unique_ptr<runtime::Executable> body)
+    : formal_params_(std::move(formal_params)), body_(std::move(body)) {
+}
+
+ObjectHolder MethodClosure::Execute(Closure& closure, Context& context) {
+    vector<ObjectHolder>& stack = Stack();
+    const StackGuard guard(stack);
+    for (const Symbol param : formal_params_) {
+        stack.push_back(closure.at(param));
+    }
+    stack.push_back(closure.at(SELF));
+    return Invoke(*this, stack, guard.Size(), context);
+}
+
+ObjectHolder MethodClosure::ExecuteMethod(const vector<Symbol>& formal_params, const ObjectHolder& self,
+                                          const ObjectHolder* actual_args, Context& context) {
+    vector<ObjectHolder>& stack = Stack();
+    const StackGuard guard(stack);
+    stack.insert(stack.end(), actual_args, actual_args + formal_params.size());
+    stack.push_back(self);
+    return Invoke(*this, stack, guard.Size(), context);
+}
+
+const MethodCode& MethodClosure::GetCode() {
+    if (code_ == nullptr) {
+        ast::MethodBody& body = engine::ParsedBody(*body_);
+        const uint32_t slot_count = body.ResolveSlots(formal_params_);
+        auto code = make_unique<MethodCode>();
+        code->body = Compiler(*code, static_cast<uint32_t>(formal_params_.size()), slot_count)
+                         .CompileStatement(body.Body());
+        code_ = std::move(code);
+    }
+    return *code_;
+}
+
+Program::Program(ast::Program& program)
+    : body_(Compiler().CompileStatement(program.Body())) {
+}
+
+ObjectHolder Program::Execute(Closure& closure, Context& context) {
+    Frame frame{&closure, &Stack(), 0, context, {}};
+    body_(frame);
+    return {};
+}
+
+unique_ptr<Program> Compile(ast::Program& program) {
+    return make_unique<Program>(program);
+}
+
+}  // namespace closure_compiler
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "runtime.h"
+#include "statement.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Компиляция дерева программы в замыкания: каждый узел один раз превращается в функцию C++,
+// в которую уже подставлены дочерние функции, константы и вид операции. Альтернатива обходу
+// дерева (Statement::Execute) и байт-коду (vm::Program): вывод и ошибки времени исполнения совпадают
+namespace closure_compiler {
+
+// Состояние выполняемого кода. Переменные верхнего уровня хранятся в globals, как при обходе
+// дерева, параметры, self и локальные переменные метода - в ячейках стека stack начиная с base
+struct Frame {
+    runtime::Closure* globals;
+    std::vector<runtime::ObjectHolder>* stack;
+    std::size_t base;
+    runtime::Context& context;
+    // Значение, возвращённое инструкцией return метода
+    runtime::ObjectHolder result;
+};
+
+// Вычисляет выражение
+using Expression = std::function<runtime::ObjectHolder(Frame&)>;
+// Выполняет инструкцию. Возвращает true, если выполнилась инструкция return: её значение
+// записано в Frame::result, и остаток тела метода пропускается
+using Action = std::function<bool(Frame&)>;
+
+// Скомпилированное тело метода. В ячейках 0..argument_count-1 лежат параметры, в ячейке
+// argument_count - self, дальше - локальные переменные
+struct MethodCode {
+    Action body;
+    std::uint32_t argument_count = 0;
+    std::uint32_t slot_count = 0;
+};
+
+// Тело метода, скомпилированное в замыкания. Заменяет MethodBody и LazyMethodBody в классах
+// скомпилированной программы и компилирует исходное тело при первом вызове метода
+class MethodClosure : public runtime::Executable {
+public:
+    MethodClosure(std::vector<runtime::Symbol> formal_params, std::unique_ptr<runtime::Executable> body);
+
+    // Вызов, в котором self и параметры берутся из closure
+    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+    // Вызов из рантайма (print, str, сравнения, сложение): аргументы и self кладутся прямо
+    // в стек ячеек методов, без Closure. actual_args не должны указывать в этот стек
+    runtime::ObjectHolder ExecuteMethod(const std::vector<runtime::Symbol>& formal_params,
+                                        const runtime::ObjectHolder& self, const runtime::ObjectHolder* actual_args,
+                                        runtime::Context& context) override;
+
+    // Компилирует тело, если оно ещё не скомпилировано. Отложенное тело при этом разбирается,
+    // ошибка разбора выбрасывается при каждом обращении
+    const MethodCode& GetCode();
+
+private:
+    std::vector<runtime::Symbol> formal_params_;
+    std::unique_ptr<runtime::Executable> body_;
+    std::unique_ptr<MethodCode> code_;
+};
+
+// Программа, скомпилированная в замыкания. Тела методов классов программы заменяются на
+// MethodClosure, поэтому методы выполняются замыканиями и при вызове из рантайма.
+// Дерево программы должно жить дольше скомпилированной программы, а после компиляции его
+// не следует оптимизировать
+class Program : public runtime::Executable {
+public:
+    explicit Program(ast::Program& program);
+
+    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+private:
+    Action body_;
+};
+
+// Компилирует программу program в замыкания
+std::unique_ptr<Program> Compile(ast::Program& program);
+
+}  // namespace closure_compiler
@@ -0,0 +1,387 @@
+#include "dataflow.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std;
+
+namespace ast {
+
+namespace {
+
+const runtime::Symbol SELF = "self"sv;
+// Цепочки короче этой читаются быстрее, чем сохраняются во временную переменную
+constexpr size_t MIN_REUSED_CHAIN = 3;
+
+bool SameConstant(const Statement* lhs, const Statement* rhs) {
+    if (lhs == rhs) {
+        return true;
+    }
+    if (const auto* number = dynamic_cast<const NumericConst*>(lhs)) {
+        const auto* other = dynamic_cast<const NumericConst*>(rhs);
+        return other != nullptr && number->GetValue().GetValue() == other->GetValue().GetValue();
+    }
+    if (const auto* boolean = dynamic_cast<const BoolConst*>(lhs)) {
+        const auto* other = dynamic_cast<const BoolConst*>(rhs);
+        return other != nullptr && boolean->GetValue().GetValue() == other->GetValue().GetValue();
+    }
+    if (const auto* str = dynamic_cast<const StringConst*>(lhs)) {
+        const auto* other = dynamic_cast<const StringConst*>(rhs);
+        return other != nullptr
+               && str->GetValue().TryAs<runtime::String>()->GetValue()
+                      == other->GetValue().TryAs<runtime::String>()->GetValue();
+    }
+    return dynamic_cast<const None*>(lhs) != nullptr && dynamic_cast<const None*>(rhs) != nullptr;
+}
+
+// Что известно о значении локальной переменной
+struct LocalValue {
+    // Присвоенная переменной константа или nullptr
+    Statement* constant = nullptr;
+    // Если constant равен nullptr - переменная, значение которой присвоено этой переменной
+    runtime::Symbol copy_of;
+
+    bool operator==(const LocalValue& other) const {
+        if (constant != nullptr || other.constant != nullptr) {
+            return constant != nullptr && other.constant != nullptr && SameConstant(constant, other.constant);
+        }
+        return copy_of == other.copy_of;
+    }
+};
+
+struct LocalState {
+    unordered_map<runtime::Symbol, LocalValue> values;
+    // Ложь после return: следующие инструкции не выполняются, и их состояние не влияет на
+    // состояние после ветвления
+    bool reachable = true;
+};
+
+LocalState Meet(LocalState lhs, const LocalState& rhs) {
+    if (!lhs.reachable) {
+        return rhs;
+    }
+    if (!rhs.reachable) {
+        return lhs;
+    }
+    for (auto it = lhs.values.begin(); it != lhs.values.end();) {
+        const auto other = rhs.values.find(it->first);
+        if (other == rhs.values.end() || !(other->second == it->second)) {
+            it = lhs.values.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return lhs;
+}
+
+class LocalPropagation {
+public:
+    explicit LocalPropagation(const function<void(Statement*&)>& fold)
+        : fold_(fold) {
+    }
+
+    void Visit(Statement*& node, LocalState& state) {
+        if (auto* variable = dynamic_cast<VariableValue*>(node)) {
+            Statement* constant = Resolve(*variable, state);
+            if (constant != nullptr && variable->Ids().size() == 1) {
+                node = constant;
+            }
+        } else if (auto* assignment = dynamic_cast<Assignment*>(node)) {
+            Visit(assignment->Value(), state);
+            fold_(assignment->Value());
+            Assign(assignment->GetName(), assignment->Value(), state);
+        } else if (auto* field_assignment = dynamic_cast<FieldAssignment*>(node)) {
+            Resolve(field_assignment->Object(), state);
+            Visit(field_assignment->Value(), state);
+        } else if (auto* if_else = dynamic_cast<IfElse*>(node)) {
+            Visit(if_else->Condition(), state);
+            LocalState else_state = state;
+            Visit(if_else->IfBody(), state);
+            if (if_else->ElseBody() != nullptr) {
+                Visit(if_else->ElseBody(), else_state);
+            }
+            state = Meet(std::move(state), else_state);
+        } else if (auto* ret = dynamic_cast<Return*>(node)) {
+            Visit(ret->Value(), state);
+            state.reachable = false;
+        } else {
+            ForEachChild(node, [this, &state](Statement*& child) {
+                Visit(child, state);
+            });
+        }
+    }
+
+private:
+    // Если переменная - копия другой, заменяет её в узле исходной, поэтому цепочка полей y.a
+    // после y = x читается как x.a. Возвращает присвоенную переменной константу или nullptr
+    static Statement* Resolve(VariableValue& variable, const LocalState& state) {
+        auto& ids = variable.Ids();
+        const auto it = state.values.find(ids.front());
+        if (it == state.values.end()) {
+            return nullptr;
+        }
+        if (it->second.constant == nullptr) {
+            ids.front() = it->second.copy_of;
+        }
+        return it->second.constant;
+    }
+
+    static void Assign(runtime::Symbol name, Statement* value, LocalState& state) {
+        state.values.erase(name);
+        for (auto it = state.values.begin(); it != state.values.end();) {
+            if (it->second.constant == nullptr && it->second.copy_of == name) {
+                it = state.values.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (IsConstant(value)) {
+            state.values[name] = {value, {}};
+        } else if (auto* variable = dynamic_cast<VariableValue*>(value);
+                   variable != nullptr && variable->Ids().size() == 1 && variable->Ids().front() != name) {
+            state.values[name] = {nullptr, variable->Ids().front()};
+        }
+    }
+
+    const function<void(Statement*&)>& fold_;
+};
+
+using LiveSet = unordered_set<runtime::Symbol>;
+
+// Добавляет в live переменные, которые читает node
+void AddReads(Statement* node, LiveSet& live) {
+    if (auto* variable = dynamic_cast<VariableValue*>(node)) {
+        live.insert(variable->Ids().front());
+        return;
+    }
+    if (auto* field_assignment = dynamic_cast<FieldAssignment*>(node)) {
+        live.insert(field_assignment->Object().Ids().front());
+    }
+    ForEachChild(node, [&live](Statement*& child) {
+        AddReads(child, live);
+    });
+}
+
+class DeadStoreElimination {
+public:
+    DeadStoreElimination(const vector<runtime::Symbol>& params, Arena& arena)
+        : params_(params.begin(), params.end()), arena_(arena) {
+        params_.insert(SELF);
+    }
+
+    // Превращает live из множества переменных, которые читаются после node, в множество
+    // переменных, которые читаются начиная с node. Если node нужно удалить, записывает в него nullptr
+    void Visit(Statement*& node, LiveSet& live) {
+        if (auto* compound = dynamic_cast<Compound*>(node)) {
+            auto& statements = compound->Statements();
+            const auto ret = find_if(statements.begin(), statements.end(), [](Statement* statement) {
+                return dynamic_cast<Return*>(statement) != nullptr;
+            });
+            if (ret != statements.end()) {
+                statements.erase(next(ret), statements.end());
+            }
+            for (auto it = statements.rbegin(); it != statements.rend(); ++it) {
+                Visit(*it, live);
+            }
+            statements.erase(remove(statements.begin(), statements.end(), nullptr), statements.end());
+        } else if (auto* assignment = dynamic_cast<Assignment*>(node)) {
+            Statement* value = assignment->Value();
+            if (live.erase(assignment->GetName()) == 0) {
+                node = IsPure(value) ? nullptr : value;
+            }
+            if (node != nullptr) {
+                AddReads(value, live);
+            }
+        } else if (auto* if_else = dynamic_cast<IfElse*>(node)) {
+            LiveSet else_live = live;
+            VisitBranch(if_else->IfBody(), live);
+            if (if_else->ElseBody() != nullptr) {
+                VisitBranch(if_else->ElseBody(), else_live);
+            }
+            live.insert(else_live.begin(), else_live.end());
+            AddReads(if_else->Condition(), live);
+        } else if (auto* ret = dynamic_cast<Return*>(node)) {
+            live.clear();
+            AddReads(ret->Value(), live);
+        } else {
+            AddReads(node, live);
+        }
+    }
+
+private:
+    void VisitBranch(Statement*& body, LiveSet& live) {
+        Visit(body, live);
+        if (body == nullptr) {
+            body = arena_.Make<Compound>();
+        }
+    }
+
+    // Вычисление value ничего не делает и не завершается ошибкой
+    bool IsPure(Statement* value) const {
+        if (IsConstant(value)) {
+            return true;
+        }
+        // Параметры и self заданы в замыкании с начала вызова
+        auto* variable = dynamic_cast<VariableValue*>(value);
+        return variable != nullptr && variable->Ids().size() == 1 && params_.count(variable->Ids().front()) > 0;
+    }
+
+    LiveSet params_;
+    Arena& arena_;
+};
+
+// Прочитанные цепочки полей: текст цепочки и место в дереве, где она прочитана первой
+using ReadChains = unordered_map<string, Statement**>;
+
+string ChainKey(const pmr::vector<runtime::Symbol>& ids) {
+    string key;
+    for (const runtime::Symbol id : ids) {
+        if (!key.empty()) {
+            key += '.';
+        }
+        key += id.Name();
+    }
+    return key;
+}
+
+// Оставляет в chains только цепочки, которые прочитаны там же и в other
+void Intersect(ReadChains& chains, const ReadChains& other) {
+    for (auto it = chains.begin(); it != chains.end();) {
+        const auto found = other.find(it->first);
+        if (found == other.end() || found->second != it->second) {
+            it = chains.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Может ли вычисление node, помимо вычисления дочерних узлов, вызвать метод пользователя
+bool MayCallUserCode(Statement* node) {
+    return dynamic_cast<MethodCall*>(node) != nullptr || dynamic_cast<Add*>(node) != nullptr
+           || dynamic_cast<Comparison*>(node) != nullptr || dynamic_cast<Stringify*>(node) != nullptr;
+}
+
+class FieldReadReuse {
+public:
+    explicit FieldReadReuse(Arena& arena)
+        : arena_(arena) {
+    }
+
+    void Visit(Statement*& node, ReadChains& chains) {
+        if (auto* variable = dynamic_cast<VariableValue*>(node)) {
+            if (variable->Ids().size() >= MIN_REUSED_CHAIN) {
+                Reuse(node, *variable, chains);
+            }
+        } else if (auto* assignment = dynamic_cast<Assignment*>(node)) {
+            Visit(assignment->Value(), chains);
+            Forget(chains, [name = assignment->GetName()](const pmr::vector<runtime::Symbol>& ids) {
+                return ids.front() == name;
+            });
+        } else if (auto* field_assignment = dynamic_cast<FieldAssignment*>(node)) {
+            Visit(field_assignment->Value(), chains);
+            Forget(chains, [field = field_assignment->GetFieldName()](const pmr::vector<runtime::Symbol>& ids) {
+                return find(next(ids.begin()), ids.end(), field) != ids.end();
+            });
+        } else if (auto* if_else = dynamic_cast<IfElse*>(node)) {
+            Visit(if_else->Condition(), chains);
+            ReadChains else_chains = chains;
+            Visit(if_else->IfBody(), chains);
+            if (if_else->ElseBody() != nullptr) {
+                Visit(if_else->ElseBody(), else_chains);
+            }
+            Intersect(chains, else_chains);
+        } else if (dynamic_cast<Or*>(node) != nullptr || dynamic_cast<And*>(node) != nullptr) {
+            // Правый аргумент вычисляется не всегда
+            auto* binary = static_cast<BinaryOperation*>(node);
+            Visit(binary->Lhs(), chains);
+            ReadChains rhs_chains = chains;
+            Visit(binary->Rhs(), rhs_chains);
+            Intersect(chains, rhs_chains);
+        } else if (auto* new_instance = dynamic_cast<NewInstance*>(node)) {
+            // Аргументы вычисляются, только если у класса есть подходящий __init__, который
+            // затем вызывается
+            ReadChains args_chains = chains;
+            for (Statement*& arg : new_instance->Args()) {
+                Visit(arg, args_chains);
+            }
+            chains.clear();
+        } else if (auto* print = dynamic_cast<Print*>(node)) {
+            // Каждый аргумент выводится сразу после вычисления и может вызвать __str__
+            for (Statement*& arg : print->Args()) {
+                Visit(arg, chains);
+                chains.clear();
+            }
+        } else {
+            ForEachChild(node, [this, &chains](Statement*& child) {
+                Visit(child, chains);
+            });
+            if (MayCallUserCode(node)) {
+                chains.clear();
+            }
+        }
+    }
+
+private:
+    void Reuse(Statement*& node, VariableValue& variable, ReadChains& chains) {
+        string key = ChainKey(variable.Ids());
+        const auto it = chains.find(key);
+        if (it == chains.end()) {
+            chains.emplace(std::move(key), &node);
+            return;
+        }
+        // Временная переменная не совпадёт с переменными программы: лексер не выдаёт имён с '$'
+        const runtime::Symbol temp = "$"s + key;
+        Statement*& first = *it->second;
+        if (dynamic_cast<VariableValue*>(first) != nullptr) {
+            first = arena_.Make<Assignment>(temp, first);
+        }
+        node = arena_.Make<VariableValue>(arena_.MakeVector(vector<runtime::Symbol>{temp}));
+    }
+
+    template <typename Predicate>
+    void Forget(ReadChains& chains, Predicate changes) {
+        for (auto it = chains.begin(); it != chains.end();) {
+            Statement* first = *it->second;
+            // Первое чтение могло уже стать присваиванием временной переменной
+            if (auto* assignment = dynamic_cast<Assignment*>(first)) {
+                first = assignment->Value();
+            }
+            if (changes(static_cast<VariableValue*>(first)->Ids())) {
+                it = chains.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    Arena& arena_;
+};
+
+}  // namespace
+
+bool IsConstant(const Statement* node) {
+    return dynamic_cast<const NumericConst*>(node) != nullptr || dynamic_cast<const BoolConst*>(node) != nullptr
+           || dynamic_cast<const StringConst*>(node) != nullptr || dynamic_cast<const None*>(node) != nullptr;
+}
+
+void PropagateLocals(Statement*& body, const function<void(Statement*&)>& fold) {
+    LocalState state;
+    LocalPropagation(fold).Visit(body, state);
+}
+
+void RemoveDeadStores(Statement*& body, const vector<runtime::Symbol>& params, Arena& arena) {
+    // После тела метода его локальные переменные не читаются
+    LiveSet live;
+    DeadStoreElimination(params, arena).Visit(body, live);
+}
+
+void ReuseFieldReads(Statement*& body, Arena& arena) {
+    ReadChains chains;
+    FieldReadReuse(arena).Visit(body, chains);
+}
+
+}  // namespace ast
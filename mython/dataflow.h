@@ -0,0 +1,35 @@
+#pragma once
+
+#include "statement.h"
+
+#include <functional>
+#include <vector>
+
+// Оптимизации потока данных внутри тела метода. Локальные переменные метода живут в замыкании
+// одного вызова и не видны ни вызываемым методам, ни вызывающему, поэтому тело метода можно
+// анализировать целиком: в языке нет циклов, и управление ветвится только в if/else и return.
+// body - корневая инструкция тела метода (то, что лежит внутри MethodBody). Новые узлы
+// создаются в arena
+namespace ast {
+
+// Истина, если node - константа: число, логическое значение, строка или None
+bool IsConstant(const Statement* node);
+
+// Подставляет вместо чтения локальной переменной присвоенную ей константу, а вместо переменной,
+// которой присвоена другая переменная, - исходную переменную, пока ни одна из них не
+// переприсвоена. Константы и копии проходят через ветви if/else, если совпадают в обеих.
+// fold упрощает присваиваемое выражение после подстановки, чтобы y = x * 3 после x = 2 тоже
+// стало константой
+void PropagateLocals(Statement*& body, const std::function<void(Statement*&)>& fold);
+
+// Удаляет присваивания локальным переменным, значение которых дальше не читается, и
+// инструкции после return. Если вычисление присваиваемого выражения может что-то сделать или
+// завершиться ошибкой, выражение остаётся на месте присваивания. params - параметры метода
+void RemoveDeadStores(Statement*& body, const std::vector<runtime::Symbol>& params, Arena& arena);
+
+// Повторные чтения одной цепочки полей, например self.a.b, берут значение первого чтения из
+// временной переменной, если между чтениями не вызывается код пользователя (методы, __str__,
+// __add__, сравнения) и не присваиваются поля с именами из цепочки
+void ReuseFieldReads(Statement*& body, Arena& arena);
+
+}  // namespace ast
@@ -0,0 +1,267 @@
+#include "optimize.h"
+#include "test_programs_p.h"
+#include "test_runner_p.h"
+
+#include <string>
+
+using namespace std;
+
+namespace ast {
+
+namespace {
+using test_programs::ParseText;
+using test_programs::Run;
+
+// Разбирает и оптимизирует программу, проверяя, что её вывод не изменился
+unique_ptr<Program> ParseAndOptimize(const string& text) {
+    const string expected = Run(*ParseText(text));
+    auto program = ParseText(text);
+    Optimize(*program);
+    ASSERT_EQUAL(Run(*program), expected);
+    return program;
+}
+
+// Возвращает инструкции тела метода method одного из классов, объявленных на верхнем уровне
+StatementList& MethodStatements(Program& program, string_view method) {
+    for (Statement* statement : dynamic_cast<Compound*>(program.Body())->Statements()) {
+        auto* definition = dynamic_cast<ClassDefinition*>(statement);
+        if (definition == nullptr || definition->GetClass().GetMethod(method) == nullptr) {
+            continue;
+        }
+        auto* body = dynamic_cast<MethodBody*>(definition->GetClass().GetMethod(method)->body.get());
+        ASSERT(body != nullptr);
+        auto* statements = dynamic_cast<Compound*>(body->Body());
+        ASSERT(statements != nullptr);
+        return statements->Statements();
+    }
+    throw runtime_error("No method "s + string(method));
+}
+
+// Возвращает выражение инструкции return
+Statement* ReturnedValue(Statement* statement) {
+    auto* ret = dynamic_cast<Return*>(statement);
+    ASSERT(ret != nullptr);
+    return ret->Value();
+}
+
+vector<string> Ids(Statement* statement) {
+    auto* variable = dynamic_cast<VariableValue*>(statement);
+    ASSERT(variable != nullptr);
+    vector<string> result;
+    for (const runtime::Symbol id : variable->Ids()) {
+        result.push_back(id.Name());
+    }
+    return result;
+}
+
+void TestPropagatesConstants() {
+    auto program = ParseAndOptimize(R"(class Calc:
+  def f():
+    x = 2
+    y = x * 3
+    z = 'a'
+    return str(y + 1) + z
+c = Calc()
+print c.f()
+)"s);
+
+    auto& statements = MethodStatements(*program, "f"sv);
+    ASSERT_EQUAL(statements.size(), 1U);
+    const auto* value = dynamic_cast<StringConst*>(ReturnedValue(statements[0]));
+    ASSERT(value != nullptr);
+    ASSERT_EQUAL(value->GetValue().TryAs<runtime::String>()->GetValue(), "7a"s);
+}
+
+void TestPropagatesCopies() {
+    auto program = ParseAndOptimize(R"(class Box:
+  def __init__():
+    self.v = 5
+class Calc:
+  def f(box):
+    b = box
+    c = b
+    return c.v
+  def g(box):
+    b = box
+    box = 1
+    return b.v + box
+c = Calc()
+print c.f(Box()), c.g(Box())
+)"s);
+
+    auto& f = MethodStatements(*program, "f"sv);
+    ASSERT_EQUAL(f.size(), 1U);
+    ASSERT_EQUAL(Ids(ReturnedValue(f[0])), (vector<string>{"box"s, "v"s}));
+
+    // После переприсваивания box переменная b уже не копия box
+    auto& g = MethodStatements(*program, "g"sv);
+    auto* sum = dynamic_cast<Add*>(ReturnedValue(g.back()));
+    ASSERT(sum != nullptr);
+    ASSERT_EQUAL(Ids(sum->Lhs()), (vector<string>{"b"s, "v"s}));
+    ASSERT(dynamic_cast<NumericConst*>(sum->Rhs()) != nullptr);
+}
+
+void TestPropagatesThroughBranches() {
+    auto program = ParseAndOptimize(R"(class Calc:
+  def same(c):
+    if c:
+      x = 1
+    else:
+      x = 1
+    return x
+  def different(c):
+    if c:
+      x = 1
+    else:
+      x = 2
+    return x
+  def early(c):
+    x = 1
+    if c:
+      x = 2
+      return x
+    return x
+c = Calc()
+print c.same(True), c.same(False), c.different(True), c.different(False), c.early(True), c.early(False)
+)"s);
+
+    ASSERT(dynamic_cast<NumericConst*>(ReturnedValue(MethodStatements(*program, "same"sv).back())) != nullptr);
+    ASSERT(dynamic_cast<VariableValue*>(ReturnedValue(MethodStatements(*program, "different"sv).back())) != nullptr);
+    // Ветка с return не влияет на значение x после ветвления
+    auto& early = MethodStatements(*program, "early"sv);
+    ASSERT_EQUAL(early.size(), 2U);
+    ASSERT(dynamic_cast<NumericConst*>(ReturnedValue(early.back())) != nullptr);
+}
+
+void TestRemovesDeadStores() {
+    auto program = ParseAndOptimize(R"(class Calc:
+  def noisy():
+    print 'noisy'
+    return 1
+  def f(a):
+    unused = a
+    x = self.noisy()
+    x = 2
+    return a
+    print 'unreachable'
+  def g():
+    x = missing
+    return 1
+c = Calc()
+print c.f(3)
+print c.g()
+)"s);
+
+    // Вызов метода остаётся ради вывода, присваивания и инструкции после return удалены
+    auto& f = MethodStatements(*program, "f"sv);
+    ASSERT_EQUAL(f.size(), 2U);
+    ASSERT(dynamic_cast<MethodCall*>(f[0]) != nullptr);
+    ASSERT(dynamic_cast<Return*>(f[1]) != nullptr);
+
+    // Чтение неизвестной переменной остаётся ради ошибки
+    auto& g = MethodStatements(*program, "g"sv);
+    ASSERT_EQUAL(g.size(), 2U);
+    ASSERT(dynamic_cast<VariableValue*>(g[0]) != nullptr);
+}
+
+void TestReusesFieldReads() {
+    auto program = ParseAndOptimize(R"(class Inner:
+  def __init__():
+    self.b = 1
+  def bump():
+    self.b = self.b + 10
+class Outer:
+  def __init__():
+    self.a = Inner()
+  def twice():
+    return self.a.b * self.a.b - self.a.b
+  def after_write():
+    x = self.a.b
+    self.a.b = x + 1
+    return self.a.b * self.a.b
+  def after_call():
+    x = self.a.b
+    self.a.bump()
+    return x * self.a.b
+  def in_branch(c):
+    if c:
+      x = self.a.b
+    return self.a.b * 2
+  def compare():
+    return self.a.b < self.a.b or self.a.b == self.a.b
+o = Outer()
+print o.twice(), o.after_write(), o.after_call(), o.in_branch(True), o.in_branch(False), o.compare()
+)"s);
+
+    auto* twice = dynamic_cast<Sub*>(ReturnedValue(MethodStatements(*program, "twice"sv).back()));
+    ASSERT(twice != nullptr);
+    auto* product = dynamic_cast<Mult*>(twice->Lhs());
+    ASSERT(product != nullptr);
+    ASSERT(dynamic_cast<Assignment*>(product->Lhs()) != nullptr);
+    ASSERT_EQUAL(Ids(product->Rhs()), vector<string>{"$self.a.b"s});
+    ASSERT_EQUAL(Ids(twice->Rhs()), vector<string>{"$self.a.b"s});
+
+    // Присваивание поля b и вызов метода могли изменить значение цепочки
+    auto* after_write = dynamic_cast<Mult*>(ReturnedValue(MethodStatements(*program, "after_write"sv).back()));
+    ASSERT(after_write != nullptr);
+    ASSERT(dynamic_cast<Assignment*>(after_write->Lhs()) != nullptr);
+    auto* after_call = dynamic_cast<Mult*>(ReturnedValue(MethodStatements(*program, "after_call"sv).back()));
+    ASSERT(after_call != nullptr);
+    ASSERT_EQUAL(Ids(after_call->Rhs()), (vector<string>{"self"s, "a"s, "b"s}));
+    // Чтение внутри ветки выполняется не всегда
+    auto* in_branch = dynamic_cast<Mult*>(ReturnedValue(MethodStatements(*program, "in_branch"sv).back()));
+    ASSERT(in_branch != nullptr);
+    ASSERT_EQUAL(Ids(in_branch->Lhs()), (vector<string>{"self"s, "a"s, "b"s}));
+}
+
+void TestOptimizedMethodsBehaveTheSame() {
+    ParseAndOptimize(R"(class Node:
+  def __init__(value, next):
+    self.value = value
+    self.next = next
+  def __str__():
+    return 'node ' + str(self.value)
+  def __eq__(other):
+    return self.value == other.value
+class List:
+  def __init__(head):
+    self.head = head
+  def sum3():
+    total = 0
+    node = self.head
+    total = total + node.value
+    node = node.next
+    total = total + node.value
+    n = node
+    node = n.next
+    if node.value > 2 and self.head.next.value > 1:
+      total = total + node.value
+    else:
+      total = total - 1
+    return total
+  def describe(prefix):
+    p = prefix
+    q = p + ':'
+    if self.head.next.next == self.head.next.next:
+      print q, self.head.next.next, self.head.next.next.value
+    self.head.next.next = Node(7, None)
+    return q + str(self.head.next.next.value)
+l = List(Node(1, Node(2, Node(3, None))))
+print l.sum3()
+print l.describe('list')
+print l.sum3()
+)"s);
+}
+
+}  // namespace
+
+void RunDataflowTests(TestRunner& tr) {
+    RUN_TEST(tr, TestPropagatesConstants);
+    RUN_TEST(tr, TestPropagatesCopies);
+    RUN_TEST(tr, TestPropagatesThroughBranches);
+    RUN_TEST(tr, TestRemovesDeadStores);
+    RUN_TEST(tr, TestReusesFieldReads);
+    RUN_TEST(tr, TestOptimizedMethodsBehaveTheSame);
+}
+
+}  // namespace ast
@@ -0,0 +1,60 @@
+#include "engine.h"
+
+#include <sstream>
+
+using namespace std;
+
+namespace engine {
+
+using runtime::ClassInstance;
+using runtime::Context;
+using runtime::Number;
+using runtime::ObjectHolder;
+
+namespace {
+
+const runtime::Symbol ADD_METHOD = "__add__"sv;
+const runtime::Symbol STR_METHOD = "__str__"sv;
+
+}  // namespace
+
+const ObjectHolder TRUE_VALUE = ObjectHolder::Own(runtime::Bool(true));
+const ObjectHolder FALSE_VALUE = ObjectHolder::Own(runtime::Bool(false));
+
+ObjectHolder Stringify(const ObjectHolder& object, Context& context) {
+    stringstream value;
+    if (auto* instance = object.TryAs<ClassInstance>()) {
+        if (instance->HasMethod(STR_METHOD, 0)) {
+            instance->Call(STR_METHOD, {}, context)->Print(value, context);
+        } else {
+            value << instance;
+        }
+    } else if (!object) {
+        value << "None"sv;
+    } else {
+        object->Print(value, context);
+    }
+    return ObjectHolder::Own(runtime::String(value.str()));
+}
+
+ObjectHolder AddObjects(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+    if (const auto* l = lhs.TryAs<Number>(), *r = rhs.TryAs<Number>(); l != nullptr && r != nullptr) {
+        return ObjectHolder::Own(Number(l->GetValue() + r->GetValue()));
+    }
+    if (const auto* l = lhs.TryAs<runtime::String>(), *r = rhs.TryAs<runtime::String>(); l != nullptr && r != nullptr) {
+        return ObjectHolder::Own(runtime::String(l->GetValue() + r->GetValue()));
+    }
+    if (auto* instance = lhs.TryAs<ClassInstance>(); instance != nullptr && instance->HasMethod(ADD_METHOD, 1)) {
+        return instance->Call(ADD_METHOD, &rhs, 1, context);
+    }
+    throw runtime_error("Wrong types!"s);
+}
+
+ast::MethodBody& ParsedBody(runtime::Executable& body) {
+    if (auto* lazy_body = dynamic_cast<ast::LazyMethodBody*>(&body)) {
+        return lazy_body->Parse();
+    }
+    return dynamic_cast<ast::MethodBody&>(body);
+}
+
+}  // namespace engine
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "runtime.h"
+#include "statement.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Общие части исполнителей, которые компилируют дерево программы: байт-кода (vm) и замыканий
+// (closure_compiler). Оба держат ячейки методов в стеке, одном на поток, и подменяют тела
+// методов классов своими, поэтому и методы, вызванные из рантайма, выполняются скомпилированными
+namespace engine {
+
+// Логические значения неизменяемы, поэтому результаты сравнений и логических операций разделяют
+// два объекта
+extern const runtime::ObjectHolder TRUE_VALUE;
+extern const runtime::ObjectHolder FALSE_VALUE;
+
+inline const runtime::ObjectHolder& ToBool(bool value) {
+    return value ? TRUE_VALUE : FALSE_VALUE;
+}
+
+// Строковое представление значения, как у ast::Stringify
+runtime::ObjectHolder Stringify(const runtime::ObjectHolder& object, runtime::Context& context);
+
+// Сумма чисел, соединение строк или результат __add__ объекта lhs, как у ast::Add
+runtime::ObjectHolder AddObjects(const runtime::ObjectHolder& lhs, const runtime::ObjectHolder& rhs,
+                                 runtime::Context& context);
+
+// Восстанавливает размер стека при выходе из вызова, в том числе по исключению
+class StackGuard {
+public:
+    explicit StackGuard(std::vector<runtime::ObjectHolder>& stack)
+        : stack_(stack), size_(stack.size()) {
+    }
+
+    StackGuard(const StackGuard&) = delete;
+    StackGuard& operator=(const StackGuard&) = delete;
+
+    ~StackGuard() {
+        stack_.resize(size_);
+    }
+
+    [[nodiscard]] std::size_t Size() const {
+        return size_;
+    }
+
+private:
+    std::vector<runtime::ObjectHolder>& stack_;
+    std::size_t size_;
+};
+
+// Место вызова метода. Запоминает класс последнего объекта и найденный у него метод, чтобы
+// при повторном вызове у объекта того же класса не искать метод заново
+template <typename Target>
+struct CallSite {
+    runtime::Symbol method;
+    std::uint32_t argument_count = 0;
+    const runtime::Class* cls = nullptr;
+    // Скомпилированное тело найденного метода или nullptr, если метод выполняется рантаймом
+    Target* target = nullptr;
+
+    // Ищет метод у класса object_class, если прошлый вызов был у объекта другого класса.
+    // Выбрасывает runtime_error, если у класса нет метода с таким числом параметров
+    void Resolve(const runtime::Class& object_class) {
+        if (cls == &object_class) {
+            return;
+        }
+        const runtime::Method* found = object_class.GetMethod(method);
+        if (found == nullptr || found->formal_params.size() != argument_count) {
+            throw std::runtime_error("There is no such method!");
+        }
+        cls = &object_class;
+        target = dynamic_cast<Target*>(found->body.get());
+    }
+};
+
+// Заменяет тела методов класса на Wrapper(formal_params, body). Тела, заменённые раньше,
+// и тела других типов не меняются
+template <typename Wrapper>
+void WrapMethods(runtime::Class& cls) {
+    for (runtime::Method& method : cls.GetMethods()) {
+        if (dynamic_cast<ast::MethodBody*>(method.body.get()) != nullptr
+            || dynamic_cast<ast::LazyMethodBody*>(method.body.get()) != nullptr) {
+            method.body = std::make_unique<Wrapper>(method.formal_params, std::move(method.body));
+        }
+    }
+}
+
+// Тело метода body (MethodBody или LazyMethodBody). Отложенное тело при этом разбирается,
+// ошибка разбора выбрасывается при каждом обращении
+ast::MethodBody& ParsedBody(runtime::Executable& body);
+
+}  // namespace engine
@@ -0,0 +1,103 @@
+#include "engine.h"
+#include "test_runner_p.h"
+
+#include <string>
+
+using namespace std;
+
+namespace engine {
+
+namespace {
+
+using runtime::ObjectHolder;
+
+class EmptyBody : public runtime::Executable {
+public:
+    ObjectHolder Execute(runtime::Closure& /*closure*/, runtime::Context& /*context*/) override {
+        return {};
+    }
+};
+
+// Обёртка тела метода, как MethodCode и MethodClosure
+class Wrapper : public runtime::Executable {
+public:
+    Wrapper(vector<runtime::Symbol> formal_params, unique_ptr<runtime::Executable> body)
+        : formal_params(std::move(formal_params)), body(std::move(body)) {
+    }
+
+    ObjectHolder Execute(runtime::Closure& /*closure*/, runtime::Context& /*context*/) override {
+        return {};
+    }
+
+    vector<runtime::Symbol> formal_params;
+    unique_ptr<runtime::Executable> body;
+};
+
+void TestValues() {
+    runtime::DummyContext context;
+    ASSERT(ToBool(true).TryAs<runtime::Bool>()->GetValue());
+    ASSERT(ToBool(true).Get() == TRUE_VALUE.Get());
+    ASSERT(ToBool(false).Get() == FALSE_VALUE.Get());
+
+    ASSERT_EQUAL(Stringify({}, context).TryAs<runtime::String>()->GetValue(), "None"s);
+    ASSERT_EQUAL(Stringify(ObjectHolder::Own(runtime::Number(7)), context).TryAs<runtime::String>()->GetValue(),
+                 "7"s);
+
+    const ObjectHolder one = ObjectHolder::Own(runtime::Number(1));
+    const ObjectHolder text = ObjectHolder::Own(runtime::String("a"s));
+    ASSERT_EQUAL(AddObjects(one, one, context).TryAs<runtime::Number>()->GetValue(), 2);
+    ASSERT_EQUAL(AddObjects(text, text, context).TryAs<runtime::String>()->GetValue(), "aa"s);
+    ASSERT_THROWS(AddObjects(one, text, context), runtime_error);
+    ASSERT(context.output.str().empty());
+}
+
+void TestCallSiteRemembersMethod() {
+    vector<runtime::Method> base_methods;
+    base_methods.push_back({"f"s, {"x"s}, make_unique<EmptyBody>()});
+    runtime::Class base("Base"s, std::move(base_methods), nullptr);
+    runtime::Class derived("Derived"s, {}, &base);
+
+    CallSite<EmptyBody> site{"f"sv, 1};
+    site.Resolve(derived);
+    ASSERT(site.cls == &derived);
+    ASSERT(site.target == base.GetMethod("f"sv)->body.get());
+
+    // Тело другого типа выполняется рантаймом
+    CallSite<Wrapper> other{"f"sv, 1};
+    other.Resolve(base);
+    ASSERT(other.target == nullptr);
+
+    CallSite<EmptyBody> wrong_arity{"f"sv, 2};
+    ASSERT_THROWS(wrong_arity.Resolve(base), runtime_error);
+    CallSite<EmptyBody> missing{"g"sv, 0};
+    ASSERT_THROWS(missing.Resolve(base), runtime_error);
+}
+
+void TestWrapMethods() {
+    ast::Arena arena;
+    vector<runtime::Method> methods;
+    methods.push_back({"tree"s, {"x"s}, make_unique<ast::MethodBody>(arena.Make<ast::Compound>())});
+    methods.push_back({"other"s, {}, make_unique<EmptyBody>()});
+    runtime::Class cls("C"s, std::move(methods), nullptr);
+
+    WrapMethods<Wrapper>(cls);
+    auto* wrapped = dynamic_cast<Wrapper*>(cls.GetMethod("tree"sv)->body.get());
+    ASSERT(wrapped != nullptr);
+    ASSERT(wrapped->formal_params == vector<runtime::Symbol>{"x"sv});
+    ASSERT(&ParsedBody(*wrapped->body) == wrapped->body.get());
+    ASSERT(dynamic_cast<EmptyBody*>(cls.GetMethod("other"sv)->body.get()) != nullptr);
+
+    // Повторная замена не оборачивает тело ещё раз
+    WrapMethods<Wrapper>(cls);
+    ASSERT(cls.GetMethod("tree"sv)->body.get() == wrapped);
+}
+
+}  // namespace
+
+void RunEngineTests(TestRunner& tr) {
+    RUN_TEST(tr, TestValues);
+    RUN_TEST(tr, TestCallSiteRemembersMethod);
+    RUN_TEST(tr, TestWrapMethods);
+}
+
+}  // namespace engine
@@ -0,0 +1,630 @@
+#include "bench_runner_p.h"
+#include "incremental.h"
+#include "lexer.h"
+#include "parallel_parse.h"
+#include "parse.h"
+#include "scan.h"
+#include "statement.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+// Учёт динамической памяти: глобальные operator new/delete этого бенчмарка считают
+// текущий и пиковый объём выделенных байт
+namespace {
+
+atomic<size_t> allocated_bytes{0};
+atomic<size_t> peak_bytes{0};
+
+// Заголовок перед каждым блоком хранит его размер, чтобы operator delete мог его вычесть
+constexpr size_t ALLOCATION_HEADER = alignof(max_align_t);
+
+void* CountedAlloc(size_t size) {
+    void* raw = malloc(size + ALLOCATION_HEADER);
+    if (raw == nullptr) {
+        throw bad_alloc();
+    }
+    *static_cast<size_t*>(raw) = size;
+    const size_t current = allocated_bytes.fetch_add(size, memory_order_relaxed) + size;
+    size_t peak = peak_bytes.load(memory_order_relaxed);
+    while (current > peak && !peak_bytes.compare_exchange_weak(peak, current, memory_order_relaxed)) {
+    }
+    return static_cast<char*>(raw) + ALLOCATION_HEADER;
+}
+
+void CountedFree(void* ptr) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+    void* raw = static_cast<char*>(ptr) - ALLOCATION_HEADER;
+    allocated_bytes.fetch_sub(*static_cast<size_t*>(raw), memory_order_relaxed);
+    free(raw);
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+    return CountedAlloc(size);
+}
+
+void* operator new[](size_t size) {
+    return CountedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    CountedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    CountedFree(ptr);
+}
+
+void operator delete(void* ptr, size_t /*size*/) noexcept {
+    CountedFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t /*size*/) noexcept {
+    CountedFree(ptr);
+}
+
+namespace {
+
+// Сгенерированная программа. nodes - число узлов AST, которое должен построить парсер
+struct Program {
+    string source;
+    size_t lines = 0;
+    size_t nodes = 0;
+};
+
+using Generator = function<Program(size_t target_lines)>;
+
+// Поток простых инструкций верхнего уровня: присваивания, print и if/else
+Program GenerateLines(size_t target_lines) {
+    Program program;
+    program.nodes = 1;  // Корневой Compound
+    ostringstream out;
+    for (size_t i = 0; program.lines < target_lines; ++i) {
+        switch (i % 3) {
+        case 0:
+            // Assignment, Add, NumericConst, Mult, NumericConst, NumericConst
+            out << "v" << i % 97 << " = " << i << " + x * 3\n";
+            program.lines += 1;
+            program.nodes += 6;
+            break;
+        case 1:
+            // Print, VariableValue, StringConst, BoolConst
+            out << "print v" << i % 97 << ", 'line', True\n";
+            program.lines += 1;
+            program.nodes += 4;
+            break;
+        default:
+            // IfElse, Comparison, VariableValue, NumericConst, Compound, Assignment, Sub,
+            // VariableValue, NumericConst, Compound, Assignment, None
+            out << "if v1 > " << i << ":\n  v1 = v1 - 1\nelse:\n  v1 = None\n";
+            program.lines += 4;
+            program.nodes += 12;
+        }
+    }
+    program.source = out.str();
+    return program;
+}
+
+// Тысячи классов, каждый унаследован от предыдущего
+Program GenerateClasses(size_t target_lines) {
+    Program program;
+    program.nodes = 1;
+    ostringstream out;
+    for (size_t i = 0; program.lines < target_lines; ++i) {
+        out << "class C" << i;
+        if (i > 0) {
+            out << "(C" << i - 1 << ')';
+        }
+        out << ":\n"
+               "  def __init__(a):\n"
+               "    self.a = a\n"
+               "\n"
+               "  def get"
+            << i << "():\n    return self.a + " << i << "\n\n";
+        program.lines += 8;
+        // ClassDefinition; MethodBody, Compound, FieldAssignment с вложенным VariableValue,
+        // VariableValue; MethodBody, Compound, Return, Add, VariableValue, NumericConst
+        program.nodes += 12;
+    }
+    program.source = out.str();
+    return program;
+}
+
+// Один класс с очень большим числом методов, у каждого по 8 параметров
+Program GenerateWideMethods(size_t target_lines) {
+    constexpr int params = 8;
+
+    Program program;
+    program.nodes = 2;  // Корневой Compound и ClassDefinition
+    program.lines = 1;
+    ostringstream out;
+    out << "class Wide:\n";
+    for (size_t i = 0; program.lines < target_lines; ++i) {
+        out << "  def m" << i << '(';
+        for (int p = 0; p < params; ++p) {
+            out << (p > 0 ? ", p" : "p") << p;
+        }
+        out << "):\n    return p0";
+        for (int p = 1; p < params; ++p) {
+            out << " + p" << p;
+        }
+        out << "\n";
+        program.lines += 2;
+        // MethodBody, Compound, Return, (params - 1) Add, params VariableValue
+        program.nodes += 3 + 2 * params - 1;
+    }
+    program.source = out.str();
+    return program;
+}
+
+// Блоки вложенных if глубиной depth
+Program GenerateDeepNesting(size_t target_lines) {
+    constexpr size_t depth = 64;
+
+    Program program;
+    program.nodes = 1;
+    ostringstream out;
+    while (program.lines < target_lines) {
+        for (size_t level = 0; level < depth; ++level) {
+            out << string(level * 2, ' ') << "if x" << level << ":\n";
+        }
+        out << string(depth * 2, ' ') << "y = 1\n";
+        program.lines += depth + 1;
+        // IfElse, VariableValue, Compound на каждый уровень; Assignment, NumericConst
+        program.nodes += 3 * depth + 2;
+    }
+    program.source = out.str();
+    return program;
+}
+
+// Длинные строковые литералы, часть из них с escape-последовательностями
+Program GenerateLongStrings(size_t target_lines) {
+    constexpr size_t length = 1000;
+
+    const string plain(length, 'a');
+    string escaped;
+    while (escaped.size() < length) {
+        escaped += "text \\\"quoted\\\" \\n and \\t tab ";
+    }
+
+    Program program;
+    program.nodes = 1;
+    ostringstream out;
+    for (size_t i = 0; program.lines < target_lines; ++i) {
+        if (i % 4 == 0) {
+            out << "s = \"" << escaped << "\"\n";
+        } else {
+            out << "s = '" << plain << "'\n";
+        }
+        program.lines += 1;
+        program.nodes += 2;  // Assignment, StringConst
+    }
+    program.source = out.str();
+    return program;
+}
+
+// Длинные цепочки обращений к полям и вызовы методов через них
+Program GenerateDottedChains(size_t target_lines) {
+    constexpr int length = 32;
+
+    string chain = "root";
+    for (int i = 0; i < length; ++i) {
+        chain += ".field_" + to_string(i);
+    }
+
+    Program program;
+    program.nodes = 1;
+    ostringstream out;
+    for (size_t i = 0; program.lines < target_lines; ++i) {
+        if (i % 2 == 0) {
+            out << "v = " << chain << "\n";
+            program.nodes += 2;  // Assignment, VariableValue
+        } else {
+            out << chain << ".call(v)\n";
+            program.nodes += 3;  // MethodCall, VariableValue, VariableValue
+        }
+        program.lines += 1;
+    }
+    program.source = out.str();
+    return program;
+}
+
+struct Measurement {
+    size_t tokens = 0;
+    double lex_ms = 0;
+    double frontend_ms = 0;
+    double teardown_ms = 0;
+    size_t lex_peak_bytes = 0;
+    size_t frontend_peak_bytes = 0;
+};
+
+// Возвращает пиковый прирост выделенной памяти за время выполнения action
+template <typename Action>
+size_t MeasurePeakBytes(Action&& action) {
+    const size_t baseline = allocated_bytes.load();
+    peak_bytes.store(baseline);
+    action();
+    return peak_bytes.load() - baseline;
+}
+
+Measurement MeasureOnce(const string& source) {
+    Measurement result;
+
+    // Лексический анализ: все токены до Eof
+    result.lex_peak_bytes = MeasurePeakBytes([&] {
+        result.lex_ms = bench::MeasureMs([&] {
+            parse::Lexer lexer(string_view{source});
+            size_t tokens = 1;
+            while (!lexer.CurrentToken().Is<parse::token_type::Eof>()) {
+                lexer.NextToken();
+                ++tokens;
+            }
+            result.tokens = tokens;
+        });
+    });
+
+    // Весь фронтенд: лексер и построение AST
+    result.frontend_peak_bytes = MeasurePeakBytes([&] {
+        unique_ptr<runtime::Executable> program;
+        result.frontend_ms = bench::MeasureMs([&] {
+            parse::Lexer lexer(string_view{source});
+            program = ParseProgram(lexer);
+        });
+        // Освобождение AST замеряется отдельно от разбора
+        result.teardown_ms = bench::MeasureMs([&] {
+            program.reset();
+        });
+    });
+    return result;
+}
+
+const char* ScanLevelName(parse::ScanLevel level) {
+    switch (level) {
+    case parse::ScanLevel::SCALAR:
+        return "scalar";
+    case parse::ScanLevel::SSE2:
+        return "sse2";
+    case parse::ScanLevel::AVX2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+// Замеряет пропускную способность ядер сканирования каждого доступного уровня на тексте из участков
+// длины run, разделённых одним символом, на котором участок заканчивается
+void RunScanKernels(const bench::Options& options, bench::JsonWriter& json) {
+    constexpr size_t text_bytes = 16 << 20;
+    using Kernel = function<const char*(const parse::ScanKernels&, const char*, const char*)>;
+    const vector<tuple<string, char, char, Kernel>> kernels = {
+        {"skip_spaces"s, ' ', 'x',
+         [](const parse::ScanKernels& k, const char* pos, const char* end) {
+             return k.skip_spaces(pos, end);
+         }},
+        {"find_identifier_end"s, 'a', ' ',
+         [](const parse::ScanKernels& k, const char* pos, const char* end) {
+             return k.find_identifier_end(pos, end);
+         }},
+        {"find_quote_or_backslash"s, 'a', '"',
+         [](const parse::ScanKernels& k, const char* pos, const char* end) {
+             return k.find_quote_or_backslash(pos, end, '"');
+         }},
+    };
+
+    for (const auto& [kernel_name, fill, stop, kernel] : kernels) {
+        for (size_t run : {8, 64, 1024}) {
+            string text;
+            text.reserve(text_bytes + run + 1);
+            while (text.size() < text_bytes) {
+                text.append(run, fill);
+                text.push_back(stop);
+            }
+            for (auto level : {parse::ScanLevel::SCALAR, parse::ScanLevel::SSE2, parse::ScanLevel::AVX2}) {
+                const parse::ScanKernels* kernels_ptr = parse::GetScanKernels(level);
+                const string name = "scan/"s + kernel_name + "/run="s + to_string(run) + "/"s + ScanLevelName(level);
+                if (kernels_ptr == nullptr || !options.Selected(name)) {
+                    continue;
+                }
+                cerr << "Running "s << name << "..."s << endl;
+
+                auto scan_all = [&] {
+                    const char* pos = text.data();
+                    const char* end = text.data() + text.size();
+                    size_t runs = 0;
+                    while (pos != end) {
+                        pos = kernel(*kernels_ptr, pos, end);
+                        if (pos != end) {
+                            ++pos;
+                            ++runs;
+                        }
+                    }
+                    bench::DoNotOptimize(runs);
+                };
+                for (int i = 0; i < options.warmup; ++i) {
+                    scan_all();
+                }
+                vector<double> samples;
+                for (int i = 0; i < options.repeat; ++i) {
+                    samples.push_back(bench::MeasureMs(scan_all));
+                }
+                const bench::Stats stats = bench::Summarize(std::move(samples));
+                const double megabytes = static_cast<double>(text.size()) / (1024.0 * 1024.0);
+
+                json.BeginObject();
+                json.Key("name").Value(name);
+                json.Key("kernel").Value(kernel_name);
+                json.Key("run").Value(run);
+                json.Key("level").Value(ScanLevelName(level));
+                json.Key("time").Value(stats);
+                json.Key("mb_per_sec").Value(megabytes / (stats.median / 1000.0));
+                json.EndObject();
+            }
+        }
+    }
+}
+
+// Смещение начала строки без отступа во второй половине source (или конец текста). Вставка
+// инструкции в это место не меняет структуру остальной программы
+size_t FindTopLevelLineInMiddle(const string& source) {
+    for (size_t pos = source.find('\n', source.size() / 2); pos != string::npos; pos = source.find('\n', pos + 1)) {
+        const size_t line = pos + 1;
+        if (line < source.size() && source[line] != ' ' && source[line] != '\n' && source.compare(line, 4, "else"s) != 0) {
+            return line;
+        }
+    }
+    return source.size();
+}
+
+// Замеряет время правки программы через parse::IncrementalProgram: в середину текста вставляется
+// инструкция, затем удаляется. Для сравнения замеряется полный разбор того же текста
+void RunIncrementalEdits(const bench::Options& options, const vector<pair<string, Generator>>& generators,
+                         size_t max_lines, bench::JsonWriter& json) {
+    constexpr int edits_per_sample = 20;
+    const string probe = "edit_probe = 1\n"s;
+
+    for (const auto& [generator_name, generate] : generators) {
+        for (size_t lines = 1000; lines <= max_lines; lines *= 10) {
+            const string name = "edit/"s + generator_name + "/lines="s + to_string(lines);
+            if (!options.Selected(name)) {
+                continue;
+            }
+            cerr << "Running "s << name << "..."s << endl;
+
+            const Program program = generate(lines);
+            const size_t offset = FindTopLevelLineInMiddle(program.source);
+            parse::IncrementalProgram incremental(program.source);
+
+            vector<double> full_samples;
+            vector<double> edit_samples;
+            size_t relexed_bytes = 0;
+            for (int i = 0; i < options.warmup + options.repeat; ++i) {
+                unique_ptr<runtime::Executable> parsed;
+                const double full_ms = bench::MeasureMs([&] {
+                    parse::Lexer lexer(string_view{program.source});
+                    parsed = ParseProgram(lexer);
+                });
+                double edit_ms = 0;
+                for (int j = 0; j < edits_per_sample; ++j) {
+                    edit_ms += bench::MeasureMs([&] {
+                        incremental.Edit(offset, 0, probe);
+                    });
+                    relexed_bytes = incremental.LastEditStats().relexed_bytes;
+                    edit_ms += bench::MeasureMs([&] {
+                        incremental.Edit(offset, probe.size(), ""s);
+                    });
+                }
+                if (i >= options.warmup) {
+                    full_samples.push_back(full_ms);
+                    edit_samples.push_back(edit_ms / (2 * edits_per_sample));
+                }
+            }
+
+            const bench::Stats full = bench::Summarize(std::move(full_samples));
+            const bench::Stats edit = bench::Summarize(std::move(edit_samples));
+
+            json.BeginObject();
+            json.Key("name").Value(name);
+            json.Key("generator").Value(generator_name);
+            json.Key("lines").Value(program.lines);
+            json.Key("source_bytes").Value(program.source.size());
+            json.Key("relexed_bytes").Value(relexed_bytes);
+            json.Key("full_parse").Value(full);
+            json.Key("edit").Value(edit);
+            json.Key("speedup").Value(full.median / edit.median);
+            json.EndObject();
+        }
+    }
+}
+
+// Разбор самых больших программ в 1, 2, 4, ... потоках вплоть до числа ядер процессора
+void RunParallelParse(const bench::Options& options, const vector<pair<string, Generator>>& generators,
+                      size_t max_lines, bench::JsonWriter& json) {
+    const unsigned cores = max(thread::hardware_concurrency(), 1U);
+    vector<unsigned> thread_counts;
+    for (unsigned threads = 1; threads < cores; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(cores);
+
+    for (const auto& [generator_name, generate] : generators) {
+        const auto name_for = [&generator_name = generator_name, max_lines](unsigned threads) {
+            return "parallel/"s + generator_name + "/lines="s + to_string(max_lines) + "/threads="s
+                   + to_string(threads);
+        };
+        if (none_of(thread_counts.begin(), thread_counts.end(), [&](unsigned threads) {
+                return options.Selected(name_for(threads));
+            })) {
+            continue;
+        }
+
+        const Program program = generate(max_lines);
+        const double megabytes = static_cast<double>(program.source.size()) / (1024.0 * 1024.0);
+        double sequential_ms = 0;
+        for (const unsigned threads : thread_counts) {
+            const string name = name_for(threads);
+            if (!options.Selected(name)) {
+                continue;
+            }
+            cerr << "Running "s << name << "..."s << endl;
+
+            unique_ptr<runtime::Executable> parsed;
+            const auto parse = [&parsed, &program, threads = threads] {
+                parsed = ParseProgramParallel(program.source, threads);
+            };
+            vector<double> samples;
+            for (int i = 0; i < options.warmup + options.repeat; ++i) {
+                // Дерево от предыдущего замера удаляется вне замера
+                parsed.reset();
+                const double ms = bench::MeasureMs(parse);
+                if (i >= options.warmup) {
+                    samples.push_back(ms);
+                }
+            }
+            const bench::Stats stats = bench::Summarize(std::move(samples));
+            if (threads == 1) {
+                sequential_ms = stats.median;
+            }
+
+            json.BeginObject();
+            json.Key("name").Value(name);
+            json.Key("generator").Value(generator_name);
+            json.Key("lines").Value(program.lines);
+            json.Key("threads").Value(static_cast<size_t>(threads));
+            json.Key("time").Value(stats);
+            json.Key("mb_per_sec").Value(megabytes / (stats.median / 1000.0));
+            if (sequential_ms > 0) {
+                json.Key("speedup").Value(sequential_ms / stats.median);
+            }
+            json.EndObject();
+        }
+    }
+}
+
+void RunBenchmarks(const bench::Options& options, size_t max_lines, ostream& report) {
+    const vector<pair<string, Generator>> generators = {
+        {"lines"s, GenerateLines},
+        {"classes"s, GenerateClasses},
+        {"wide_methods"s, GenerateWideMethods},
+        {"deep_nesting"s, GenerateDeepNesting},
+        {"long_strings"s, GenerateLongStrings},
+        {"dotted_chains"s, GenerateDottedChains},
+    };
+
+    bench::JsonWriter json(report);
+    json.BeginObject();
+    json.Key("benchmark").Value("mython_frontend_scaling");
+    json.Key("warmup").Value(options.warmup);
+    json.Key("repeat").Value(options.repeat);
+    json.Key("scan_level").Value(ScanLevelName(parse::ActiveScanLevel()));
+    json.Key("results").BeginArray();
+
+    for (const auto& [generator_name, generate] : generators) {
+        for (size_t lines = 1000; lines <= max_lines; lines *= 10) {
+            const string name = generator_name + "/lines="s + to_string(lines);
+            if (!options.Selected(name)) {
+                continue;
+            }
+            cerr << "Running "s << name << "..."s << endl;
+
+            const Program program = generate(lines);
+            for (int i = 0; i < options.warmup; ++i) {
+                MeasureOnce(program.source);
+            }
+
+            vector<double> lex_samples;
+            vector<double> frontend_samples;
+            vector<double> teardown_samples;
+            Measurement last;
+            size_t lex_peak = 0;
+            size_t frontend_peak = 0;
+            for (int i = 0; i < options.repeat; ++i) {
+                last = MeasureOnce(program.source);
+                lex_samples.push_back(last.lex_ms);
+                frontend_samples.push_back(last.frontend_ms);
+                teardown_samples.push_back(last.teardown_ms);
+                lex_peak = max(lex_peak, last.lex_peak_bytes);
+                frontend_peak = max(frontend_peak, last.frontend_peak_bytes);
+            }
+
+            const bench::Stats lex = bench::Summarize(lex_samples);
+            const bench::Stats frontend = bench::Summarize(frontend_samples);
+            const double megabytes = static_cast<double>(program.source.size()) / (1024.0 * 1024.0);
+
+            json.BeginObject();
+            json.Key("name").Value(name);
+            json.Key("generator").Value(generator_name);
+            json.Key("lines").Value(program.lines);
+            json.Key("source_bytes").Value(program.source.size());
+            json.Key("tokens").Value(last.tokens);
+            json.Key("ast_nodes").Value(program.nodes);
+            json.Key("lex").Value(lex);
+            json.Key("frontend").Value(frontend);
+            json.Key("teardown").Value(bench::Summarize(std::move(teardown_samples)));
+            json.Key("tokens_per_sec").Value(static_cast<double>(last.tokens) / (lex.median / 1000.0));
+            json.Key("lex_mb_per_sec").Value(megabytes / (lex.median / 1000.0));
+            json.Key("frontend_mb_per_sec").Value(megabytes / (frontend.median / 1000.0));
+            json.Key("ast_nodes_per_sec").Value(static_cast<double>(program.nodes) / (frontend.median / 1000.0));
+            json.Key("lex_peak_bytes").Value(lex_peak);
+            json.Key("frontend_peak_bytes").Value(frontend_peak);
+            json.EndObject();
+        }
+    }
+
+    json.EndArray();
+    json.Key("scan_kernels").BeginArray();
+    RunScanKernels(options, json);
+    json.EndArray();
+    json.Key("incremental_edits").BeginArray();
+    RunIncrementalEdits(options, generators, max_lines, json);
+    json.EndArray();
+    json.Key("parallel_parse").BeginArray();
+    RunParallelParse(options, generators, max_lines, json);
+    json.EndArray();
+    json.EndObject();
+    report << endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        size_t max_lines = 1000000;
+        auto extra = [&max_lines](string_view arg, const char* next) -> bool {
+            if (arg == "--max-lines"sv && next != nullptr) {
+                max_lines = stoul(next);
+                return true;
+            }
+            throw invalid_argument("Unknown option "s + string(arg));
+        };
+        bench::Options defaults;
+        defaults.warmup = 1;
+        defaults.repeat = 3;
+        const bench::Options options = bench::ParseOptions(argc, argv, defaults, extra);
+
+        if (options.out.empty()) {
+            RunBenchmarks(options, max_lines, cout);
+        } else {
+            ofstream report(options.out);
+            RunBenchmarks(options, max_lines, report);
+        }
+    } catch (const std::exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,242 @@
+#include "incremental.h"
+
+#include "lexer.h"
+#include "top_level.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+
+using namespace std;
+
+namespace parse {
+
+namespace {
+
+// Программа без инструкций. Инструкции фрагментов добавляются в её составную инструкцию
+ast::Program MakeEmptyProgram() {
+    auto arena = make_unique<ast::Arena>();
+    ast::Statement* body = arena->Make<ast::Compound>();
+    return ast::Program(std::move(arena), body);
+}
+
+}  // namespace
+
+IncrementalProgram::IncrementalProgram(string_view source)
+    : program_(MakeEmptyProgram()), statements_(*dynamic_cast<ast::Compound*>(program_.Body())) {
+    ReplaceFragments(0, 0, string(source));
+}
+
+void IncrementalProgram::Edit(size_t offset, size_t length, string_view replacement) {
+    if (offset > size_ || length > size_ - offset) {
+        throw out_of_range("Edit is out of the program text"s);
+    }
+
+    // Правка задевает фрагменты, пересекающиеся с заменяемым участком, или один фрагмент,
+    // в который вставляется текст. Если правка меняет границы строк на краях этих фрагментов,
+    // ReplaceFragments расширит область сама
+    const size_t edit_end = offset + length;
+    size_t first = 0;
+    size_t last = 0;
+    size_t region_begin = 0;
+    size_t fragment_begin = 0;
+    for (size_t i = 0; i < fragments_.size(); ++i) {
+        if (fragment_begin <= offset) {
+            first = i;
+            region_begin = fragment_begin;
+        }
+        if (fragment_begin >= edit_end && i > first) {
+            break;
+        }
+        last = i + 1;
+        fragment_begin += fragments_[i].text.size();
+    }
+    // Текст, дописанный после завершённой последней строки, не меняет последний фрагмент
+    if (offset == size_ && !fragments_.empty() && fragments_.back().text.back() == '\n' && !ends_in_string_) {
+        first = last = fragments_.size();
+        region_begin = size_;
+    }
+
+    string region;
+    for (size_t i = first; i < last; ++i) {
+        region += fragments_[i].text;
+    }
+    region.replace(offset - region_begin, length, replacement);
+    ReplaceFragments(first, last, std::move(region));
+}
+
+void IncrementalProgram::ReplaceFragments(size_t first, size_t last, string region) {
+    // Расширяем область, пока её границы не совпадут с границами инструкций: правка могла
+    // приклеить первую строку к предыдущей инструкции, а следующую за областью строку - к
+    // последней строке области, или открыть строковую константу, которая продолжается
+    // в следующих фрагментах. Пустая область означает, что фрагменты удалены целиком
+    TopLevelSplit split;
+    if (!region.empty()) {
+        split = SplitTopLevel(region);
+        const auto open_end = [&region, &split] {
+            return split.ends_in_string || region.back() != '\n';
+        };
+        while ((!split.leading_statement && first > 0) || (open_end() && last < fragments_.size())) {
+            if (!split.leading_statement && first > 0) {
+                --first;
+                region.insert(0, fragments_[first].text);
+            } else {
+                region += fragments_[last].text;
+                ++last;
+            }
+            split = SplitTopLevel(region);
+        }
+        split.starts.push_back(region.size());
+    }
+    const bool region_reaches_end = last == fragments_.size();
+
+    vector<Fragment> fragments;
+    for (size_t i = 0; i + 1 < split.starts.size(); ++i) {
+        fragments.push_back({region.substr(split.starts[i], split.starts[i + 1] - split.starts[i]), {}, {}, {}});
+    }
+
+    // Фрагменты, текст которых правка не изменила, остаются прежними. Предшествующий им текст
+    // тоже не изменился, а фрагменты после области ниже проверяются на зависимость от классов
+    size_t prefix = 0;
+    while (prefix < fragments.size() && first + prefix < last
+           && fragments[prefix].text == fragments_[first + prefix].text) {
+        ++prefix;
+    }
+    size_t suffix = 0;
+    while (prefix + suffix < fragments.size() && first + prefix + suffix < last
+           && fragments[fragments.size() - 1 - suffix].text == fragments_[last - 1 - suffix].text) {
+        ++suffix;
+    }
+    fragments.erase(fragments.end() - static_cast<ptrdiff_t>(suffix), fragments.end());
+    fragments.erase(fragments.begin(), fragments.begin() + static_cast<ptrdiff_t>(prefix));
+    first += prefix;
+    last -= suffix;
+
+    // Классы, объявления которых удалены или разобраны заново
+    unordered_set<runtime::Symbol> changed;
+    size_t removed_bytes = 0;
+    for (size_t i = first; i < last; ++i) {
+        removed_bytes += fragments_[i].text.size();
+        for (const auto& [name, cls] : fragments_[i].declared) {
+            changed.insert(name);
+        }
+    }
+
+    // Классы, объявленные до области, нужны, только если что-то придётся разбирать
+    EditStats stats;
+    runtime::Closure classes;
+    if (!fragments.empty() || !changed.empty()) {
+        for (size_t i = 0; i < first; ++i) {
+            classes.insert(fragments_[i].declared.begin(), fragments_[i].declared.end());
+        }
+    }
+
+    vector<ast::Statement*> statements;
+    statements.reserve(fragments.size());
+    for (Fragment& fragment : fragments) {
+        statements.push_back(ParseFragment(fragment, classes));
+        for (const auto& [name, cls] : fragment.declared) {
+            changed.insert(name);
+        }
+        stats.relexed_bytes += fragment.text.size();
+    }
+    const size_t added_bytes = stats.relexed_bytes;
+
+    // Дальше по тексту заново разбираются только фрагменты, которые ссылаются на изменившиеся
+    // классы или объявляют классы с теми же именами
+    vector<pair<size_t, Fragment>> dependents;
+    vector<ast::Statement*> dependent_statements;
+    const auto is_changed = [&changed](runtime::Symbol name) {
+        return changed.count(name) > 0;
+    };
+    for (size_t i = last; i < fragments_.size() && !changed.empty(); ++i) {
+        const Fragment& old = fragments_[i];
+        const bool depends = any_of(old.used.begin(), old.used.end(), is_changed)
+                             || any_of(old.declared.begin(), old.declared.end(),
+                                       [&is_changed](const auto& declared) {
+                                           return is_changed(declared.first);
+                                       });
+        if (!depends) {
+            classes.insert(old.declared.begin(), old.declared.end());
+            continue;
+        }
+
+        Fragment fragment{old.text, {}, {}, {}};
+        dependent_statements.push_back(ParseFragment(fragment, classes));
+        for (const auto& [name, cls] : fragment.declared) {
+            changed.insert(name);
+        }
+        stats.relexed_bytes += fragment.text.size();
+        dependents.emplace_back(i, std::move(fragment));
+    }
+    stats.reparsed_statements = fragments.size() + dependents.size();
+
+    // Все фрагменты разобраны без ошибок, заменяем старые. Зависимые фрагменты лежат после
+    // заменяемой области, поэтому их позиции ещё не сдвинуты
+    for (size_t i = 0; i < dependents.size(); ++i) {
+        auto& [pos, fragment] = dependents[i];
+        fragments_[pos] = std::move(fragment);
+        statements_.ReplaceStatements(pos, 1, {dependent_statements[i]});
+    }
+
+    // Общая часть заменяется на месте, остальные фрагменты сдвигаются только при изменении их числа
+    const size_t common = min(last - first, fragments.size());
+    move(fragments.begin(), fragments.begin() + static_cast<ptrdiff_t>(common),
+         fragments_.begin() + static_cast<ptrdiff_t>(first));
+    const auto tail = fragments_.begin() + static_cast<ptrdiff_t>(first + common);
+    if (last - first > common) {
+        fragments_.erase(tail, fragments_.begin() + static_cast<ptrdiff_t>(last));
+    } else {
+        fragments_.insert(tail, make_move_iterator(fragments.begin() + static_cast<ptrdiff_t>(common)),
+                          make_move_iterator(fragments.end()));
+    }
+    statements_.ReplaceStatements(first, last - first, statements);
+
+    if (region_reaches_end) {
+        ends_in_string_ = split.ends_in_string;
+    }
+    size_ = size_ - removed_bytes + added_bytes;
+    last_edit_ = stats;
+}
+
+ast::Statement* IncrementalProgram::ParseFragment(Fragment& fragment, runtime::Closure& classes) {
+    ClassScope scope;
+    scope.classes = std::move(classes);
+
+    fragment.arena = make_unique<ast::Arena>();
+    Lexer lexer(string_view{fragment.text});
+    vector<ast::Statement*> statements = ParseStatements(lexer, scope, *fragment.arena);
+
+    classes = std::move(scope.classes);
+    fragment.used = std::move(scope.used);
+    for (const runtime::Symbol name : scope.declared) {
+        fragment.declared.emplace_back(name, classes.at(name));
+    }
+
+    if (statements.size() == 1) {
+        return statements.front();
+    }
+    // Фрагмент без инструкций (пустой текст или одни комментарии)
+    return fragment.arena->Make<ast::Compound>(fragment.arena->MakeVector(statements));
+}
+
+string IncrementalProgram::Text() const {
+    string result;
+    result.reserve(size_);
+    for (const Fragment& fragment : fragments_) {
+        result += fragment.text;
+    }
+    return result;
+}
+
+size_t IncrementalProgram::Size() const {
+    return size_;
+}
+
+runtime::Executable& IncrementalProgram::Program() {
+    return program_;
+}
+
+}  // namespace parse
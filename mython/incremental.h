@@ -0,0 +1,86 @@
+#pragma once
+
+#include "parse.h"
+#include "statement.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace parse {
+
+// Программа, которая после правки исходного текста заново разбирает только затронутые части.
+// Текст делится на фрагменты по инструкциям верхнего уровня: фрагмент начинается со строки без
+// отступа и продолжается до следующей такой строки (строки else, пустые строки и комментарии
+// остаются во фрагменте, как и строковые константы, переходящие на новую строку). Каждому
+// фрагменту соответствует одна инструкция в ast::Compound программы.
+// Правка заново разбирает фрагменты, текст которых она изменила, и фрагменты, ссылающиеся на
+// классы, объявление которых изменилось. Остальные фрагменты и их деревья не трогаются
+class IncrementalProgram {
+public:
+    // Сколько работы выполнила последняя правка
+    struct EditStats {
+        // Суммарный размер текста фрагментов, разобранных заново
+        std::size_t relexed_bytes = 0;
+        // Число фрагментов, разобранных заново
+        std::size_t reparsed_statements = 0;
+    };
+
+    // Разбирает source целиком. Выбрасывает ParseError или LexerError, если текст содержит ошибку
+    explicit IncrementalProgram(std::string_view source);
+
+    // Заменяет length байт текста, начиная со смещения offset, на replacement и обновляет дерево
+    // программы. Если после правки текст содержит ошибку, выбрасывает ParseError или LexerError
+    // и оставляет текст и дерево прежними. Выбрасывает std::out_of_range, если правка выходит
+    // за границы текста
+    void Edit(std::size_t offset, std::size_t length, std::string_view replacement);
+
+    // Возвращает текущий исходный текст
+    [[nodiscard]] std::string Text() const;
+
+    // Возвращает размер текущего исходного текста
+    [[nodiscard]] std::size_t Size() const;
+
+    // Возвращает дерево программы. Ссылка действительна всё время жизни объекта
+    [[nodiscard]] runtime::Executable& Program();
+
+    [[nodiscard]] const EditStats& LastEditStats() const {
+        return last_edit_;
+    }
+
+private:
+    struct Fragment {
+        std::string text;
+        // Арена, в которой лежат узлы дерева фрагмента
+        std::unique_ptr<ast::Arena> arena;
+        // Классы, объявленные фрагментом
+        std::vector<std::pair<runtime::Symbol, runtime::ObjectHolder>> declared;
+        // Имена, которые фрагмент искал среди классов
+        std::vector<runtime::Symbol> used;
+    };
+
+    // Разбирает текст фрагмента в его новую арену и заполняет сведения о его классах. Классы
+    // из classes видны фрагменту, объявленные в нём классы добавляются в classes
+    static ast::Statement* ParseFragment(Fragment& fragment, runtime::Closure& classes);
+
+    // Заменяет фрагменты [first, last) фрагментами, на которые делится текст region, и заново
+    // разбирает фрагменты, зависящие от изменившихся классов
+    void ReplaceFragments(std::size_t first, std::size_t last, std::string region);
+
+    // Фрагменты в порядке следования в тексте. fragments_[i] соответствует i-й инструкции statements_
+    std::vector<Fragment> fragments_;
+    // Суммарный размер текста фрагментов
+    std::size_t size_ = 0;
+    // Текст заканчивается внутри незакрытой строковой константы
+    bool ends_in_string_ = false;
+    // Программа, как и при разборе всего текста, выполняет составную инструкцию statements_,
+    // поэтому return вне метода завершает её исключением
+    ast::Program program_;
+    ast::Compound& statements_;
+    EditStats last_edit_;
+};
+
+}  // namespace parse
@@ -0,0 +1,223 @@
+#include "incremental.h"
+#include "test_programs_p.h"
+#include "test_runner_p.h"
+
+#include <random>
+#include <string>
+
+using namespace std;
+
+namespace parse {
+
+namespace {
+using test_programs::ParseText;
+using test_programs::Run;
+
+string RunFromScratch(const string& text) {
+    return Run(*ParseText(text));
+}
+
+// Заменяет первое вхождение what в тексте программы на replacement
+void Replace(IncrementalProgram& program, const string& what, const string& replacement) {
+    const size_t offset = program.Text().find(what);
+    ASSERT(offset != string::npos);
+    program.Edit(offset, what.size(), replacement);
+}
+
+const string PROGRAM = R"(class Counter:
+  def __init__():
+    self.value = 0
+
+  def Add(n):
+    self.value = self.value + n
+    return self
+
+class Named(Counter):
+  def __str__():
+    return 'named ' + str(self.value)
+
+# комментарий 'с кавычкой
+x = 1
+y = "two"
+if x > 0:
+  print 'positive'
+else:
+  print 'negative'
+c = Named()
+c.Add(x)
+print c.Add(41)
+print x, y
+)"s;
+}  // namespace
+
+void TestInitialParseMatchesFullParse() {
+    IncrementalProgram program(PROGRAM);
+    ASSERT_EQUAL(program.Text(), PROGRAM);
+    ASSERT_EQUAL(Run(program.Program()), RunFromScratch(PROGRAM));
+}
+
+void TestEditReparsesOnlyEnclosingStatement() {
+    IncrementalProgram program(PROGRAM);
+
+    Replace(program, "y = \"two\""s, "y = \"three\""s);
+    ASSERT_EQUAL(program.LastEditStats().reparsed_statements, 1U);
+    ASSERT_EQUAL(program.LastEditStats().relexed_bytes, "y = \"three\"\n"s.size());
+    ASSERT_EQUAL(Run(program.Program()), "positive\nnamed 42\n1 three\n"s);
+
+    // Ветка else остаётся частью инструкции if
+    Replace(program, "'negative'"s, "'not positive'"s);
+    ASSERT_EQUAL(program.LastEditStats().reparsed_statements, 1U);
+    Replace(program, "x = 1"s, "x = -1"s);
+    ASSERT_EQUAL(program.LastEditStats().reparsed_statements, 1U);
+    ASSERT_EQUAL(Run(program.Program()), "not positive\nnamed 40\n-1 three\n"s);
+}
+
+void TestEditCanSplitAndJoinStatements() {
+    IncrementalProgram program(PROGRAM);
+
+    Replace(program, "y = \"two\"\n"s, "y = \"two\"\nz = y + '!'\nprint z\n"s);
+    // Сама инструкция y = "two" не изменилась
+    ASSERT_EQUAL(program.LastEditStats().reparsed_statements, 2U);
+    ASSERT_EQUAL(Run(program.Program()), RunFromScratch(program.Text()));
+
+    // Отступ приклеивает строку к предыдущей инструкции
+    Replace(program, "print 'negative'\nc = Named()"s, "print 'negative'\n  c = Named()"s);
+    ASSERT_EQUAL(program.LastEditStats().reparsed_statements, 1U);
+    Replace(program, "c.Add(x)\nprint c.Add(41)"s, "  c.Add(x)\n  print c.Add(41)"s);
+    ASSERT_EQUAL(Run(program.Program()), "two!\npositive\n1 two\n"s);
+    ASSERT_EQUAL(Run(program.Program()), RunFromScratch(program.Text()));
+
+    // Удаление отступа снова выделяет строку в отдельную инструкцию
+    Replace(program, "  c.Add(x)\n  print c.Add(41)"s, "c.Add(x)\nprint c.Add(41)"s);
+    Replace(program, "  c = Named()"s, "c = Named()"s);
+    ASSERT_EQUAL(program.LastEditStats().reparsed_statements, 2U);
+    ASSERT_EQUAL(Run(program.Program()), RunFromScratch(program.Text()));
+}
+
+void TestClassEditReparsesDependents() {
+    IncrementalProgram program(PROGRAM);
+
+    Replace(program, "'named '"s, "'counter '"s);
+    // Класс Named, а также инструкции, которые ищут его или его базовый класс
+    ASSERT_EQUAL(program.LastEditStats().reparsed_statements, 2U);
+    ASSERT_EQUAL(Run(program.Program()), "positive\ncounter 42\n1 two\n"s);
+
+    Replace(program, "self.value = self.value + n"s, "self.value = self.value + 2 * n"s);
+    ASSERT_EQUAL(program.LastEditStats().reparsed_statements, 3U);
+    ASSERT_EQUAL(Run(program.Program()), "positive\ncounter 84\n1 two\n"s);
+}
+
+void TestMultilineStringsAreNotSplit() {
+    const string text = "s = 'a'\nx = 2\nprint s # '\nprint s\n"s;
+    IncrementalProgram program(text);
+
+    // Незакрытая кавычка превращает следующие строки в продолжение константы вплоть до кавычки
+    // в бывшем комментарии
+    program.Edit(text.find("a'"s) + 1, 1, ""s);
+    ASSERT_EQUAL(program.LastEditStats().reparsed_statements, 1U);
+    ASSERT_EQUAL(program.LastEditStats().relexed_bytes, "s = 'a\nx = 2\nprint s # '\n"s.size());
+    ASSERT_EQUAL(Run(program.Program()), "a\nx = 2\nprint s # \n"s);
+
+    program.Edit(text.find("a'"s) + 1, 0, "'"s);
+    ASSERT_EQUAL(program.LastEditStats().reparsed_statements, 3U);
+    ASSERT_EQUAL(program.Text(), text);
+    ASSERT_EQUAL(Run(program.Program()), "a\na\n"s);
+
+    // Константа, не закрытая до конца программы, - ошибка, и программа не меняется
+    ASSERT_THROWS(program.Edit(program.Size(), 0, "print 'b\n"s), LexerError);
+    ASSERT_EQUAL(program.Text(), text);
+
+    // Текст, дописанный в конец, разбирается отдельно, даже если в нём многострочная константа
+    program.Edit(program.Size(), 0, "print 'b\nc'\n"s);
+    ASSERT_EQUAL(program.LastEditStats().relexed_bytes, "print 'b\nc'\n"s.size());
+    program.Edit(program.Size(), 0, "x = 3\n"s);
+    ASSERT_EQUAL(program.LastEditStats().relexed_bytes, "x = 3\n"s.size());
+    ASSERT_EQUAL(Run(program.Program()), RunFromScratch(program.Text()));
+}
+
+void TestFailedEditKeepsProgram() {
+    IncrementalProgram program(PROGRAM);
+    const string output = Run(program.Program());
+
+    ASSERT_THROWS(Replace(program, "x = 1"s, "x = Missing()"s), ParseError);
+    ASSERT_THROWS(Replace(program, "class Named(Counter)"s, "class Named(Missing)"s), ParseError);
+    ASSERT_THROWS(Replace(program, "y = \"two\""s, "class Counter:\n  def f():\n    return 1"s), ParseError);
+    ASSERT_THROWS(program.Edit(program.Size(), 1, ""s), std::out_of_range);
+
+    ASSERT_EQUAL(program.Text(), PROGRAM);
+    ASSERT_EQUAL(Run(program.Program()), output);
+}
+
+void TestTopLevelReturn() {
+    IncrementalProgram program("x = 1\nif x:\n  return 5\nprint 'after'\n"s);
+    runtime::DummyContext context;
+    runtime::Closure closure;
+
+    // Как и программа, разобранная целиком, return вне метода завершает её исключением
+    try {
+        program.Program().Execute(closure, context);
+        ASSERT(false);
+    } catch (const ast::ReturnException& e) {
+        ASSERT_EQUAL(e.GetStatement().TryAs<runtime::Number>()->GetValue(), 5);
+    }
+    ASSERT(!context.IsReturning());
+
+    // Следующее выполнение в том же контексте не видит прерванного return
+    program.Edit(0, 5, "x = 0"s);
+    program.Program().Execute(closure, context);
+    ASSERT_EQUAL(context.output.str(), "after\n"s);
+}
+
+void TestRandomEditsMatchFullParse() {
+    const string lines[] = {
+        "x = 1\n"s,
+        "print x\n"s,
+        "if x:\n  print 'yes'\n"s,
+        "else:\n  print 'no'\n"s,
+        "  x = x + 1\n"s,
+        "\n"s,
+        "# note \"\n"s,
+        "class A:\n  def f():\n    return 1\n"s,
+        "a = A()\n"s,
+        "print 'multi\nline'\n"s,
+    };
+
+    mt19937 generator(13);
+    IncrementalProgram program(""s);
+    size_t accepted = 0;
+    for (int i = 0; i < 400; ++i) {
+        const string before = program.Text();
+        const size_t offset = generator() % (before.size() + 1);
+        const size_t length = generator() % (before.size() - offset + 1) % 40;
+        const string& replacement = lines[generator() % size(lines)];
+
+        string after = before;
+        after.replace(offset, length, replacement);
+        unique_ptr<runtime::Executable> expected;
+        try {
+            expected = ParseText(after);
+        } catch (const std::exception&) {
+            ASSERT_THROWS(program.Edit(offset, length, replacement), std::exception);
+            ASSERT_EQUAL(program.Text(), before);
+            continue;
+        }
+        program.Edit(offset, length, replacement);
+        ASSERT_EQUAL(program.Text(), after);
+        ASSERT_EQUAL(Run(program.Program()), Run(*expected));
+        ++accepted;
+    }
+    ASSERT(accepted > 50);
+}
+
+void RunIncrementalTests(TestRunner& tr) {
+    RUN_TEST(tr, TestInitialParseMatchesFullParse);
+    RUN_TEST(tr, TestEditReparsesOnlyEnclosingStatement);
+    RUN_TEST(tr, TestEditCanSplitAndJoinStatements);
+    RUN_TEST(tr, TestClassEditReparsesDependents);
+    RUN_TEST(tr, TestMultilineStringsAreNotSplit);
+    RUN_TEST(tr, TestFailedEditKeepsProgram);
+    RUN_TEST(tr, TestTopLevelReturn);
+    RUN_TEST(tr, TestRandomEditsMatchFullParse);
+}
+
+}  // namespace parse
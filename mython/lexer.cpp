@@ -1,35 +1,18 @@
 #include "lexer.h"
 
-using namespace std;
-
-#include <iostream>
+#include "scan.h"
 
-namespace parse {
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <optional>
+#include <ostream>
 
-	bool operator==(const Token& lhs, const Token& rhs) {
-		using namespace token_type;
-
-		if (lhs.index() != rhs.index()) {
-			return false;
-		}
-		if (lhs.Is<Char>()) {
-			return lhs.As<Char>().value == rhs.As<Char>().value;
-		}
-		if (lhs.Is<Number>()) {
-			return lhs.As<Number>().value == rhs.As<Number>().value;
-		}
-		if (lhs.Is<String>()) {
-			return lhs.As<String>().value == rhs.As<String>().value;
-		}
-		if (lhs.Is<Id>()) {
-			return lhs.As<Id>().value == rhs.As<Id>().value;
-		}
-		return true;
-	}
+using namespace std;
 
-	bool operator!=(const Token& lhs, const Token& rhs) {
-		return !(lhs == rhs);
-	}
+namespace parse {
 
 	std::ostream& operator<<(std::ostream& os, const Token& rhs) {
 		using namespace token_type;
@@ -74,246 +57,366 @@ namespace parse {
 	}
 
 	Lexer::Lexer(std::istream& input) {
-		LoadTokens(input);
+		// Поток считывается в один непрерывный буфер блоками, без посимвольного чтения
+		std::streambuf& buffer = *input.rdbuf();
+		char chunk[1 << 14];
+		for (std::streamsize read; (read = buffer.sgetn(chunk, sizeof(chunk))) > 0;) {
+			owned_source_.append(chunk, static_cast<size_t>(read));
+		}
+		Reset(owned_source_);
 	}
 
-	const Token& Lexer::CurrentToken() const {
-		return tokens_[current_token_];
+	Lexer::Lexer(std::string_view source) {
+		Reset(source);
 	}
 
-	Token Lexer::NextToken() {
-		return tokens_[current_token_ + 1 >= tokens_.size() ? current_token_ : ++current_token_];
+	void Lexer::Reset(std::string_view source) {
+		pos_ = source.data();
+		end_ = source.data() + source.size();
+		ring_[current_] = LoadToken(literal_buffers_[current_]);
 	}
 
-	int LoadNumber(std::istream& input) {
-		std::string parsed_num;
+	const Token& Lexer::CurrentToken() const {
+		return ring_[current_];
+	}
 
-		// Считывает в parsed_num очередной символ из input
-		auto read_char = [&parsed_num, &input] {
-			parsed_num += static_cast<char>(input.get());
-			if (!input) {
-				//throw ParsingError("Failed to read number from stream"s);
-			}
-		};
+	const Token& Lexer::NextToken() {
+		Advance();
+		return CurrentToken();
+	}
 
-		// Считывает одну или более цифр в parsed_num из input
-		auto read_digits = [&input, read_char] {
-			if (!std::isdigit(input.peek())) {
-				//throw ParsingError("A digit is expected"s);
-			}
-			while (std::isdigit(input.peek())) {
-				read_char();
-			}
-		};
+	const Token& Lexer::PeekToken() {
+		if (!has_lookahead_) {
+			// После Eof токенов больше нет
+			ring_[current_ ^ 1] = CurrentToken().Is<token_type::Eof>() ? CurrentToken() : LoadToken(literal_buffers_[current_ ^ 1]);
+			has_lookahead_ = true;
+		}
+		return ring_[current_ ^ 1];
+	}
+
+	void Lexer::Advance() {
+		PeekToken();
+		current_ ^= 1;
+		has_lookahead_ = false;
+	}
 
-		read_digits();
+	// Все функции разбора ниже работают с диапазоном [pos, end) и сдвигают pos за разобранную лексему
 
-		return std::stoi(parsed_num);
+	int LoadNumber(const char*& pos, const char* end) {
+		int result = 0;
+		const auto [ptr, error] = std::from_chars(pos, end, result);
+		if (error != std::errc()) {
+			throw LexerError("Number "s + std::string(pos, ptr) + " is out of range"s);
+		}
+		pos = ptr;
+		return result;
 	}
 
-	static const std::unordered_map<std::string, Token> KEY_WORDS_MAP = {
-		{ "class"s,		token_type::Class() },
-		{ "return"s,	token_type::Return() },
-		{ "if"s,		token_type::If() },
-		{ "else"s,		token_type::Else() },
-		{ "def"s,		token_type::Def() },
-		{ "print"s,		token_type::Print() },
-		{ "or"s,		token_type::Or() },
-		{ "None"s,		token_type::None() },
-		{ "and"s,		token_type::And() },
-		{ "not"s,		token_type::Not() },
-		{ "True"s,		token_type::True() },
-		{ "False"s,		token_type::False() }
+	// Классы символов, по которым LoadToken выбирает способ разбора лексемы.
+	// Пробелы и концы строк LoadToken обрабатывает раньше, до выбора по классу
+	enum CharClass : std::uint8_t {
+		OTHER,        // Одиночный символ: арифметика, скобки, точка, запятая и т.п.
+		DIGIT,        // Начало числа
+		ID_START,     // Буква или символ подчёркивания: начало идентификатора или ключевого слова
+		QUOTE,        // Начало строковой константы
+		COMMENT,      // Начало комментария
+		COMPARISON,   // Первый символ операторов ==, !=, <=, >=
 	};
 
-	Token Lexer::LoadIdentifier(std::istream& input) {
-		// Считываем значение
-		std::string s;
-		char c;
-		while (true) {
-			input.get(c);
-			if (c == '#') {
-				input.ignore(numeric_limits<streamsize>::max(), '\n');
-				if (!input.eof()) {
-					input.putback('\n');
+	constexpr std::array<std::uint8_t, 256> MakeCharClasses() {
+		std::array<std::uint8_t, 256> result{};
+		for (int c = '0'; c <= '9'; ++c) {
+			result[c] = DIGIT;
+		}
+		for (int c = 'a'; c <= 'z'; ++c) {
+			result[c] = ID_START;
+			result[c - 'a' + 'A'] = ID_START;
+		}
+		result['_'] = ID_START;
+		result['\''] = QUOTE;
+		result['"'] = QUOTE;
+		result['#'] = COMMENT;
+		result['='] = COMPARISON;
+		result['!'] = COMPARISON;
+		result['<'] = COMPARISON;
+		result['>'] = COMPARISON;
+		return result;
+	}
+
+	// Класс каждого байта вычисляется при компиляции, разбор символа стоит одного обращения к таблице
+	constexpr std::array<std::uint8_t, 256> CHAR_CLASSES = MakeCharClasses();
+
+	inline CharClass ClassOf(char c) {
+		return static_cast<CharClass>(CHAR_CLASSES[static_cast<unsigned char>(c)]);
+	}
+
+	// Ядра сканирования выбираются один раз по возможностям процессора
+	const ScanKernels& SCAN = ActiveScanKernels();
+
+	// Возвращает лексему ключевого слова word или nullopt, если word - не ключевое слово.
+	// Слово сравнивается только с ключевыми словами той же длины, без хеширования и выделения памяти
+	constexpr std::optional<Token> FindKeyword(std::string_view word) {
+		switch (word.size()) {
+		case 2:
+			if (word == "if"sv) return token_type::If{};
+			if (word == "or"sv) return token_type::Or{};
+			break;
+		case 3:
+			if (word == "def"sv) return token_type::Def{};
+			if (word == "and"sv) return token_type::And{};
+			if (word == "not"sv) return token_type::Not{};
+			break;
+		case 4:
+			if (word == "else"sv) return token_type::Else{};
+			if (word == "None"sv) return token_type::None{};
+			if (word == "True"sv) return token_type::True{};
+			break;
+		case 5:
+			if (word == "class"sv) return token_type::Class{};
+			if (word == "print"sv) return token_type::Print{};
+			if (word == "False"sv) return token_type::False{};
+			break;
+		case 6:
+			if (word == "return"sv) return token_type::Return{};
+			break;
+		default:
+			break;
+		}
+		return std::nullopt;
+	}
+
+	static_assert(FindKeyword("class"sv)->Is<token_type::Class>());
+	static_assert(FindKeyword("False"sv)->Is<token_type::False>());
+	static_assert(!FindKeyword("classes"sv));
+	static_assert(!FindKeyword("none"sv));
+
+	Token LoadIdentifier(const char*& pos, const char* end) {
+		// Значение - непрерывная последовательность букв, цифр и символов подчёркивания
+		const char* begin = pos;
+		pos = SCAN.find_identifier_end(pos, end);
+		const std::string_view s(begin, pos - begin);
+		// Определяем является ли он ключевым словом
+		if (const auto keyword = FindKeyword(s)) {
+			return *keyword;
+		}
+
+		// Имя интернируется один раз здесь, дальше парсер и рантайм работают только с его номером
+		return token_type::Id{ runtime::Symbol(s) };
+	}
+
+	// Разбирает строковую константу. Константа без escape-последовательностей возвращается как
+	// участок исходного текста без копирования. Константа с escape-последовательностями
+	// раскодируется в buffer, память буфера переиспользуется между константами
+	std::string_view LoadString(const char*& pos, const char* end, std::string& buffer) {
+		const char starting_symbol = *pos++;
+		const char* begin = pos;
+		pos = SCAN.find_quote_or_backslash(pos, end, starting_symbol);
+
+		std::string_view result(begin, static_cast<size_t>(pos - begin));
+		if (pos != end && *pos == '\\') {
+			// Начало до первой escape-последовательности копируется целиком, дальше константа
+			// раскодируется участками между escape-последовательностями
+			std::string& str = buffer;
+			str.assign(begin, pos);
+			while (pos != end && *pos != starting_symbol) {
+				if (*pos == '\\') {
+					if (++pos == end) {
+						break;
+					}
+					switch (*pos++) {
+					case 'n':
+						str.push_back('\n');
+						break;
+					case 't':
+						str.push_back('\t');
+						break;
+					case '\"':
+						str.push_back('\"');
+						break;
+					case '\'':
+						str.push_back('\'');
+						break;
+					case '\\':
+						str.push_back('\\');
+						break;
+					default:
+						break;
+					}
 				}
-				break;
-			}
-			if (c == ':' && tokens_.back().Is<token_type::Class>()) {
-				input.putback(c);
-				break;
+				const char* run = pos;
+				pos = SCAN.find_quote_or_backslash(pos, end, starting_symbol);
+				str.append(run, pos);
 			}
-			if (c == '(' || c == ')' || c == ',' || c == '.' || c == ':') {
-				input.putback(c);
-				break;
-			}
-			if (c == '\n') {
-				input.putback(c);
-				break;
-			}
-			if (c == ' ' || input.eof()) {
-				break;
-			}
-			s.push_back(c);
+			result = str;
 		}
-		// Определяем является ли он ключевым словом
-		if (KEY_WORDS_MAP.count(s)) {
-			return KEY_WORDS_MAP.at(s);
+		if (result.size() > UINT32_MAX) {
+			throw LexerError("String literal is too long"s);
 		}
+		// Без закрывающей кавычки константа поглотила бы весь остаток программы
+		if (pos == end) {
+			throw LexerError("Unterminated string literal"s);
+		}
+		++pos;
 
-		return token_type::Id{ s };
+		return result;
 	}
 
-	std::string LoadString(std::istream& input) {
-		std::string str;
+	// Пропускает комментарий до конца строки, сам символ конца строки остаётся во входных данных
+	inline void SkipComment(const char*& pos, const char* end) {
+		const void* line_end = std::memchr(pos, '\n', static_cast<size_t>(end - pos));
+		pos = line_end != nullptr ? static_cast<const char*>(line_end) : end;
+	}
 
-		char starting_symbol = input.get();
-		char current_symbol = input.get();
+	inline void SkipSpaces(const char*& pos, const char* end) {
+		pos = SCAN.skip_spaces(pos, end);
+	}
 
-		while (current_symbol != starting_symbol) {
-			if (current_symbol == '\\') {
-				input.get(current_symbol);
-				switch (current_symbol) {
-				case 'n':
-					str.push_back('\n');
-					break;
-				case 't':
-					str.push_back('\t');
-					break;				
-				case '\"':
-					str.push_back('\"');
-					break;
-				case '\'':
-					str.push_back('\'');
-					break;
-				case '\\':
-					str.push_back('\\');
-					break;
-				default:
+	std::string_view Lexer::IndentedBlock() const {
+		// Сразу после Newline следующая строка ещё не начата и токен за Newline не прочитан
+		if (!CurrentToken().Is<token_type::Newline>() || has_lookahead_ || !at_line_start_ || pending_indents_ != 0) {
+			return {};
+		}
+		const char* pos = pos_;
+		const char* block_end = pos_;
+		while (pos != end_) {
+			const char* line_begin = pos;
+			SkipSpaces(pos, end_);
+			if (pos != end_ && *pos == '\n') {
+				++pos;
+				continue;
+			}
+			if (pos != end_ && *pos == '#') {
+				SkipComment(pos, end_);
+				continue;
+			}
+			if (pos == end_ || static_cast<size_t>(pos - line_begin) / 2 <= indent_) {
+				break;
+			}
+			// Дочитываем строку с лексемами. Строковая константа может продолжаться на следующих строках
+			char quote = 0;
+			while (pos != end_) {
+				const char c = *pos++;
+				if (quote != 0) {
+					if (c == '\\') {
+						pos += pos != end_ ? 1 : 0;
+					} else if (c == quote) {
+						quote = 0;
+					}
+				} else if (c == '\n') {
 					break;
+				} else if (c == '\'' || c == '"') {
+					quote = c;
+				} else if (c == '#') {
+					SkipComment(pos, end_);
 				}
 			}
-			else {
-				str.push_back(current_symbol);
-			}
-			input.get(current_symbol);
+			block_end = pos;
 		}
-
-		return str;
+		return { pos_, static_cast<size_t>(block_end - pos_) };
 	}
 
-	inline bool IsNextSpace(std::istream& input) {
-		return input.peek() == ' ';
+	void Lexer::SkipBlock(std::string_view block) {
+		pos_ = block.data() + block.size();
 	}
 
-	void Lexer::LoadTokens(std::istream& input) {
-		char c;
+	Token Lexer::LoadToken(std::string& literal_buffer) {
 		while (true) {
-			input.get(c);
+			// Сначала выдаём накопленные изменения отступа
+			if (pending_indents_ > 0) {
+				--pending_indents_;
+				return token_type::Indent{};
+			}
+			if (pending_indents_ < 0) {
+				++pending_indents_;
+				return token_type::Dedent{};
+			}
 
 			// Считываем наличие/отсутствие отступов
-			if (tokens_.empty() || tokens_.back().Is<token_type::Newline>()) {
-				size_t space_num = 0;
-
-				while (c == ' ') {
-					++space_num;
-					input.get(c);
+			if (at_line_start_) {
+				const char* line_begin = pos_;
+				SkipSpaces(pos_, end_);
+				const auto space_num = static_cast<size_t>(pos_ - line_begin);
+
+				// Строки без лексем (пустые или только с комментарием) не меняют отступ
+				if (pos_ != end_ && *pos_ == '\n') {
+					++pos_;
+					continue;
+				}
+				if (pos_ != end_ && *pos_ == '#') {
+					SkipComment(pos_, end_);
+					continue;
 				}
-				size_t new_indent = space_num / 2;
+				// В конце файла закрываем все открытые блоки
+				const bool at_end = pos_ == end_;
+				const size_t new_indent = at_end ? 0 : space_num / 2;
 
-				if (new_indent > indent_) {
-					for (size_t i = 0; i < (new_indent - indent_); ++i) {
-						tokens_.emplace_back(token_type::Indent{});
-					}
+				pending_indents_ = static_cast<int>(new_indent) - static_cast<int>(indent_);
+				indent_ = new_indent;
+				at_line_start_ = at_end;
+				if (pending_indents_ != 0) {
+					continue;
 				}
-				else if (new_indent < indent_) {
-					for (size_t i = 0; i < (indent_ - new_indent); ++i) {
-						tokens_.emplace_back(token_type::Dedent{});
-					}
+				if (at_end) {
+					return token_type::Eof{};
 				}
-				old_indent_ = indent_;
-				indent_ = new_indent;
 			}
-			// Конец файла
-			if (input.eof()) {
-				if (!tokens_.empty() && (!tokens_.back().Is<token_type::Newline>()
-					&& !tokens_.back().Is<token_type::Indent>()
-					&& !tokens_.back().Is<token_type::Dedent>())) {
-					tokens_.emplace_back(token_type::Newline{});
+
+			SkipSpaces(pos_, end_);
+
+			// Конец строки или конец файла завершают непустую строку лексемой Newline
+			if (pos_ == end_ || *pos_ == '\n') {
+				if (pos_ != end_) {
+					++pos_;
 				}
-				tokens_.emplace_back(token_type::Eof{});
-				break;
+				at_line_start_ = true;
+				if (line_has_tokens_) {
+					line_has_tokens_ = false;
+					return token_type::Newline{};
+				}
+				continue;
 			}
+
+			const char c = *pos_;
+			const CharClass char_class = ClassOf(c);
 			// Игнорируем все символы после символа # до конца строки
-			if (c == '#') {
-				input.ignore(numeric_limits<streamsize>::max(), '\n');
-				if (!input.eof()) {
-					input.putback('\n');
-				}
+			if (char_class == COMMENT) {
+				SkipComment(pos_, end_);
 				continue;
 			}
 
-			// Новая строка
-			if (c == '\n') {
-				// Если символ конца строки, но кроме отступов небыло никаких данных
-				// необходимо стереть все Indent/Dedent и вернуть значение отступа к предыдущему
-				if (!tokens_.empty() && (tokens_.back().Is<token_type::Indent>() || tokens_.back().Is<token_type::Dedent>())) {
-					while (!tokens_.empty() && !tokens_.back().Is<token_type::Newline>()) {
-						tokens_.pop_back();
+			line_has_tokens_ = true;
+
+			switch (char_class) {
+			case DIGIT:
+				return token_type::Number{ LoadNumber(pos_, end_) };
+			case ID_START:
+				return LoadIdentifier(pos_, end_);
+			case QUOTE:
+				return token_type::String{ LoadString(pos_, end_, literal_buffer) };
+			case COMPARISON:
+				// Двухсимвольные операторы сравнения
+				if (pos_ + 1 != end_ && pos_[1] == '=') {
+					pos_ += 2;
+					switch (c) {
+					case '!':
+						return token_type::NotEq{};
+					case '=':
+						return token_type::Eq{};
+					case '<':
+						return token_type::LessOrEq{};
+					default:
+						return token_type::GreaterOrEq{};
 					}
-					indent_ = old_indent_;
 				}
-				else if (!(tokens_.empty() || tokens_.back().Is<token_type::Newline>())) {
-					tokens_.emplace_back(token_type::Newline{});
-				}
-			}
-			// Арифмитические символы и символы сравнения
-			else if (c == '!' && input.peek() == '=') {
-				tokens_.emplace_back(token_type::NotEq{});
-				input.ignore(1);
-			}
-			else if (c == '=' && input.peek() == '=') {
-				tokens_.emplace_back(token_type::Eq{});
-				input.ignore(1);
-			}
-			else if (c == '<' && input.peek() == '=') {
-				tokens_.emplace_back(token_type::LessOrEq{});
-				input.ignore(1);
-			}
-			else if (c == '>' && input.peek() == '=') {
-				tokens_.emplace_back(token_type::GreaterOrEq{});
-				input.ignore(1);
-			}
-
-			else if (c == '+' || c == '-' || c == '*' || c == '/') {
-				tokens_.emplace_back(token_type::Char{ c });
-			}
-			else if (c == '=' || c == '<' || c == '>') {
-				tokens_.emplace_back(token_type::Char{ c });
-			}
-			// Начинается с цифры или знака минус
-			else if (std::isdigit(c)) {
-				input.putback(c);
-				tokens_.emplace_back(token_type::Number{ LoadNumber(input) });
-			}
-			// Идентификатор начинается с буквы или символа подчеркивания
-			else if (std::isalpha(c) || c == '_') {
-				input.putback(c);
-				tokens_.emplace_back(LoadIdentifier(input));
-			}
-			// Строки начинаются с одинарных или двойных кавычек
-			else if (c == '\'' || c == '"') {
-				input.putback(c);
-				tokens_.emplace_back(token_type::String{ LoadString(input) });
+				break;
+			default:
+				break;
 			}
 
-			else if (c == '=' && IsNextSpace(input)) {
-				tokens_.emplace_back(token_type::Char{ c });
-			}
-			else if (c != ' ') {
-				tokens_.emplace_back(token_type::Char{ c });
-			}
+			++pos_;
+			// Арифметические символы, символы сравнения и прочие одиночные символы
+			return token_type::Char{ c };
 		}
 	}
 
-}  // namespace parse
\ No newline at end of file
+}  // namespace parse
@@ -1,179 +1,335 @@
-#pragma once
-
-#include <iosfwd>
-#include <optional>
-#include <sstream>
-#include <stdexcept>
-#include <string>
-#include <variant>
-#include <vector>
-#include <unordered_map>
-#include <algorithm>
-#include <charconv>
-#include <unordered_map>
-#include <limits>
-
-namespace parse {
-
-	namespace token_type {
-
-		struct Number {  // Лексема «число»
-			int value;   // число
-		};
-
-		struct Id {             // Лексема «идентификатор»
-			std::string value;  // Имя идентификатора
-		};
-
-		struct Char {    // Лексема «символ»
-			char value;  // код символа
-		};
-
-		struct String {  // Лексема «строковая константа»
-			std::string value;
-		};
-
-		struct Class {};    // Лексема «class»
-		struct Return {};   // Лексема «return»
-		struct If {};       // Лексема «if»
-		struct Else {};     // Лексема «else»
-		struct Def {};      // Лексема «def»
-		struct Newline {};  // Лексема «конец строки»
-		struct Print {};    // Лексема «print»
-		struct Indent {};  // Лексема «увеличение отступа», соответствует двум пробелам
-		struct Dedent {};  // Лексема «уменьшение отступа»
-		struct Eof {};     // Лексема «конец файла»
-		struct And {};     // Лексема «and»
-		struct Or {};      // Лексема «or»
-		struct Not {};     // Лексема «not»
-		struct Eq {};      // Лексема «==»
-		struct NotEq {};   // Лексема «!=»
-		struct LessOrEq {};     // Лексема «<=»
-		struct GreaterOrEq {};  // Лексема «>=»
-		struct None {};         // Лексема «None»
-		struct True {};         // Лексема «True»
-		struct False {};        // Лексема «False»
-	} // namespace token_type
-
-	using TokenBase
-		= std::variant<token_type::Number, token_type::Id, token_type::Char, token_type::String,
-		token_type::Class, token_type::Return, token_type::If, token_type::Else,
-		token_type::Def, token_type::Newline, token_type::Print, token_type::Indent,
-		token_type::Dedent, token_type::And, token_type::Or, token_type::Not,
-		token_type::Eq, token_type::NotEq, token_type::LessOrEq, token_type::GreaterOrEq,
-		token_type::None, token_type::True, token_type::False, token_type::Eof>;
-
-	struct Token : TokenBase {
-		using TokenBase::TokenBase;
-
-		template <typename T>
-		[[nodiscard]] bool Is() const {
-			return std::holds_alternative<T>(*this);
-		}
-
-		template <typename T>
-		[[nodiscard]] const T& As() const {
-			return std::get<T>(*this);
-		}
-
-		template <typename T>
-		[[nodiscard]] const T* TryAs() const {
-			return std::get_if<T>(this);
-		}
-	};
-
-	bool operator==(const Token& lhs, const Token& rhs);
-	bool operator!=(const Token& lhs, const Token& rhs);
-
-	std::ostream& operator<<(std::ostream& os, const Token& rhs);
-
-	class LexerError : public std::runtime_error {
-	public:
-		using std::runtime_error::runtime_error;
-	};
-
-	class Lexer {
-	public:
-		explicit Lexer(std::istream& input);
-
-		// Возвращает ссылку на текущий токен или token_type::Eof, если поток токенов закончился
-		[[nodiscard]] const Token& CurrentToken() const;
-
-		// Возвращает следующий токен, либо token_type::Eof, если поток токенов закончился
-		Token NextToken();
-
-		// Если текущий токен имеет тип T, метод возвращает ссылку на него.
-		// В противном случае метод выбрасывает исключение LexerError
-		template <typename T>
-		const T& Expect() const {
-			using namespace std::literals;
-
-			if (tokens_[current_token_].Is<T>()) {
-				return tokens_.at(current_token_).As<T>();
-			}
-			else {
-				throw LexerError("Wrong token type!"s);
-			}
-		}
-
-		// Метод проверяет, что текущий токен имеет тип T, а сам токен содержит значение value.
-		// В противном случае метод выбрасывает исключение LexerError
-		template <typename T, typename U>
-		void Expect(const U& value) const {
-			using namespace std::literals;
-
-			if (!tokens_[current_token_].Is<T>()) {
-				throw LexerError("Wrong token type!"s);
-			}
-
-			const auto result = tokens_[current_token_].TryAs<T>();
-			if ((*result).value != value) {
-				throw LexerError("Wrong token value!"s);
-			}
-		}
-
-		// Если следующий токен имеет тип T, метод возвращает ссылку на него.
-		// В противном случае метод выбрасывает исключение LexerError
-		template <typename T>
-		const T& ExpectNext() {
-			using namespace std::literals;
-
-			if (tokens_[current_token_ + 1].Is<T>()) {
-				++current_token_;
-				return tokens_.at(current_token_).As<T>();
-			}
-			else {
-				throw LexerError("Wrong token type!"s);
-			}
-		}
-
-		// Метод проверяет, что следующий токен имеет тип T, а сам токен содержит значение value.
-		// В противном случае метод выбрасывает исключение LexerError
-		template <typename T, typename U>
-		void ExpectNext(const U& value) {
-			using namespace std::literals;
-
-			if (!tokens_[current_token_ + 1].Is<T>()) {
-				throw LexerError("Wrong token type!"s);
-			}
-
-			const auto result = tokens_[current_token_ + 1].TryAs<T>();
-			if ((*result).value != value) {
-				throw LexerError("Wrong token value!"s);
-			}
-			++current_token_;
-		}
-
-	private:
-		std::vector<Token> tokens_;
-		size_t current_token_ = 0;
-		// Один отступ - 2 пробела
-		size_t indent_ = 0;
-		size_t old_indent_ = 0;
-
-
-		void LoadTokens(std::istream& input);
-		Token LoadIdentifier(std::istream& input);
-	};
-
-}  // namespace parse
\ No newline at end of file
+#pragma once
+
+#include "symbol.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+
+namespace parse {
+
+	namespace token_type {
+
+		struct Number {  // Лексема «число»
+			int value;   // число
+		};
+
+		struct Id {                 // Лексема «идентификатор»
+			runtime::Symbol value;  // Имя идентификатора, интернированное в таблице символов
+		};
+
+		struct Char {    // Лексема «символ»
+			char value;  // код символа
+		};
+
+		struct String {               // Лексема «строковая константа»
+			std::string_view value;  // Текст константы: участок исходного текста или, если в константе
+			                         // есть escape-последовательности, раскодированный текст в буфере
+			                         // лексера. Такой текст действителен, пока действительна лексема
+		};
+
+		struct Class {};    // Лексема «class»
+		struct Return {};   // Лексема «return»
+		struct If {};       // Лексема «if»
+		struct Else {};     // Лексема «else»
+		struct Def {};      // Лексема «def»
+		struct Newline {};  // Лексема «конец строки»
+		struct Print {};    // Лексема «print»
+		struct Indent {};  // Лексема «увеличение отступа», соответствует двум пробелам
+		struct Dedent {};  // Лексема «уменьшение отступа»
+		struct Eof {};     // Лексема «конец файла»
+		struct And {};     // Лексема «and»
+		struct Or {};      // Лексема «or»
+		struct Not {};     // Лексема «not»
+		struct Eq {};      // Лексема «==»
+		struct NotEq {};   // Лексема «!=»
+		struct LessOrEq {};     // Лексема «<=»
+		struct GreaterOrEq {};  // Лексема «>=»
+		struct None {};         // Лексема «None»
+		struct True {};         // Лексема «True»
+		struct False {};        // Лексема «False»
+	} // namespace token_type
+
+	// Вид лексемы
+	enum class TokenKind : std::uint8_t {
+		Number, Id, Char, String, Class, Return, If, Else, Def, Newline, Print, Indent,
+		Dedent, And, Or, Not, Eq, NotEq, LessOrEq, GreaterOrEq, None, True, False, Eof,
+	};
+
+	// Вид лексемы, соответствующий типу token_type::T
+	template <typename T>
+	inline constexpr bool IS_TOKEN_TYPE = false;
+	template <typename T>
+	inline constexpr TokenKind TOKEN_KIND = TokenKind::Eof;
+
+#define DECLARE_TOKEN_KIND(type) \
+	template <> \
+	inline constexpr bool IS_TOKEN_TYPE<token_type::type> = true; \
+	template <> \
+	inline constexpr TokenKind TOKEN_KIND<token_type::type> = TokenKind::type;
+
+	DECLARE_TOKEN_KIND(Number)
+	DECLARE_TOKEN_KIND(Id)
+	DECLARE_TOKEN_KIND(Char)
+	DECLARE_TOKEN_KIND(String)
+	DECLARE_TOKEN_KIND(Class)
+	DECLARE_TOKEN_KIND(Return)
+	DECLARE_TOKEN_KIND(If)
+	DECLARE_TOKEN_KIND(Else)
+	DECLARE_TOKEN_KIND(Def)
+	DECLARE_TOKEN_KIND(Newline)
+	DECLARE_TOKEN_KIND(Print)
+	DECLARE_TOKEN_KIND(Indent)
+	DECLARE_TOKEN_KIND(Dedent)
+	DECLARE_TOKEN_KIND(And)
+	DECLARE_TOKEN_KIND(Or)
+	DECLARE_TOKEN_KIND(Not)
+	DECLARE_TOKEN_KIND(Eq)
+	DECLARE_TOKEN_KIND(NotEq)
+	DECLARE_TOKEN_KIND(LessOrEq)
+	DECLARE_TOKEN_KIND(GreaterOrEq)
+	DECLARE_TOKEN_KIND(None)
+	DECLARE_TOKEN_KIND(True)
+	DECLARE_TOKEN_KIND(False)
+	DECLARE_TOKEN_KIND(Eof)
+
+#undef DECLARE_TOKEN_KIND
+
+	// Компактная лексема: вид и 32-битное значение. Для чисел и символов значение хранится прямо
+	// в лексеме, для идентификаторов - номер в таблице символов, для строковых констант - длина
+	// текста, а указатель на сам текст лежит отдельно. Строки не копируются и не интернируются,
+	// лексема занимает 16 байт и копируется без выделения памяти
+	class Token {
+	public:
+		// Создаёт лексему Eof
+		Token() = default;
+
+		template <typename T, typename = std::enable_if_t<IS_TOKEN_TYPE<T>>>
+		constexpr Token(const T& value)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+			: kind_(TOKEN_KIND<T>), payload_(Pack(value)), text_(PackText(value)) {
+		}
+
+		[[nodiscard]] constexpr TokenKind Kind() const {
+			return kind_;
+		}
+
+		template <typename T>
+		[[nodiscard]] constexpr bool Is() const {
+			return kind_ == TOKEN_KIND<T>;
+		}
+
+		// Возвращает значение лексемы типа T. Если лексема другого типа, выбрасывает
+		// std::bad_variant_access
+		template <typename T>
+		[[nodiscard]] T As() const {
+			if (!Is<T>()) {
+				throw std::bad_variant_access();
+			}
+			return Unpack<T>();
+		}
+
+		// Возвращает значение лексемы типа T или nullopt, если лексема другого типа
+		template <typename T>
+		[[nodiscard]] std::optional<T> TryAs() const {
+			if (!Is<T>()) {
+				return std::nullopt;
+			}
+			return Unpack<T>();
+		}
+
+		// Строковые константы сравниваются по тексту, остальные лексемы - по значению
+		friend bool operator==(const Token& lhs, const Token& rhs) {
+			if (lhs.kind_ != rhs.kind_ || lhs.payload_ != rhs.payload_) {
+				return false;
+			}
+			return lhs.kind_ != TokenKind::String
+				|| std::string_view(lhs.text_, lhs.payload_) == std::string_view(rhs.text_, rhs.payload_);
+		}
+
+		friend bool operator!=(const Token& lhs, const Token& rhs) {
+			return !(lhs == rhs);
+		}
+
+	private:
+		template <typename T>
+		static constexpr std::uint32_t Pack(const T& value) {
+			if constexpr (std::is_same_v<T, token_type::Number>) {
+				return static_cast<std::uint32_t>(value.value);
+			} else if constexpr (std::is_same_v<T, token_type::Char>) {
+				return static_cast<unsigned char>(value.value);
+			} else if constexpr (std::is_same_v<T, token_type::Id>) {
+				return value.value.Id();
+			} else if constexpr (std::is_same_v<T, token_type::String>) {
+				return static_cast<std::uint32_t>(value.value.size());
+			} else {
+				return 0;
+			}
+		}
+
+		template <typename T>
+		static constexpr const char* PackText(const T& value) {
+			if constexpr (std::is_same_v<T, token_type::String>) {
+				return value.value.data();
+			} else {
+				return nullptr;
+			}
+		}
+
+		template <typename T>
+		[[nodiscard]] T Unpack() const {
+			if constexpr (std::is_same_v<T, token_type::Number>) {
+				return T{ static_cast<int>(payload_) };
+			} else if constexpr (std::is_same_v<T, token_type::Char>) {
+				return T{ static_cast<char>(payload_) };
+			} else if constexpr (std::is_same_v<T, token_type::Id>) {
+				return T{ runtime::Symbol::FromId(payload_) };
+			} else if constexpr (std::is_same_v<T, token_type::String>) {
+				return T{ std::string_view(text_, payload_) };
+			} else {
+				return T{};
+			}
+		}
+
+		TokenKind kind_ = TokenKind::Eof;
+		std::uint32_t payload_ = 0;
+		// Начало текста строковой константы
+		const char* text_ = nullptr;
+	};
+
+	std::ostream& operator<<(std::ostream& os, const Token& rhs);
+
+	class LexerError : public std::runtime_error {
+	public:
+		using std::runtime_error::runtime_error;
+	};
+
+	class Lexer {
+	public:
+		// Считывает поток input целиком в собственный буфер и разбирает лексемы из него
+		explicit Lexer(std::istream& input);
+		// Разбирает лексемы прямо из source без копирования. Память, на которую ссылается source,
+		// должна существовать всё время работы лексера и пока используются тексты строковых констант
+		// без escape-последовательностей из его лексем
+		explicit Lexer(std::string_view source);
+
+		// Лексер хранит указатели внутрь своего буфера, поэтому не копируется
+		Lexer(const Lexer&) = delete;
+		Lexer& operator=(const Lexer&) = delete;
+
+		// Возвращает ссылку на текущий токен или token_type::Eof, если поток токенов закончился.
+		// Ссылка остаётся действительной до второго следующего вызова NextToken/ExpectNext
+		[[nodiscard]] const Token& CurrentToken() const;
+
+		// Возвращает ссылку на следующий токен, либо token_type::Eof, если поток токенов закончился.
+		// Ссылка действительна так же, как ссылка из CurrentToken()
+		const Token& NextToken();
+
+		// Если текущий токен имеет тип T, метод возвращает его значение.
+		// В противном случае метод выбрасывает исключение LexerError
+		template <typename T>
+		T Expect() const {
+			using namespace std::literals;
+
+			if (const auto result = CurrentToken().TryAs<T>()) {
+				return *result;
+			}
+			throw LexerError("Wrong token type!"s);
+		}
+
+		// Метод проверяет, что текущий токен имеет тип T, а сам токен содержит значение value.
+		// В противном случае метод выбрасывает исключение LexerError
+		template <typename T, typename U>
+		void Expect(const U& value) const {
+			using namespace std::literals;
+
+			if (Expect<T>().value != value) {
+				throw LexerError("Wrong token value!"s);
+			}
+		}
+
+		// Если следующий токен имеет тип T, метод делает его текущим и возвращает его значение.
+		// В противном случае метод выбрасывает исключение LexerError
+		template <typename T>
+		T ExpectNext() {
+			using namespace std::literals;
+
+			if (!PeekToken().Is<T>()) {
+				throw LexerError("Wrong token type!"s);
+			}
+			Advance();
+			return CurrentToken().As<T>();
+		}
+
+		// Метод проверяет, что следующий токен имеет тип T, а сам токен содержит значение value.
+		// В противном случае метод выбрасывает исключение LexerError
+		template <typename T, typename U>
+		void ExpectNext(const U& value) {
+			using namespace std::literals;
+
+			const auto result = PeekToken().TryAs<T>();
+			if (!result) {
+				throw LexerError("Wrong token type!"s);
+			}
+			if (result->value != value) {
+				throw LexerError("Wrong token value!"s);
+			}
+			Advance();
+		}
+
+		// Возвращает текст блока строк с отступом больше текущего, который начинается сразу за
+		// текущей лексемой Newline, например тела метода. Блок заканчивается перед первой строкой
+		// с лексемами, отступ которой не больше текущего. Если за Newline нет такого блока
+		// или текущая лексема - не Newline, возвращает пустую строку
+		[[nodiscard]] std::string_view IndentedBlock() const;
+
+		// Пропускает блок, полученный от IndentedBlock, не разбирая его на лексемы. Текущей
+		// остаётся лексема Newline, следующей будет первая лексема после блока
+		void SkipBlock(std::string_view block);
+
+		// Возвращает текущий отступ - число отступов строки последней выданной лексемы
+		[[nodiscard]] size_t CurrentIndent() const {
+			return indent_;
+		}
+
+	private:
+		// Возвращает токен, следующий за текущим, не сдвигая текущую позицию
+		const Token& PeekToken();
+		// Делает текущим следующий токен. После Eof позиция не меняется
+		void Advance();
+		// Начинает разбор лексем из source
+		void Reset(std::string_view source);
+		// Разбирает ровно один очередной токен. Строковая константа с escape-последовательностями
+		// раскодируется в literal_buffer
+		Token LoadToken(std::string& literal_buffer);
+
+		// Исходный текст, если лексер создан из потока
+		std::string owned_source_;
+		// Буферы для раскодирования строковых констант с escape-последовательностями, по одному
+		// на каждый токен кольцевого буфера. Константа раскодируется один раз при разборе токена
+		std::string literal_buffers_[2];
+		// Ещё не разобранная часть исходного текста
+		const char* pos_ = nullptr;
+		const char* end_ = nullptr;
+
+		// Кольцевой буфер на два токена: текущий и, если его уже запросили, следующий.
+		// Токены разбираются по одному, поэтому их число в памяти не зависит от размера программы
+		Token ring_[2];
+		size_t current_ = 0;
+		bool has_lookahead_ = false;
+
+		// Один отступ - 2 пробела
+		size_t indent_ = 0;
+		// Сколько токенов Indent (> 0) или Dedent (< 0) осталось выдать перед следующей лексемой
+		int pending_indents_ = 0;
+		// Следующий символ потока - начало новой строки
+		bool at_line_start_ = true;
+		// В текущей строке уже выдана хотя бы одна лексема, и в её конце нужен Newline
+		bool line_has_tokens_ = false;
+	};
+
+}  // namespace parse
@@ -77,6 +77,16 @@ void TestStrings() {
                  Token(token_type::String{"another long string with single quote ' inside"s}));
 }
 
+void TestUnterminatedStrings() {
+    // Константа без закрывающей кавычки - ошибка, а не строка до конца программы
+    for (const string& source : {"x = \"abc\nprint x\n"s, "x = 'abc"s, "x = 'a\\n\\"s, "x = '"s}) {
+        Lexer lexer(string_view{source});
+        ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{"x"s}));
+        ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'='}));
+        ASSERT_THROWS(lexer.NextToken(), LexerError);
+    }
+}
+
 void TestOperations() {
     istringstream input("+-*/= > < != == <> <= >="s);
     Lexer lexer(input);
@@ -351,14 +361,166 @@ abc#
         ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
     }
 }
+
+void TestTokensAreReadOnDemand() {
+    // Слишком большое число во второй строке обнаруживается, только когда до него дойдёт разбор
+    const string source = "x = 1\nlong_identifier = 99999999999999999999\n"s;
+    Lexer lexer(string_view{source});
+
+    ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{"x"s}));
+    ASSERT_DOESNT_THROW(lexer.ExpectNext<token_type::Char>('='));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{1}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"long_identifier"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'='}));
+    ASSERT_THROWS(lexer.NextToken(), LexerError);
+}
+
+void TestBufferAndStreamGiveSameTokens() {
+    const string source = "class A:\n  def f(x):\n    return 'a\\'b' + x # comment\n\nprint A().f(\"c\")"s;
+    istringstream input(source);
+    Lexer from_stream(input);
+    Lexer from_buffer(string_view{source});
+
+    ASSERT_EQUAL(from_stream.CurrentToken(), from_buffer.CurrentToken());
+    while (!from_stream.CurrentToken().Is<token_type::Eof>()) {
+        ASSERT_EQUAL(from_stream.NextToken(), from_buffer.NextToken());
+    }
+    ASSERT_EQUAL(from_buffer.CurrentToken(), Token(token_type::Eof{}));
+}
+
+void TestBlocksAreClosedAtEof() {
+    istringstream input("if x:\n  y = z+1"s);
+    Lexer lexer(input);
+
+    ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::If{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"x"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{':'}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"y"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'='}));
+    // Идентификатор заканчивается на первом символе, который не может в него входить
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"z"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'+'}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{1}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+}
+
+void TestKeywordPrefixesAreIds() {
+    istringstream input("classes iff or_ Non el3e _def returned print1 x=y!=z<=w>=v"s);
+    Lexer lexer(input);
+
+    ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{"classes"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"iff"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"or_"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"Non"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"el3e"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"_def"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"returned"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"print1"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"x"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'='}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"y"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::NotEq{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"z"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::LessOrEq{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"w"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::GreaterOrEq{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"v"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+}
 }  // namespace
 
+void TestStringLiteralsAreViewsIntoSource() {
+    const string source = "x = 'plain' + \"esc\\taped\\n\" + '\\'q\\''\n"s;
+    const string_view text = source;
+    Lexer lexer(text);
+
+    const auto in_source = [&text](string_view literal) {
+        return literal.data() >= text.data() && literal.data() + literal.size() <= text.data() + text.size();
+    };
+
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'='}));
+    const auto plain = lexer.NextToken().As<token_type::String>().value;
+    ASSERT_EQUAL(plain, "plain"sv);
+    ASSERT(in_source(plain));
+
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'+'}));
+    const auto escaped = lexer.NextToken().As<token_type::String>().value;
+    ASSERT_EQUAL(escaped, "esc\taped\n"sv);
+    ASSERT(!in_source(escaped));
+
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'+'}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{"'q'"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+
+    // Константа без escape-последовательностей ссылается на исходный текст и после разбора
+    // следующих лексем
+    ASSERT_EQUAL(plain, "plain"sv);
+}
+
+void TestSkipsIndentedBlock() {
+    const string_view source = "class A:\n"
+                               "  def f():  # header\n"
+                               "    x = 'a\n"
+                               "  b'\n"
+                               "\n"
+                               "   # note\n"
+                               "    if x:\n"
+                               "      y = \"\\\"\"\n"
+                               "  # comment\n"
+                               "  def g():\n"
+                               "    return 1\n"
+                               "x = 1\n"sv;
+    Lexer lexer(source);
+    // Блока нет, если текущая лексема - не Newline
+    ASSERT(lexer.IndentedBlock().empty());
+    while (!lexer.CurrentToken().Is<token_type::Newline>()) {
+        lexer.NextToken();
+    }
+    // За заголовком класса следует строка def с отступом 1, а сам класс начинается без отступа
+    ASSERT_EQUAL(lexer.IndentedBlock().size(), source.find("x = 1"sv) - source.find("  def f"sv));
+
+    for (int i = 0; i < 7; ++i) {
+        lexer.NextToken();
+    }
+    ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Newline{}));
+    ASSERT_EQUAL(lexer.CurrentIndent(), 1U);
+    // Строки внутри строковой константы и комментарии с меньшим отступом блок не заканчивают
+    const string_view block = lexer.IndentedBlock();
+    ASSERT_EQUAL(block, source.substr(source.find("    x"sv), source.find("  # comment"sv) - source.find("    x"sv)));
+    lexer.SkipBlock(block);
+    ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Newline{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Def{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"g"s}));
+    for (int i = 0; i < 4; ++i) {
+        lexer.NextToken();
+    }
+    lexer.SkipBlock(lexer.IndentedBlock());
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"x"s}));
+
+    // Тело метода без отступа - не блок
+    Lexer no_block("def f():\nx = 1\n"sv);
+    for (int i = 0; i < 5; ++i) {
+        no_block.NextToken();
+    }
+    ASSERT_EQUAL(no_block.CurrentToken(), Token(token_type::Newline{}));
+    ASSERT(no_block.IndentedBlock().empty());
+}
+
 void RunOpenLexerTests(TestRunner& tr) {
     RUN_TEST(tr, parse::TestSimpleAssignment);
     RUN_TEST(tr, parse::TestKeywords);
     RUN_TEST(tr, parse::TestNumbers);
     RUN_TEST(tr, parse::TestIds);
     RUN_TEST(tr, parse::TestStrings);
+    RUN_TEST(tr, parse::TestUnterminatedStrings);
     RUN_TEST(tr, parse::TestOperations);
     RUN_TEST(tr, parse::TestIndentsAndNewlines);
     RUN_TEST(tr, parse::TestEmptyLinesAreIgnored);
@@ -367,6 +529,12 @@ void RunOpenLexerTests(TestRunner& tr) {
     RUN_TEST(tr, parse::TestMythonProgram);
     RUN_TEST(tr, parse::TestAlwaysEmitsNewlineAtTheEndOfNonemptyLine);
     RUN_TEST(tr, parse::TestCommentsAreIgnored);
+    RUN_TEST(tr, parse::TestTokensAreReadOnDemand);
+    RUN_TEST(tr, parse::TestBufferAndStreamGiveSameTokens);
+    RUN_TEST(tr, parse::TestBlocksAreClosedAtEof);
+    RUN_TEST(tr, parse::TestKeywordPrefixesAreIds);
+    RUN_TEST(tr, parse::TestStringLiteralsAreViewsIntoSource);
+    RUN_TEST(tr, parse::TestSkipsIndentedBlock);
 }
 
 }  // namespace parse
\ No newline at end of file
@@ -1,140 +1,192 @@
-#include "lexer.h"
-#include "parse.h"
-#include "runtime.h"
-#include "statement.h"
-#include "test_runner_p.h"
-
-#include <iostream>
-
-using namespace std;
-
-namespace parse {
-void RunOpenLexerTests(TestRunner& tr);
-}  // namespace parse
-
-namespace ast {
-void RunUnitTests(TestRunner& tr);
-}
-namespace runtime {
-void RunObjectHolderTests(TestRunner& tr);
-void RunObjectsTests(TestRunner& tr);
-}  // namespace runtime
-
-void TestParseProgram(TestRunner& tr);
-
-namespace {
-
-void RunMythonProgram(istream& input, ostream& output) {
-    parse::Lexer lexer(input);
-    auto program = ParseProgram(lexer);
-
-    runtime::SimpleContext context{output};
-    runtime::Closure closure;
-    program->Execute(closure, context);
-}
-
-void TestSimplePrints() {
-    istringstream input(R"(
-print 57
-print 10, 24, -8
-print 'hello'
-print "world"
-print True, False
-print
-print None
-)");
-
-    ostringstream output;
-    RunMythonProgram(input, output);
-
-    ASSERT_EQUAL(output.str(), "57\n10 24 -8\nhello\nworld\nTrue False\n\nNone\n");
-}
-
-void TestAssignments() {
-    istringstream input(R"(
-x = 57
-print x
-x = 'C++ black belt'
-print x
-y = False
-x = y
-print x
-x = None
-print x, y
-)");
-
-    ostringstream output;
-    RunMythonProgram(input, output);
-
-    ASSERT_EQUAL(output.str(), "57\nC++ black belt\nFalse\nNone False\n");
-}
-
-void TestArithmetics() {
-    istringstream input("print 1+2+3+4+5, 1*2*3*4*5, 1-2-3-4-5, 36/4/3, 2*5+10/2");
-
-    ostringstream output;
-    RunMythonProgram(input, output);
-
-    ASSERT_EQUAL(output.str(), "15 120 -13 3 15\n");
-}
-
-void TestVariablesArePointers() {
-    istringstream input(R"(
-class Counter:
-  def __init__():
-    self.value = 0
-
-  def add():
-    self.value = self.value + 1
-
-class Dummy:
-  def do_add(counter):
-    counter.add()
-
-x = Counter()
-y = x
-
-x.add()
-y.add()
-
-print x.value
-
-d = Dummy()
-d.do_add(x)
-
-print y.value
-)");
-
-    ostringstream output;
-    RunMythonProgram(input, output);
-
-    ASSERT_EQUAL(output.str(), "2\n3\n");
-}
-
-void TestAll() {
-    TestRunner tr;
-    parse::RunOpenLexerTests(tr);
-    runtime::RunObjectHolderTests(tr);
-    runtime::RunObjectsTests(tr);
-    ast::RunUnitTests(tr);
-    TestParseProgram(tr);
-
-    RUN_TEST(tr, TestSimplePrints);
-    RUN_TEST(tr, TestAssignments);
-    RUN_TEST(tr, TestArithmetics);
-    RUN_TEST(tr, TestVariablesArePointers);
-}
-
-}  // namespace
-
-int main() {
-    try {
-        TestAll();
-
-        RunMythonProgram(cin, cout);
-    } catch (const std::exception& e) {
-        std::cerr << e.what() << std::endl;
-		return 1;
-    }
-    return 0;
-}
\ No newline at end of file
+#include "bytecode.h"
+#include "closure_compiler.h"
+#include "optimize.h"
+#include "parallel_parse.h"
+#include "runtime.h"
+#include "source_file.h"
+#include "statement.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const char USAGE[] = R"(Usage: mython [--check] [--timings] [--no-optimize] [--engine=NAME] [script ...]
+
+Runs each script in turn. If no script is given (or the name is "-"),
+the program is read from the standard input.
+
+  --check        only lex and parse the scripts, do not execute them;
+                 method bodies are parsed too (a normal run parses a method
+                 body when the method is first called)
+  --timings      print the time spent in every phase to stderr
+                 (read, lex+parse, optimize, compile, execute)
+  --no-optimize  execute the program as parsed, without constant folding
+  --engine=NAME  how to execute the program: "tree" walks the syntax tree
+                 (the default), "vm" compiles it to bytecode and runs the
+                 bytecode virtual machine, "closure" compiles every node
+                 into a C++ function with its operands bound in advance
+  --help         print this message
+)";
+
+// Способ выполнения программы
+enum class Engine {
+    // Обход дерева программы
+    TREE,
+    // Байт-код и виртуальная машина (bytecode.h)
+    VM,
+    // Дерево, скомпилированное в замыкания (closure_compiler.h)
+    CLOSURE,
+};
+
+struct Options {
+    bool check_only = false;
+    bool timings = false;
+    bool optimize = true;
+    Engine engine = Engine::TREE;
+    vector<string> scripts;
+};
+
+class PhaseTimer {
+public:
+    explicit PhaseTimer(bool enabled)
+        : enabled_(enabled) {
+    }
+
+    // Выполняет action и, если замеры включены, запоминает время его работы под именем phase
+    template <typename Action>
+    auto Measure(const char* phase, Action&& action) {
+        const auto start = chrono::steady_clock::now();
+        if constexpr (is_void_v<decltype(action())>) {
+            action();
+            Record(phase, start);
+        } else {
+            auto result = action();
+            Record(phase, start);
+            return result;
+        }
+    }
+
+    void Report(const string& script, ostream& os) const {
+        if (!enabled_) {
+            return;
+        }
+        os << script << ':' << '\n';
+        for (const auto& [phase, ms] : phases_) {
+            os << "  " << phase << ": " << ms << " ms\n";
+        }
+    }
+
+private:
+    void Record(const char* phase, chrono::steady_clock::time_point start) {
+        if (enabled_) {
+            const chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+            phases_.emplace_back(phase, elapsed.count());
+        }
+    }
+
+    bool enabled_;
+    vector<pair<const char*, double>> phases_;
+};
+
+void RunScript(const string& path, const Options& options, ostream& output) {
+    PhaseTimer timer(options.timings);
+
+    // Обычный файл отображается в память, и лексер читает его без копирования
+    const parse::SourceFile source = timer.Measure("read", [&path] {
+        return parse::SourceFile(path);
+    });
+
+    // Лексемы разбираются по мере надобности парсеру, поэтому лексер и парсер замеряются вместе.
+    // Большие файлы разбираются по частям в нескольких потоках. Тела методов при выполнении
+    // разбираются при первом вызове, а при проверке - сразу, чтобы найти ошибки в них
+    const BodyParsing bodies = options.check_only ? BodyParsing::EAGER : BodyParsing::LAZY;
+    auto program = timer.Measure("lex+parse", [&source, bodies] {
+        return ParseProgramParallel(source.Text(), 0, bodies);
+    });
+
+    // При проверке программа только разбирается
+    if (options.optimize && !options.check_only) {
+        timer.Measure("optimize", [&program] {
+            ast::Optimize(*program);
+        });
+    }
+
+    if (!options.check_only) {
+        // Скомпилированная программа ссылается на дерево, поэтому дерево живёт до конца выполнения
+        unique_ptr<runtime::Executable> compiled;
+        if (options.engine == Engine::VM) {
+            compiled = timer.Measure("compile", [&program] {
+                return vm::Compile(*program);
+            });
+        } else if (options.engine == Engine::CLOSURE) {
+            compiled = timer.Measure("compile", [&program] {
+                return closure_compiler::Compile(*program);
+            });
+        }
+        runtime::Executable& executable = compiled != nullptr ? *compiled : *program;
+        timer.Measure("execute", [&executable, &output] {
+            runtime::SimpleContext context{output};
+            runtime::Closure closure;
+            executable.Execute(closure, context);
+            output.flush();
+        });
+    }
+
+    timer.Report(path == "-"s ? "<stdin>"s : path, cerr);
+}
+
+Options ParseOptions(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        if (arg == "--check"sv) {
+            options.check_only = true;
+        } else if (arg == "--timings"sv) {
+            options.timings = true;
+        } else if (arg == "--no-optimize"sv) {
+            options.optimize = false;
+        } else if (arg == "--engine=tree"sv) {
+            options.engine = Engine::TREE;
+        } else if (arg == "--engine=vm"sv) {
+            options.engine = Engine::VM;
+        } else if (arg == "--engine=closure"sv) {
+            options.engine = Engine::CLOSURE;
+        } else if (arg == "--help"sv) {
+            cout << USAGE;
+            exit(0);
+        } else if (arg.size() > 1 && arg.substr(0, 2) == "--"sv) {
+            throw invalid_argument("Unknown option "s + string(arg) + "\n\n"s + USAGE);
+        } else {
+            options.scripts.emplace_back(arg);
+        }
+    }
+    if (options.scripts.empty()) {
+        options.scripts.emplace_back("-"s);
+    }
+    return options;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    ios::sync_with_stdio(false);
+
+    try {
+        const Options options = ParseOptions(argc, argv);
+        for (const auto& script : options.scripts) {
+            RunScript(script, options, cout);
+        }
+    } catch (const std::exception& e) {
+        cout.flush();
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
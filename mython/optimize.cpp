@@ -0,0 +1,244 @@
+#include "optimize.h"
+
+#include "dataflow.h"
+#include "reachability.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace ast {
+
+namespace {
+
+const runtime::Number* TryNumber(const Statement* node) {
+    const auto* constant = dynamic_cast<const NumericConst*>(node);
+    return constant != nullptr ? &constant->GetValue() : nullptr;
+}
+
+bool FitsInt(int64_t value) {
+    return value >= numeric_limits<int>::min() && value <= numeric_limits<int>::max();
+}
+
+// Переполнение int при исполнении - неопределённое поведение, поэтому такие выражения
+// не вычисляются заранее и остаются как есть
+bool Overflows(Statement* node) {
+    if (auto* negate = dynamic_cast<Negate*>(node)) {
+        const auto* number = TryNumber(negate->Argument());
+        return number != nullptr && !FitsInt(-int64_t{number->GetValue()});
+    }
+    auto* binary = dynamic_cast<BinaryOperation*>(node);
+    if (binary == nullptr) {
+        return false;
+    }
+    const auto* lhs = TryNumber(binary->Lhs());
+    const auto* rhs = TryNumber(binary->Rhs());
+    if (lhs == nullptr || rhs == nullptr) {
+        return false;
+    }
+    const int64_t a = lhs->GetValue();
+    const int64_t b = rhs->GetValue();
+    if (dynamic_cast<Add*>(node) != nullptr) {
+        return !FitsInt(a + b);
+    }
+    if (dynamic_cast<Sub*>(node) != nullptr) {
+        return !FitsInt(a - b);
+    }
+    if (dynamic_cast<Mult*>(node) != nullptr) {
+        return !FitsInt(a * b);
+    }
+    if (dynamic_cast<Div*>(node) != nullptr) {
+        return b != 0 && !FitsInt(a / b);
+    }
+    return false;
+}
+
+// Проходы оптимизации рекурсивны, а парсер принимает выражения любой вложенности. Глубже этого
+// предела инструкции не упрощаются, чтобы обход не переполнил стек потока
+constexpr size_t MAX_DEPTH = 1000;
+
+// Проверяет, глубже ли node предела MAX_DEPTH. Стек обхода явный
+bool TooDeep(Statement* node) {
+    vector<pair<Statement*, size_t>> pending{{node, 1}};
+    while (!pending.empty()) {
+        const auto [current, depth] = pending.back();
+        pending.pop_back();
+        if (depth > MAX_DEPTH) {
+            return true;
+        }
+        ForEachChild(current, [&pending, depth = depth](Statement* child) {
+            pending.emplace_back(child, depth + 1);
+        });
+    }
+    return false;
+}
+
+class ConstantFolder {
+public:
+    explicit ConstantFolder(Arena& arena)
+        : arena_(arena) {
+    }
+
+    // Упрощает поддерево node и, если нужно, заменяет node новым узлом. Инструкции, вложенные
+    // глубже MAX_DEPTH, остаются как есть
+    void Fold(Statement*& node) {
+        if (node == nullptr || IsConstant(node) || depth_ == MAX_DEPTH) {
+            return;
+        }
+        ++depth_;
+        FoldNode(node);
+        --depth_;
+    }
+
+private:
+    void FoldNode(Statement*& node) {
+        if (auto* binary = dynamic_cast<BinaryOperation*>(node)) {
+            FoldBinary(node, *binary);
+        } else if (auto* unary = dynamic_cast<UnaryOperation*>(node)) {
+            Fold(unary->Argument());
+            if (IsConstant(unary->Argument())) {
+                Evaluate(node);
+            }
+        } else if (auto* compound = dynamic_cast<Compound*>(node)) {
+            FoldAll(compound->Statements());
+        } else if (auto* assignment = dynamic_cast<Assignment*>(node)) {
+            Fold(assignment->Value());
+        } else if (auto* field_assignment = dynamic_cast<FieldAssignment*>(node)) {
+            Fold(field_assignment->Value());
+        } else if (auto* print = dynamic_cast<Print*>(node)) {
+            FoldAll(print->Args());
+        } else if (auto* call = dynamic_cast<MethodCall*>(node)) {
+            Fold(call->Object());
+            FoldAll(call->Args());
+        } else if (auto* new_instance = dynamic_cast<NewInstance*>(node)) {
+            FoldAll(new_instance->Args());
+        } else if (auto* ret = dynamic_cast<Return*>(node)) {
+            Fold(ret->Value());
+        } else if (auto* if_else = dynamic_cast<IfElse*>(node)) {
+            FoldIfElse(node, *if_else);
+        } else if (auto* method_body = dynamic_cast<MethodBody*>(node)) {
+            Fold(method_body->Body());
+        } else if (auto* class_definition = dynamic_cast<ClassDefinition*>(node)) {
+            for (const runtime::Method& method : class_definition->GetClass().GetMethods()) {
+                auto* body = dynamic_cast<MethodBody*>(method.body.get());
+                if (auto* lazy_body = dynamic_cast<LazyMethodBody*>(method.body.get())) {
+                    // Тела, которые ещё не понадобились, ради оптимизации не разбираются
+                    body = lazy_body->Parsed();
+                }
+                if (body != nullptr) {
+                    OptimizeMethod(body->Body(), method.formal_params);
+                }
+            }
+        }
+    }
+
+    // Подстановка констант и копий переменных открывает новые выражения из констант, а после их
+    // вычисления часть присваиваний становится ненужной
+    void OptimizeMethod(Statement*& body, const std::vector<runtime::Symbol>& params) {
+        Fold(body);
+        // Анализ потока данных обходит тело рекурсивно, поэтому слишком глубокие тела он пропускает
+        if (TooDeep(body)) {
+            return;
+        }
+        PropagateLocals(body, [this](Statement*& node) {
+            Fold(node);
+        });
+        Fold(body);
+        RemoveDeadStores(body, params, arena_);
+        ReuseFieldReads(body, arena_);
+    }
+
+    void FoldAll(StatementList& nodes) {
+        for (Statement*& node : nodes) {
+            Fold(node);
+        }
+    }
+
+    void FoldBinary(Statement*& node, BinaryOperation& binary) {
+        Fold(binary.Lhs());
+        // Правый аргумент or и and не вычисляется, если результат ясен по левому
+        if (IsConstant(binary.Lhs())) {
+            const bool lhs_true = runtime::IsTrue(binary.Lhs()->Execute(empty_closure_, context_));
+            if ((lhs_true && dynamic_cast<Or*>(node) != nullptr) || (!lhs_true && dynamic_cast<And*>(node) != nullptr)) {
+                node = arena_.Make<BoolConst>(runtime::Bool{lhs_true});
+                return;
+            }
+        }
+        Fold(binary.Rhs());
+        if (IsConstant(binary.Lhs()) && IsConstant(binary.Rhs())) {
+            Evaluate(node);
+            return;
+        }
+        if (dynamic_cast<Mult*>(node) != nullptr) {
+            const auto* lhs = TryNumber(binary.Lhs());
+            const auto* rhs = TryNumber(binary.Rhs());
+            if (rhs != nullptr && rhs->GetValue() == -1) {
+                node = arena_.Make<Negate>(binary.Lhs());
+            } else if (lhs != nullptr && lhs->GetValue() == -1) {
+                node = arena_.Make<Negate>(binary.Rhs());
+            }
+        }
+    }
+
+    void FoldIfElse(Statement*& node, IfElse& if_else) {
+        Fold(if_else.Condition());
+        Fold(if_else.IfBody());
+        Fold(if_else.ElseBody());
+        if (!IsConstant(if_else.Condition())) {
+            return;
+        }
+        if (runtime::IsTrue(if_else.Condition()->Execute(empty_closure_, context_))) {
+            node = if_else.IfBody();
+        } else if (if_else.ElseBody() != nullptr) {
+            node = if_else.ElseBody();
+        } else {
+            node = arena_.Make<Compound>();
+        }
+    }
+
+    // Вычисляет node, аргументы которого - константы, и заменяет его константой с результатом.
+    // Если вычисление завершилось ошибкой, node остаётся в дереве
+    void Evaluate(Statement*& node) {
+        if (Overflows(node)) {
+            return;
+        }
+        runtime::ObjectHolder result;
+        try {
+            result = node->Execute(empty_closure_, context_);
+        } catch (const exception&) {
+            return;
+        }
+        if (!result) {
+            node = arena_.Make<None>();
+        } else if (const auto* number = result.TryAs<runtime::Number>()) {
+            node = arena_.Make<NumericConst>(*number);
+        } else if (const auto* boolean = result.TryAs<runtime::Bool>()) {
+            node = arena_.Make<BoolConst>(*boolean);
+        } else if (result.TryAs<runtime::String>() != nullptr) {
+            node = arena_.Make<StringConst>(std::move(result));
+        }
+    }
+
+    Arena& arena_;
+    // Вложенность текущего вызова Fold
+    size_t depth_ = 0;
+    // Константы не обращаются к переменным и не выводят текст
+    runtime::Closure empty_closure_;
+    runtime::DummyContext context_;
+};
+
+}  // namespace
+
+void Optimize(Program& program) {
+    // Неиспользуемые классы и методы удаляются первыми, чтобы не упрощать их
+    RemoveUnusedClasses(program);
+    ConstantFolder folder(program.GetArena());
+    folder.Fold(program.Body());
+}
+
+}  // namespace ast
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "statement.h"
+
+namespace ast {
+
+// Упрощает дерево программы перед исполнением, не меняя её поведения, включая вывод и ошибки
+// времени исполнения. Вычисляет выражения, все аргументы которых - константы (арифметика,
+// сравнения, not, and, or, str и сцепление строк), и заменяет их результатом. Выражение,
+// вычисление которого завершилось ошибкой (например, деление на ноль), остаётся в дереве и
+// выбросит ту же ошибку при исполнении. Умножение на -1 заменяется узлом Negate, ветвление
+// с постоянным условием - выполняемой веткой. В методах классов, объявленных в программе,
+// кроме того подставляются значения локальных переменных, удаляются ненужные присваивания и
+// повторные чтения цепочек полей (см. dataflow.h). Неиспользуемые классы и методы удаляются
+// (см. reachability.h). Новые узлы создаются в арене программы
+void Optimize(Program& program);
+
+}  // namespace ast
@@ -0,0 +1,220 @@
+#include "optimize.h"
+#include "test_programs_p.h"
+#include "test_runner_p.h"
+
+#include <string>
+
+using namespace std;
+
+namespace ast {
+
+namespace {
+using test_programs::ParseText;
+using test_programs::Run;
+
+unique_ptr<Program> ParseAndOptimize(const string& text) {
+    auto program = ParseText(text);
+    Optimize(*program);
+    return program;
+}
+
+// Возвращает инструкцию верхнего уровня с номером index
+Statement* TopLevel(Program& program, size_t index) {
+    auto* body = dynamic_cast<Compound*>(program.Body());
+    ASSERT(body != nullptr && index < body->GetStatementCount());
+    return body->Statements()[index];
+}
+
+// Возвращает выражение, присваиваемое инструкцией верхнего уровня с номером index
+Statement* AssignedValue(Program& program, size_t index) {
+    auto* assignment = dynamic_cast<Assignment*>(TopLevel(program, index));
+    ASSERT(assignment != nullptr);
+    return assignment->Value();
+}
+
+void TestFoldsArithmetic() {
+    auto program = ParseAndOptimize("x = 2*5+10/2\ny = (1 + 2) * (7 - 4) - 9 / 3\n"s);
+
+    const auto* x = dynamic_cast<NumericConst*>(AssignedValue(*program, 0));
+    ASSERT(x != nullptr);
+    ASSERT_EQUAL(x->GetValue().GetValue(), 15);
+    const auto* y = dynamic_cast<NumericConst*>(AssignedValue(*program, 1));
+    ASSERT(y != nullptr);
+    ASSERT_EQUAL(y->GetValue().GetValue(), 6);
+}
+
+void TestFoldsPartOfExpression() {
+    auto program = ParseAndOptimize("a = 1\nx = a + 2 * 3\n"s);
+
+    auto* sum = dynamic_cast<Add*>(AssignedValue(*program, 1));
+    ASSERT(sum != nullptr);
+    ASSERT(dynamic_cast<VariableValue*>(sum->Lhs()) != nullptr);
+    const auto* product = dynamic_cast<NumericConst*>(sum->Rhs());
+    ASSERT(product != nullptr);
+    ASSERT_EQUAL(product->GetValue().GetValue(), 6);
+    ASSERT_EQUAL(Run(*program), ""s);
+}
+
+void TestKeepsRuntimeErrors() {
+    const string text = "print 1\nx = 1 / (2 - 2)\nprint 2\n"s;
+    auto program = ParseAndOptimize(text);
+
+    ASSERT(dynamic_cast<Div*>(AssignedValue(*program, 1)) != nullptr);
+    ASSERT_EQUAL(Run(*program), "1\n<error: Zero division!>"s);
+
+    auto wrong_types = ParseAndOptimize("x = 1 + 'a'\n"s);
+    ASSERT(dynamic_cast<Add*>(AssignedValue(*wrong_types, 0)) != nullptr);
+    ASSERT_EQUAL(Run(*wrong_types), "<error: Wrong types!>"s);
+}
+
+void TestKeepsOverflow() {
+    auto program = ParseAndOptimize("x = 2147483647 + 1\ny = 65536 * 65536\nz = 2147483647 + 0\n"s);
+
+    ASSERT(dynamic_cast<Add*>(AssignedValue(*program, 0)) != nullptr);
+    ASSERT(dynamic_cast<Mult*>(AssignedValue(*program, 1)) != nullptr);
+    ASSERT(dynamic_cast<NumericConst*>(AssignedValue(*program, 2)) != nullptr);
+}
+
+void TestNegation() {
+    auto program = ParseAndOptimize("x = 5\ny = -x\nz = -3\nprint y, z, - -x, -(x + 1)\n"s);
+
+    auto* negate = dynamic_cast<Negate*>(AssignedValue(*program, 1));
+    ASSERT(negate != nullptr);
+    ASSERT(dynamic_cast<VariableValue*>(negate->Argument()) != nullptr);
+    const auto* constant = dynamic_cast<NumericConst*>(AssignedValue(*program, 2));
+    ASSERT(constant != nullptr);
+    ASSERT_EQUAL(constant->GetValue().GetValue(), -3);
+    ASSERT_EQUAL(Run(*program), "-5 -3 5 -6\n"s);
+
+    auto wrong_types = ParseAndOptimize("s = 'a'\nprint -s\n"s);
+    ASSERT_EQUAL(Run(*wrong_types), "<error: Wrong types!>"s);
+}
+
+void TestFoldsStrings() {
+    auto program = ParseAndOptimize("s = 'ab' + \"cd\" + str(1 + 2) + str(None) + str(1 < 2)\n"s);
+
+    const auto* constant = dynamic_cast<StringConst*>(AssignedValue(*program, 0));
+    ASSERT(constant != nullptr);
+    ASSERT_EQUAL(constant->GetValue().TryAs<runtime::String>()->GetValue(), "abcd3NoneTrue"s);
+}
+
+void TestFoldsLogic() {
+    auto program = ParseAndOptimize(
+        "print 1 < 2, 'a' == 'b', not None, 1 and 0, 0 or 'x', True or y, False and y, None == None\n"s);
+
+    auto* print = dynamic_cast<Print*>(TopLevel(*program, 0));
+    ASSERT(print != nullptr);
+    for (Statement* arg : print->Args()) {
+        ASSERT(dynamic_cast<BoolConst*>(arg) != nullptr);
+    }
+    ASSERT_EQUAL(Run(*program), "True False True False True True False True\n"s);
+}
+
+void TestConstantConditions() {
+    auto program = ParseAndOptimize(R"(if 2 > 1:
+  print 'yes'
+else:
+  print 'no'
+if not True:
+  print 'never'
+if 1 == 2:
+  print 'no'
+else:
+  print 'else'
+)"s);
+
+    for (size_t i = 0; i < 3; ++i) {
+        ASSERT(dynamic_cast<IfElse*>(TopLevel(*program, i)) == nullptr);
+    }
+    ASSERT_EQUAL(Run(*program), "yes\nelse\n"s);
+}
+
+void TestOptimizesMethods() {
+    auto program = ParseAndOptimize(R"(class Calc:
+  def value():
+    return 2 * 5 + 10 / 2
+c = Calc()
+print c.value()
+)"s);
+
+    auto* definition = dynamic_cast<ClassDefinition*>(TopLevel(*program, 0));
+    ASSERT(definition != nullptr);
+    auto* body = dynamic_cast<MethodBody*>(definition->GetClass().GetMethod("value"sv)->body.get());
+    ASSERT(body != nullptr);
+    auto* statements = dynamic_cast<Compound*>(body->Body());
+    ASSERT(statements != nullptr && statements->GetStatementCount() == 1);
+    auto* ret = dynamic_cast<Return*>(statements->Statements()[0]);
+    ASSERT(ret != nullptr);
+    ASSERT(dynamic_cast<NumericConst*>(ret->Value()) != nullptr);
+    ASSERT_EQUAL(Run(*program), "15\n"s);
+}
+
+void TestSameOutputAsUnoptimized() {
+    const string text = R"(class Shape:
+  def __init__(w, h):
+    self.w = w * -1 * -1
+    self.h = h
+
+  def area():
+    if 1 and self.w > 0:
+      return self.w * self.h
+    return 0 - 1
+
+  def __str__():
+    return 'Shape ' + str(self.w) + 'x' + str(self.h) + ' ' + str(2 * 3 == 6)
+
+class Square(Shape):
+  def __init__(side):
+    self.w = side
+    self.h = -side * -1
+
+s = Square(4)
+r = Shape(2 + 1, 10 / 5)
+print s, s.area(), r, r.area(), -r.area()
+if not s.area() < r.area() or False:
+  print 'square' + ' is ' + 'bigger'
+print str(-(1 - 4)) + '!', 'a' < 'b'
+print 7 / (3 - 3)
+)"s;
+
+    auto plain = ParseText(text);
+    auto optimized = ParseAndOptimize(text);
+    const string expected
+        = "Shape 4x4 True 16 Shape 3x2 True 6 -6\nsquare is bigger\n3! True\n<error: Zero division!>"s;
+    ASSERT_EQUAL(Run(*plain), expected);
+    ASSERT_EQUAL(Run(*optimized), expected);
+}
+
+void TestDeepExpressions() {
+    // Оптимизация принимает любую вложенность, которую принимает парсер
+    string deep;
+    for (int i = 0; i < 200000; ++i) {
+        deep += "- "s;
+    }
+    deep += "1"s;
+    auto program = ParseAndOptimize("class C:\n  def f():\n    return "s + deep + "\nc = C()\nx = "s + deep
+                                    + "\ny = 2 * 3\nprint c.f()\n"s);
+
+    // Неглубокие инструкции по-прежнему упрощаются
+    const auto* y = dynamic_cast<NumericConst*>(AssignedValue(*program, 3));
+    ASSERT(y != nullptr);
+    ASSERT_EQUAL(y->GetValue().GetValue(), 6);
+}
+
+}  // namespace
+
+void RunOptimizeTests(TestRunner& tr) {
+    RUN_TEST(tr, TestFoldsArithmetic);
+    RUN_TEST(tr, TestFoldsPartOfExpression);
+    RUN_TEST(tr, TestKeepsRuntimeErrors);
+    RUN_TEST(tr, TestKeepsOverflow);
+    RUN_TEST(tr, TestNegation);
+    RUN_TEST(tr, TestFoldsStrings);
+    RUN_TEST(tr, TestFoldsLogic);
+    RUN_TEST(tr, TestConstantConditions);
+    RUN_TEST(tr, TestOptimizesMethods);
+    RUN_TEST(tr, TestSameOutputAsUnoptimized);
+    RUN_TEST(tr, TestDeepExpressions);
+}
+
+}  // namespace ast
@@ -0,0 +1,166 @@
+#include "parallel_parse.h"
+
+#include "lexer.h"
+#include "statement.h"
+#include "top_level.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace TokenType = parse::token_type;
+
+namespace {
+// Части меньше этого размера разбираются быстрее, чем запускается поток
+constexpr size_t MIN_CHUNK_SIZE = 64 * 1024;
+// Частей больше, чем потоков, чтобы потоки, которым достались простые части, взяли следующие
+constexpr size_t CHUNKS_PER_THREAD = 4;
+
+struct Chunk {
+    string_view text;
+    ClassScope scope;
+    // Сколько классов объявлено в части на верхнем уровне
+    size_t class_count = 0;
+    // Узлы части создаются в её арене, потому что части разбираются в разных потоках
+    unique_ptr<ast::Arena> arena = make_unique<ast::Arena>();
+    vector<runtime::Executable*> statements;
+    exception_ptr error;
+};
+
+// Если statement объявляет класс, возвращает этот класс без методов с уже найденным базовым
+// классом. Иначе возвращает пустой ObjectHolder. Выбрасывает ParseError или LexerError, если
+// заголовок объявления записан с ошибкой или базовый класс не объявлен раньше
+runtime::ObjectHolder PredeclareClass(string_view statement, const runtime::Closure& classes) {
+    constexpr string_view CLASS = "class"sv;
+    if (statement.substr(0, CLASS.size()) != CLASS) {
+        return {};
+    }
+    // Заголовок объявления целиком умещается в первой строке
+    parse::Lexer lexer(statement.substr(0, statement.find('\n')));
+    if (!lexer.CurrentToken().Is<TokenType::Class>()) {
+        return {};
+    }
+    const runtime::Symbol name = lexer.ExpectNext<TokenType::Id>().value;
+    const runtime::Class* base_class = nullptr;
+    if (const auto bracket = lexer.NextToken().TryAs<TokenType::Char>(); bracket && bracket->value == '(') {
+        const runtime::Symbol base_name = lexer.ExpectNext<TokenType::Id>().value;
+        lexer.ExpectNext<TokenType::Char>(')');
+        const auto it = classes.find(base_name);
+        if (it == classes.end()) {
+            throw ParseError("Base class "s + base_name.Name() + " not found for class "s + name.Name());
+        }
+        base_class = static_cast<const runtime::Class*>(it->second.Get());  // NOLINT
+    }
+    return runtime::ObjectHolder::Own(runtime::Class(name, {}, base_class));
+}
+
+// Делит source на части примерно по chunk_size байт и заранее создаёт классы, объявленные
+// на верхнем уровне
+vector<Chunk> SplitIntoChunks(string_view source, size_t chunk_size) {
+    const parse::TopLevelSplit split = parse::SplitTopLevel(source);
+
+    vector<Chunk> chunks;
+    runtime::Closure classes;
+    size_t chunk_begin = 0;
+    for (size_t i = 0; i < split.starts.size(); ++i) {
+        const size_t begin = split.starts[i];
+        const size_t end = i + 1 < split.starts.size() ? split.starts[i + 1] : source.size();
+        if (chunks.empty() || chunks.back().text.size() >= chunk_size) {
+            chunks.emplace_back();
+            chunks.back().scope.classes = classes;
+            chunk_begin = begin;
+        }
+        Chunk& chunk = chunks.back();
+        chunk.text = source.substr(chunk_begin, end - chunk_begin);
+
+        if (auto cls = PredeclareClass(source.substr(begin, end - begin), classes)) {
+            const runtime::Symbol name = cls.TryAs<runtime::Class>()->GetSymbol();
+            if (!classes.emplace(name, cls).second) {
+                throw ParseError("Class "s + name.Name() + " already exists"s);
+            }
+            chunk.scope.predeclared.emplace(name, std::move(cls));
+            ++chunk.class_count;
+        }
+    }
+    return chunks;
+}
+
+// Разбирает части в threads потоках. Возвращает nullptr, если хотя бы одна часть не разобралась
+// или объявила классы не так, как предполагалось при делении на части: например, объявила
+// класс внутри инструкции if. Тогда программу нужно разобрать обычным парсером
+unique_ptr<ast::Program> ParseChunks(vector<Chunk>& chunks, unsigned threads, BodyParsing bodies) {
+    atomic<size_t> next_chunk{0};
+    const auto work = [&chunks, &next_chunk, bodies] {
+        for (size_t i = next_chunk++; i < chunks.size(); i = next_chunk++) {
+            Chunk& chunk = chunks[i];
+            try {
+                parse::Lexer lexer(chunk.text);
+                chunk.statements = ParseStatements(lexer, chunk.scope, *chunk.arena, bodies);
+            } catch (...) {
+                chunk.error = current_exception();
+            }
+        }
+    };
+
+    vector<thread> workers;
+    const size_t worker_count = min<size_t>(threads, chunks.size()) - 1;
+    for (size_t i = 0; i < worker_count; ++i) {
+        try {
+            workers.emplace_back(work);
+        } catch (const system_error&) {
+            // Оставшиеся части разберут уже запущенные потоки
+            break;
+        }
+    }
+    work();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+
+    size_t statement_count = 0;
+    for (const Chunk& chunk : chunks) {
+        if (chunk.error || !chunk.scope.predeclared.empty()
+            || chunk.scope.declared.size() != chunk.class_count) {
+            return nullptr;
+        }
+        statement_count += chunk.statements.size();
+    }
+
+    // Арены частей живут столько же, сколько арена программы
+    auto arena = make_unique<ast::Arena>();
+    ast::StatementList statements(arena.get());
+    statements.reserve(statement_count);
+    for (Chunk& chunk : chunks) {
+        statements.insert(statements.end(), chunk.statements.begin(), chunk.statements.end());
+        arena->Adopt(std::move(chunk.arena));
+    }
+    ast::Statement* program = arena->Make<ast::Compound>(std::move(statements));
+    return make_unique<ast::Program>(std::move(arena), program);
+}
+}  // namespace
+
+unique_ptr<ast::Program> ParseProgramParallel(string_view source, unsigned threads, BodyParsing bodies) {
+    if (threads == 0) {
+        threads = max(thread::hardware_concurrency(), 1U);
+    }
+    const size_t chunk_count = min(threads * CHUNKS_PER_THREAD, source.size() / MIN_CHUNK_SIZE);
+    if (threads > 1 && chunk_count > 1) {
+        try {
+            vector<Chunk> chunks = SplitIntoChunks(source, source.size() / chunk_count);
+            if (auto program = ParseChunks(chunks, threads, bodies)) {
+                return program;
+            }
+        } catch (const std::exception&) {
+            // Ошибку в том же виде, что и ParseProgram, сообщит последовательный разбор
+        }
+    }
+
+    parse::Lexer lexer(source);
+    return ParseProgram(lexer, bodies);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "parse.h"
+
+#include <memory>
+#include <string_view>
+
+// Разбирает программу source так же, как ParseProgram, но в нескольких потоках. Текст делится
+// на части по инструкциям верхнего уровня, каждая часть лексически и синтаксически разбирается
+// в своём потоке, а результаты собираются в одну программу в порядке следования в тексте.
+// Классы создаются заранее по заголовкам объявлений, поэтому часть видит все классы,
+// объявленные до неё. threads задаёт число потоков, 0 - по числу ядер процессора. Небольшие
+// программы разбираются в текущем потоке. Если текст содержит ошибку, выбрасывает то же
+// исключение, что и ParseProgram. bodies задаёт, когда разбираются тела методов
+std::unique_ptr<ast::Program> ParseProgramParallel(std::string_view source, unsigned threads = 0,
+                                                   BodyParsing bodies = BodyParsing::EAGER);
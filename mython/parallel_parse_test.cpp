@@ -0,0 +1,118 @@
+#include "lexer.h"
+#include "parallel_parse.h"
+#include "test_programs_p.h"
+#include "test_runner_p.h"
+
+#include <string>
+
+using namespace std;
+
+namespace parse {
+
+namespace {
+using test_programs::Run;
+
+string RunSequential(const string& text) {
+    Lexer lexer(text);
+    auto program = ParseProgram(lexer);
+    return Run(*program);
+}
+
+// Возвращает текст исключения, которое выбрасывает parse, или пустую строку
+template <typename Parse>
+string ParseErrorText(Parse parse) {
+    try {
+        parse();
+    } catch (const std::exception& e) {
+        return e.what();
+    }
+    return {};
+}
+
+// Программа из нескольких сотен килобайт: цепочка классов, каждый из которых наследует
+// предыдущий и создаёт его экземпляры, вперемешку с условиями и многострочными константами.
+// Такая программа делится на десятки частей, и части ссылаются на классы из предыдущих частей
+string GenerateProgram(int classes) {
+    string result = "class Base:\n  def Value():\n    return 0\n\n"s;
+    result += "total = 0\n"s;
+    for (int i = 0; i < classes; ++i) {
+        const string name = "C"s + to_string(i);
+        const string parent = i == 0 ? "Base"s : "C"s + to_string(i - 1);
+        result += "class "s + name + '(' + parent + "):\n"s;
+        result += "  def Value():\n"s;
+        result += "    return "s + to_string(i % 7) + '\n';
+        result += "  def Make():\n"s;
+        result += "    return "s + parent + "()\n"s;
+        result += "  def Sum():\n"s;
+        result += "    m = self.Make()\n"s;
+        result += "    return self.Value() + m.Value()\n"s;
+        result += "x = "s + name + "()\n"s;
+        result += "total = total + x.Sum()\n"s;
+        result += "if total > "s + to_string(i * 5) + ":\n  total = total - 1\n"s;
+        result += "else:\n  total = total + 1\n"s;
+        result += "s = 'multi\n# not a comment\nclass "s + name + "x:\n'\n"s;
+        result += "# comment 'with quote\n"s;
+    }
+    result += "print total, s\n"s;
+    return result;
+}
+}  // namespace
+
+void TestParallelParseMatchesSequential() {
+    const string program = GenerateProgram(2000);
+    ASSERT(program.size() > 300'000U);
+    const string expected = RunSequential(program);
+
+    for (unsigned threads : {1U, 2U, 3U, 8U}) {
+        auto tree = ParseProgramParallel(program, threads);
+        ASSERT_EQUAL(Run(*tree), expected);
+    }
+}
+
+void TestParallelParseSmallPrograms() {
+    for (const string& program : {""s, "print 1"s, "x = 'a'\nprint x\n"s, GenerateProgram(3)}) {
+        auto tree = ParseProgramParallel(program, 4);
+        ASSERT_EQUAL(Run(*tree), RunSequential(program));
+    }
+}
+
+void TestParallelParseReportsSameErrors() {
+    const string program = GenerateProgram(2000);
+    const string broken[] = {
+        // Базовый класс объявлен позже
+        program + "class Early(Late):\n  def f():\n    return 1\nclass Late:\n  def f():\n    return 2\n"s,
+        // Повторное объявление класса
+        program + "class C5:\n  def f():\n    return 1\n"s,
+        // Ошибки в первой и в последней частях: сообщается о первой
+        "x = Missing()\n"s + program + "y = (\n"s,
+    };
+    for (const string& text : broken) {
+        const string expected = ParseErrorText([&text] {
+            Lexer lexer(text);
+            return ParseProgram(lexer);
+        });
+        ASSERT(!expected.empty());
+        ASSERT_EQUAL(ParseErrorText([&text] {
+                         return ParseProgramParallel(text, 4);
+                     }),
+                     expected);
+    }
+}
+
+void TestParallelParseClassInsideCondition() {
+    // Класс, объявленный внутри if, не виден по заголовкам верхнего уровня, поэтому такая
+    // программа разбирается обычным парсером
+    const string program = "if True:\n  class Inner:\n    def f():\n      return 5\n"s + GenerateProgram(2000)
+                           + "i = Inner()\nprint i.f()\n"s;
+    auto tree = ParseProgramParallel(program, 4);
+    ASSERT_EQUAL(Run(*tree), RunSequential(program));
+}
+
+void RunParallelParseTests(TestRunner& tr) {
+    RUN_TEST(tr, TestParallelParseMatchesSequential);
+    RUN_TEST(tr, TestParallelParseSmallPrograms);
+    RUN_TEST(tr, TestParallelParseReportsSameErrors);
+    RUN_TEST(tr, TestParallelParseClassInsideCondition);
+}
+
+}  // namespace parse
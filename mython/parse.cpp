@@ -3,55 +3,283 @@
 #include "lexer.h"
 #include "statement.h"
 
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
 using namespace std;
 
 namespace TokenType = parse::token_type;
 
 namespace {
+const runtime::Symbol STR_FUNCTION = "str"sv;
+
 bool operator==(const parse::Token& token, char c) {
-    const auto* p = token.TryAs<TokenType::Char>();
-    return p != nullptr && p->value == c;
+    const auto p = token.TryAs<TokenType::Char>();
+    return p && p->value == c;
 }
 
 bool operator!=(const parse::Token& token, char c) {
     return !(token == c);
 }
 
+// Приоритеты в выражении: чем больше приоритет, тем сильнее операция связывает операнды
+enum class Precedence { Lowest, Or, And, Not, Comparison, Sum, Product, Negation, Primary };
+
+enum class BinaryOperator {
+    Or,
+    And,
+    Less,
+    Greater,
+    Equal,
+    NotEqual,
+    LessOrEqual,
+    GreaterOrEqual,
+    Add,
+    Sub,
+    Mult,
+    Div,
+};
+
+// Возвращает бинарную операцию, которую обозначает token, или nullopt
+optional<BinaryOperator> ToBinaryOperator(const parse::Token& token) {
+    if (const auto c = token.TryAs<TokenType::Char>()) {
+        switch (c->value) {
+            case '<':
+                return BinaryOperator::Less;
+            case '>':
+                return BinaryOperator::Greater;
+            case '+':
+                return BinaryOperator::Add;
+            case '-':
+                return BinaryOperator::Sub;
+            case '*':
+                return BinaryOperator::Mult;
+            case '/':
+                return BinaryOperator::Div;
+            default:
+                return nullopt;
+        }
+    }
+    if (token.Is<TokenType::Or>()) {
+        return BinaryOperator::Or;
+    }
+    if (token.Is<TokenType::And>()) {
+        return BinaryOperator::And;
+    }
+    if (token.Is<TokenType::Eq>()) {
+        return BinaryOperator::Equal;
+    }
+    if (token.Is<TokenType::NotEq>()) {
+        return BinaryOperator::NotEqual;
+    }
+    if (token.Is<TokenType::LessOrEq>()) {
+        return BinaryOperator::LessOrEqual;
+    }
+    if (token.Is<TokenType::GreaterOrEq>()) {
+        return BinaryOperator::GreaterOrEqual;
+    }
+    return nullopt;
+}
+
+Precedence PrecedenceOf(BinaryOperator op) {
+    switch (op) {
+        case BinaryOperator::Or:
+            return Precedence::Or;
+        case BinaryOperator::And:
+            return Precedence::And;
+        case BinaryOperator::Add:
+        case BinaryOperator::Sub:
+            return Precedence::Sum;
+        case BinaryOperator::Mult:
+        case BinaryOperator::Div:
+            return Precedence::Product;
+        default:
+            return Precedence::Comparison;
+    }
+}
+
+ast::Statement* MakeBinaryOperation(ast::Arena& arena, BinaryOperator op, ast::Statement* lhs, ast::Statement* rhs) {
+    switch (op) {
+        case BinaryOperator::Or:
+            return arena.Make<ast::Or>(lhs, rhs);
+        case BinaryOperator::And:
+            return arena.Make<ast::And>(lhs, rhs);
+        case BinaryOperator::Less:
+            return arena.Make<ast::Comparison>(runtime::Less, lhs, rhs);
+        case BinaryOperator::Greater:
+            return arena.Make<ast::Comparison>(runtime::Greater, lhs, rhs);
+        case BinaryOperator::Equal:
+            return arena.Make<ast::Comparison>(runtime::Equal, lhs, rhs);
+        case BinaryOperator::NotEqual:
+            return arena.Make<ast::Comparison>(runtime::NotEqual, lhs, rhs);
+        case BinaryOperator::LessOrEqual:
+            return arena.Make<ast::Comparison>(runtime::LessOrEqual, lhs, rhs);
+        case BinaryOperator::GreaterOrEqual:
+            return arena.Make<ast::Comparison>(runtime::GreaterOrEqual, lhs, rhs);
+        case BinaryOperator::Add:
+            return arena.Make<ast::Add>(lhs, rhs);
+        case BinaryOperator::Sub:
+            return arena.Make<ast::Sub>(lhs, rhs);
+        case BinaryOperator::Mult:
+            return arena.Make<ast::Mult>(lhs, rhs);
+        case BinaryOperator::Div:
+            return arena.Make<ast::Div>(lhs, rhs);
+    }
+    return nullptr;
+}
+
+// Конструкция выражения, которой не хватает последнего операнда
+struct PendingExpression {
+    enum Kind { Binary, Not, Negation, Group, Call };
+
+    explicit PendingExpression(Kind kind, BinaryOperator op = BinaryOperator::Or, ast::Statement* lhs = nullptr,
+                               vector<runtime::Symbol> names = {})
+        : kind(kind), op(op), lhs(lhs), names(std::move(names)) {
+    }
+
+    Kind kind;
+    // Операция и её левый операнд для Binary
+    BinaryOperator op;
+    ast::Statement* lhs;
+    // Имя и уже разобранные аргументы для Call
+    vector<runtime::Symbol> names;
+    vector<ast::Statement*> args;
+};
+
+// Классы, объявленные при разборе, для тел методов, разбор которых отложен. Тело видит только
+// классы, объявленные раньше него: номер объявления класса не больше числа объявлений к началу
+// тела. Классы, видимые в начале разбора, имеют номер 0
+class ClassHistory {
+public:
+    explicit ClassHistory(const runtime::Closure& classes) {
+        for (const auto& [name, cls] : classes) {
+            classes_.emplace(name, Entry{static_cast<const runtime::Class*>(cls.Get()), 0});  // NOLINT
+        }
+    }
+
+    void Add(runtime::Symbol name, const runtime::Class* cls) {
+        classes_.emplace(name, Entry{cls, ++count_});
+    }
+
+    // Число классов, объявленных с начала разбора
+    [[nodiscard]] size_t Count() const {
+        return count_;
+    }
+
+    // Возвращает класс name, если он объявлен одним из первых count классов, иначе nullptr
+    [[nodiscard]] const runtime::Class* Find(runtime::Symbol name, size_t count) const {
+        const auto it = classes_.find(name);
+        return it != classes_.end() && it->second.number <= count ? it->second.cls : nullptr;
+    }
+
+private:
+    struct Entry {
+        // Классы живут в узлах ClassDefinition программы, история ими не владеет
+        const runtime::Class* cls;
+        size_t number;
+    };
+
+    unordered_map<runtime::Symbol, Entry> classes_;
+    size_t count_ = 0;
+};
+
+bool IsIdentifierChar(char c) {
+    return (isalnum(static_cast<unsigned char>(c)) != 0) || c == '_';
+}
+
+// Возвращает true, если какая-то строка text начинается с ключевого слова class. Строки внутри
+// многострочных строковых констант тоже проверяются: ложное совпадение лишь отменяет отложенный разбор
+bool DeclaresClass(string_view text) {
+    constexpr string_view CLASS = "class"sv;
+    size_t pos = text.find_first_not_of(' ');
+    while (pos != string_view::npos) {
+        if (text.substr(pos, CLASS.size()) == CLASS
+            && (pos + CLASS.size() == text.size() || !IsIdentifierChar(text[pos + CLASS.size()]))) {
+            return true;
+        }
+        pos = text.find('\n', pos);
+        pos = pos != string_view::npos ? text.find_first_not_of(' ', pos + 1) : pos;
+    }
+    return false;
+}
+
 class Parser {
 public:
-    explicit Parser(parse::Lexer& lexer)
-        : lexer_(lexer) {
+    Parser(parse::Lexer& lexer, ClassScope& scope, ast::Arena& arena, BodyParsing bodies)
+        : lexer_(lexer)
+        , scope_(scope)
+        , arena_(arena)
+        , history_(bodies == BodyParsing::LAZY ? arena.Make<ClassHistory>(scope.classes) : nullptr) {
+    }
+
+    // Тело метода, разбор которого отложен. Лежит в арене программы вместе с копией текста
+    struct DeferredBody {
+        // Текст тела с его первой строки
+        string_view text;
+        // Отступ строки def
+        size_t depth;
+        // Тело видит первые visible классов истории
+        const ClassHistory* history;
+        size_t visible;
+        ast::Arena* arena;
+    };
+
+    // Разбирает тело метода, разбор которого отложил DeferBody
+    static ast::Statement* ParseDeferredBody(const DeferredBody& body) {
+        parse::Lexer lexer(body.text);
+        ClassScope scope;
+        Parser parser{lexer, scope, *body.arena, BodyParsing::EAGER};
+        parser.visible_classes_ = body.history;
+        parser.visible_count_ = body.visible;
+        // Лексер начинает с нулевого отступа, поэтому перед отступом тела выдаёт отступы строки def.
+        // Их наличие гарантирует Lexer::IndentedBlock
+        for (size_t i = 0; i < body.depth; ++i) {
+            lexer.NextToken();
+        }
+        lexer.Expect<TokenType::Indent>();
+        return parser.ParseIndentedStatements();
     }
 
     // Program -> eps
     //          | Statement \n Program
-    unique_ptr<ast::Statement> ParseProgram() {
-        auto result = make_unique<ast::Compound>();
+    ast::Statement* ParseProgram() {
+        return arena_.Make<ast::Compound>(arena_.MakeVector(ParseStatements()));
+    }
+
+    vector<ast::Statement*> ParseStatements() {
+        vector<ast::Statement*> result;
         while (!lexer_.CurrentToken().Is<TokenType::Eof>()) {
-            result->AddStatement(ParseStatement());
+            result.push_back(ParseStatement());
         }
-
         return result;
     }
 
 private:
     // Suite -> NEWLINE INDENT (Statement)+ DEDENT
-    unique_ptr<ast::Statement> ParseSuite()  // NOLINT
+    ast::Statement* ParseSuite()  // NOLINT
     {
         lexer_.Expect<TokenType::Newline>();
         lexer_.ExpectNext<TokenType::Indent>();
+        return ParseIndentedStatements();
+    }
 
+    // Разбирает инструкции блока и завершающий его DEDENT. Текущая лексема - INDENT блока
+    ast::Statement* ParseIndentedStatements() {
         lexer_.NextToken();
 
-        auto result = make_unique<ast::Compound>();
+        vector<ast::Statement*> statements;
         while (!lexer_.CurrentToken().Is<TokenType::Dedent>()) {
-            result->AddStatement(ParseStatement());  // NOLINT
+            statements.push_back(ParseStatement());  // NOLINT
         }
 
         lexer_.Expect<TokenType::Dedent>();
         lexer_.NextToken();
 
-        return result;
+        return arena_.Make<ast::Compound>(arena_.MakeVector(statements));
     }
 
     // Methods -> [def id(Params) : Suite]*
@@ -76,31 +304,59 @@ private:
             lexer_.ExpectNext<TokenType::Char>(':');
             lexer_.NextToken();
 
-            m.body = std::make_unique<ast::MethodBody>(ParseSuite());  // NOLINT
+            // Метод принадлежит классу, который может пережить программу, поэтому тело метода
+            // создаётся в куче, а инструкции тела - в арене программы
+            m.body = DeferBody();
+            if (!m.body) {
+                m.body = std::make_unique<ast::MethodBody>(ParseSuite());  // NOLINT
+            }
 
             result.push_back(std::move(m));
         }
         return result;
     }
 
+    // Пропускает текст тела метода и возвращает тело, которое разберёт этот текст при первом
+    // вызове. Возвращает nullptr, если тело нужно разобрать сразу: отложенный разбор выключен,
+    // за заголовком метода нет блока с отступом (это ошибка, о которой сообщит ParseSuite)
+    // или тело объявляет класс
+    unique_ptr<ast::Statement> DeferBody() {
+        if (!history_) {
+            return nullptr;
+        }
+        const string_view block = lexer_.IndentedBlock();
+        if (block.empty() || DeclaresClass(block)) {
+            return nullptr;
+        }
+        // Отложенное тело ссылается только на память арены, поэтому его создание и освобождение
+        // не выделяют память в куче, кроме самого узла
+        const DeferredBody* deferred = arena_.Make<DeferredBody>(
+            DeferredBody{arena_.CopyText(block), lexer_.CurrentIndent(), history_, history_->Count(), &arena_});
+        lexer_.SkipBlock(block);
+        lexer_.NextToken();
+        return make_unique<ast::LazyMethodBody>([deferred] {
+            return ParseDeferredBody(*deferred);
+        });
+    }
+
     // ClassDefinition -> Id ['(' Id ')'] : new_line indent MethodList dedent
-    unique_ptr<ast::Statement> ParseClassDefinition()  // NOLINT
+    ast::Statement* ParseClassDefinition()  // NOLINT
     {
-        string class_name = lexer_.Expect<TokenType::Id>().value;
+        const runtime::Symbol class_name = lexer_.Expect<TokenType::Id>().value;
 
         lexer_.NextToken();
 
         const runtime::Class* base_class = nullptr;
         if (lexer_.CurrentToken() == '(') {
-            auto name = lexer_.ExpectNext<TokenType::Id>().value;
+            const runtime::Symbol name = lexer_.ExpectNext<TokenType::Id>().value;
             lexer_.ExpectNext<TokenType::Char>(')');
             lexer_.NextToken();
 
-            auto it = declared_classes_.find(name);
-            if (it == declared_classes_.end()) {
-                throw ParseError("Base class "s + name + " not found for class "s + class_name);
+            base_class = FindClass(name);
+            if (base_class == nullptr) {
+                throw ParseError("Base class "s + name.Name() + " not found for class "s
+                                 + class_name.Name());
             }
-            base_class = static_cast<const runtime::Class*>(it->second.Get());  // NOLINT
         }
 
         lexer_.Expect<TokenType::Char>(':');
@@ -112,20 +368,28 @@ private:
         lexer_.Expect<TokenType::Dedent>();
         lexer_.NextToken();
 
-        auto [it, inserted] = declared_classes_.insert({
-            class_name,
-            runtime::ObjectHolder::Own(runtime::Class(class_name, std::move(methods), base_class)),
-        });
+        runtime::ObjectHolder cls;
+        if (auto predeclared = scope_.predeclared.extract(class_name)) {
+            cls = std::move(predeclared.mapped());
+            static_cast<runtime::Class&>(*cls).SetMethods(std::move(methods));  // NOLINT
+        } else {
+            cls = runtime::ObjectHolder::Own(runtime::Class(class_name, std::move(methods), base_class));
+        }
+        auto [it, inserted] = scope_.classes.insert({class_name, std::move(cls)});
 
         if (!inserted) {
-            throw ParseError("Class "s + class_name + " already exists"s);
+            throw ParseError("Class "s + class_name.Name() + " already exists"s);
+        }
+        scope_.declared.push_back(class_name);
+        if (history_) {
+            history_->Add(class_name, static_cast<const runtime::Class*>(it->second.Get()));  // NOLINT
         }
 
-        return make_unique<ast::ClassDefinition>(it->second);
+        return arena_.Make<ast::ClassDefinition>(it->second);
     }
 
-    vector<string> ParseDottedIds() {
-        vector<string> result(1, lexer_.Expect<TokenType::Id>().value);
+    vector<runtime::Symbol> ParseDottedIds() {
+        vector<runtime::Symbol> result(1, lexer_.Expect<TokenType::Id>().value);
 
         while (lexer_.NextToken() == '.') {
             result.push_back(lexer_.ExpectNext<TokenType::Id>().value);
@@ -136,160 +400,44 @@ private:
 
     //  AssgnOrCall -> DottedIds = Expr
     //               | DottedIds '(' ExprList ')'
-    unique_ptr<ast::Statement> ParseAssignmentOrCall() {
+    ast::Statement* ParseAssignmentOrCall() {
         lexer_.Expect<TokenType::Id>();
 
-        vector<string> id_list = ParseDottedIds();
-        string last_name = id_list.back();
+        vector<runtime::Symbol> id_list = ParseDottedIds();
+        const runtime::Symbol last_name = id_list.back();
         id_list.pop_back();
 
         if (lexer_.CurrentToken() == '=') {
             lexer_.NextToken();
 
             if (id_list.empty()) {
-                return make_unique<ast::Assignment>(std::move(last_name), ParseTest());
+                return arena_.Make<ast::Assignment>(last_name, ParseTest());
             }
-            return make_unique<ast::FieldAssignment>(ast::VariableValue{std::move(id_list)},
-                                                     std::move(last_name), ParseTest());
+            return arena_.Make<ast::FieldAssignment>(ast::VariableValue{arena_.MakeVector(id_list)},
+                                                     last_name, ParseTest());
         }
         lexer_.Expect<TokenType::Char>('(');
         lexer_.NextToken();
 
         if (id_list.empty()) {
-            throw ParseError("Mython doesn't support functions, only methods: "s + last_name);
+            throw ParseError("Mython doesn't support functions, only methods: "s
+                             + last_name.Name());
         }
 
-        vector<unique_ptr<ast::Statement>> args;
+        vector<ast::Statement*> args;
         if (lexer_.CurrentToken() != ')') {
             args = ParseTestList();
         }
         lexer_.Expect<TokenType::Char>(')');
         lexer_.NextToken();
 
-        return make_unique<ast::MethodCall>(make_unique<ast::VariableValue>(std::move(id_list)),
-                                            std::move(last_name), std::move(args));
-    }
-
-    // Expr -> Adder ['+'/'-' Adder]*
-    unique_ptr<ast::Statement> ParseExpression()  // NOLINT
-    {
-        unique_ptr<ast::Statement> result = ParseAdder();
-        while (lexer_.CurrentToken() == '+' || lexer_.CurrentToken() == '-') {
-            char op = lexer_.CurrentToken().As<TokenType::Char>().value;
-            lexer_.NextToken();
-
-            if (op == '+') {
-                result = make_unique<ast::Add>(std::move(result), ParseAdder());
-            } else {
-                result = make_unique<ast::Sub>(std::move(result), ParseAdder());
-            }
-        }
-        return result;
-    }
-
-    // Adder -> Mult ['*'/'/' Mult]*
-    unique_ptr<ast::Statement> ParseAdder()  // NOLINT
-    {
-        unique_ptr<ast::Statement> result = ParseMult();
-        while (lexer_.CurrentToken() == '*' || lexer_.CurrentToken() == '/') {
-            char op = lexer_.CurrentToken().As<TokenType::Char>().value;
-            lexer_.NextToken();
-
-            if (op == '*') {
-                result = make_unique<ast::Mult>(std::move(result), ParseMult());
-            } else {
-                result = make_unique<ast::Div>(std::move(result), ParseMult());
-            }
-        }
-        return result;
+        return arena_.Make<ast::MethodCall>(arena_.Make<ast::VariableValue>(arena_.MakeVector(id_list)),
+                                            last_name, arena_.MakeVector(args));
     }
 
-    // Mult -> '(' Expr ')'
-    //       | NUMBER
-    //       | '-' Mult
-    //       | STRING
-    //       | NONE
-    //       | TRUE
-    //       | FALSE
-    //       | DottedIds '(' ExprList ')'
-    //       | DottedIds
-    unique_ptr<ast::Statement> ParseMult()  // NOLINT
+    vector<ast::Statement*> ParseTestList()  // NOLINT
     {
-        if (lexer_.CurrentToken() == '(') {
-            lexer_.NextToken();
-            auto result = ParseTest();
-            lexer_.Expect<TokenType::Char>(')');
-            lexer_.NextToken();
-            return result;
-        }
-        if (lexer_.CurrentToken() == '-') {
-            lexer_.NextToken();
-            return make_unique<ast::Mult>(ParseMult(), make_unique<ast::NumericConst>(-1));
-        }
-        if (const auto* num = lexer_.CurrentToken().TryAs<TokenType::Number>()) {
-            int result = num->value;
-            lexer_.NextToken();
-            return make_unique<ast::NumericConst>(result);
-        }
-        if (const auto* str = lexer_.CurrentToken().TryAs<TokenType::String>()) {
-            string result = str->value;
-            lexer_.NextToken();
-            return make_unique<ast::StringConst>(std::move(result));
-        }
-        if (lexer_.CurrentToken().Is<TokenType::True>()) {
-            lexer_.NextToken();
-            return make_unique<ast::BoolConst>(runtime::Bool(true));
-        }
-        if (lexer_.CurrentToken().Is<TokenType::False>()) {
-            lexer_.NextToken();
-            return make_unique<ast::BoolConst>(runtime::Bool(false));
-        }
-        if (lexer_.CurrentToken().Is<TokenType::None>()) {
-            lexer_.NextToken();
-            return make_unique<ast::None>();
-        }
-
-        return ParseDottedIdsInMultExpr();
-    }
-
-    std::unique_ptr<ast::Statement> ParseDottedIdsInMultExpr() {
-        vector<string> names = ParseDottedIds();
-
-        if (lexer_.CurrentToken() == '(') {
-            // various calls
-            vector<unique_ptr<ast::Statement>> args;
-            if (lexer_.NextToken() != ')') {
-                args = ParseTestList();
-            }
-            lexer_.Expect<TokenType::Char>(')');
-            lexer_.NextToken();
-
-            auto method_name = names.back();
-            names.pop_back();
-
-            if (!names.empty()) {
-                return make_unique<ast::MethodCall>(
-                    make_unique<ast::VariableValue>(std::move(names)), std::move(method_name),
-                    std::move(args));
-            }
-            if (auto it = declared_classes_.find(method_name); it != declared_classes_.end()) {
-                return make_unique<ast::NewInstance>(
-                    static_cast<const runtime::Class&>(*it->second), std::move(args));  // NOLINT
-            }
-            if (method_name == "str"sv) {
-                if (args.size() != 1) {
-                    throw ParseError("Function str takes exactly one argument"s);
-                }
-                return make_unique<ast::Stringify>(std::move(args.front()));
-            }
-            throw ParseError("Unknown call to "s + method_name + "()"s);
-        }
-        return make_unique<ast::VariableValue>(std::move(names));
-    }
-
-    vector<unique_ptr<ast::Statement>> ParseTestList()  // NOLINT
-    {
-        vector<unique_ptr<ast::Statement>> result;
+        vector<ast::Statement*> result;
         result.push_back(ParseTest());
 
         while (lexer_.CurrentToken() == ',') {
@@ -300,7 +448,7 @@ private:
     }
 
     // Condition -> if LogicalExpr: Suite [else: Suite]
-    unique_ptr<ast::Statement> ParseCondition()  // NOLINT
+    ast::Statement* ParseCondition()  // NOLINT
     {
         lexer_.Expect<TokenType::If>();
         lexer_.NextToken();
@@ -312,94 +460,187 @@ private:
 
         auto if_body = ParseSuite();
 
-        unique_ptr<ast::Statement> else_body;
+        ast::Statement* else_body = nullptr;
         if (lexer_.CurrentToken().Is<TokenType::Else>()) {
             lexer_.ExpectNext<TokenType::Char>(':');
             lexer_.NextToken();
             else_body = ParseSuite();
         }
 
-        return make_unique<ast::IfElse>(std::move(condition), std::move(if_body),
-                                        std::move(else_body));
+        return arena_.Make<ast::IfElse>(condition, if_body, else_body);
     }
 
-    // LogicalExpr -> AndTest [OR AndTest]
-    // AndTest -> NotTest [AND NotTest]
-    // NotTest -> [NOT] NotTest
+    // Test -> AndTest [OR AndTest]*
+    // AndTest -> NotTest [AND NotTest]*
+    // NotTest -> NOT NotTest
     //          | Comparison
-    unique_ptr<ast::Statement> ParseTest()  // NOLINT
-    {
-        auto result = ParseAndTest();
-        while (lexer_.CurrentToken().Is<TokenType::Or>()) {
-            lexer_.NextToken();
-            result = make_unique<ast::Or>(std::move(result), ParseAndTest());
+    // Comparison -> Expr [COMP_OP Expr]
+    // Expr -> Adder ['+'/'-' Adder]*
+    // Adder -> Mult ['*'/'/' Mult]*
+    // Mult -> '(' Test ')'
+    //       | NUMBER
+    //       | '-' Mult
+    //       | STRING
+    //       | NONE
+    //       | TRUE
+    //       | FALSE
+    //       | DottedIds '(' TestList ')'
+    //       | DottedIds
+    //
+    // Разбирается подъёмом по приоритетам без рекурсии: незавершённые операции, скобки и вызовы
+    // лежат в стеке pending_, поэтому глубина вложенности выражения не ограничена стеком потока.
+    // Сравнение и not ограничивают операции, которыми может продолжиться выражение:
+    // a < b < c и not a < b < c грамматика не допускает, а (a < b) < c допускает
+    ast::Statement* ParseTest() {
+        const size_t base = pending_.size();
+        for (;;) {
+            ast::Statement* operand = ParsePrimary(base);
+            // Операнд может стать левым аргументом только операции с приоритетом меньше limit
+            Precedence limit = Precedence::Primary;
+            for (;;) {
+                if (const auto op = ToBinaryOperator(lexer_.CurrentToken())) {
+                    const Precedence precedence = PrecedenceOf(*op);
+                    if (precedence > OperandPrecedence(base) && precedence < limit) {
+                        lexer_.NextToken();
+                        pending_.emplace_back(PendingExpression::Binary, *op, operand);
+                        break;
+                    }
+                }
+                if (pending_.size() == base) {
+                    return operand;
+                }
+
+                PendingExpression pending = std::move(pending_.back());
+                pending_.pop_back();
+                if (pending.kind == PendingExpression::Binary) {
+                    if (PrecedenceOf(pending.op) == Precedence::Comparison) {
+                        limit = min(limit, Precedence::Comparison);
+                    }
+                    operand = MakeBinaryOperation(arena_, pending.op, pending.lhs, operand);
+                } else if (pending.kind == PendingExpression::Not) {
+                    limit = min(limit, Precedence::Not);
+                    operand = arena_.Make<ast::Not>(operand);
+                } else if (pending.kind == PendingExpression::Negation) {
+                    operand = arena_.Make<ast::Mult>(operand, arena_.Make<ast::NumericConst>(-1));
+                } else if (pending.kind == PendingExpression::Group) {
+                    lexer_.Expect<TokenType::Char>(')');
+                    lexer_.NextToken();
+                    limit = Precedence::Primary;
+                } else {
+                    pending.args.push_back(operand);
+                    if (lexer_.CurrentToken() == ',') {
+                        lexer_.NextToken();
+                        pending_.push_back(std::move(pending));
+                        break;
+                    }
+                    lexer_.Expect<TokenType::Char>(')');
+                    lexer_.NextToken();
+                    operand = MakeCall(std::move(pending.names), pending.args);
+                    limit = Precedence::Primary;
+                }
+            }
         }
-        return result;
     }
 
-    unique_ptr<ast::Statement> ParseAndTest()  // NOLINT
-    {
-        auto result = ParseNotTest();
-        while (lexer_.CurrentToken().Is<TokenType::And>()) {
-            lexer_.NextToken();
-            result = make_unique<ast::And>(std::move(result), ParseNotTest());
+    // Кладёт в стек pending_ префиксные операции, открывающие скобки и вызовы с аргументами,
+    // с которых начинается операнд, и возвращает первый за ними первичный операнд
+    ast::Statement* ParsePrimary(size_t base) {
+        for (;;) {
+            const parse::Token& tok = lexer_.CurrentToken();
+            if (tok == '(') {
+                lexer_.NextToken();
+                pending_.emplace_back(PendingExpression::Group);
+                continue;
+            }
+            if (tok == '-') {
+                lexer_.NextToken();
+                pending_.emplace_back(PendingExpression::Negation);
+                continue;
+            }
+            if (tok.Is<TokenType::Not>() && OperandPrecedence(base) <= Precedence::Not) {
+                lexer_.NextToken();
+                pending_.emplace_back(PendingExpression::Not);
+                continue;
+            }
+            if (const auto num = tok.TryAs<TokenType::Number>()) {
+                int result = num->value;
+                lexer_.NextToken();
+                return arena_.Make<ast::NumericConst>(result);
+            }
+            if (const auto str = tok.TryAs<TokenType::String>()) {
+                auto result = arena_.Make<ast::StringConst>(StringConstant(str->value));
+                lexer_.NextToken();
+                return result;
+            }
+            if (tok.Is<TokenType::True>()) {
+                lexer_.NextToken();
+                return arena_.Make<ast::BoolConst>(runtime::Bool(true));
+            }
+            if (tok.Is<TokenType::False>()) {
+                lexer_.NextToken();
+                return arena_.Make<ast::BoolConst>(runtime::Bool(false));
+            }
+            if (tok.Is<TokenType::None>()) {
+                lexer_.NextToken();
+                return arena_.Make<ast::None>();
+            }
+
+            vector<runtime::Symbol> names = ParseDottedIds();
+            if (lexer_.CurrentToken() != '(') {
+                return arena_.Make<ast::VariableValue>(arena_.MakeVector(names));
+            }
+            if (lexer_.NextToken() == ')') {
+                lexer_.NextToken();
+                return MakeCall(std::move(names), {});
+            }
+            // Аргументы разбираются как следующие операнды, вызов создаётся после ')'
+            pending_.emplace_back(PendingExpression::Call, BinaryOperator::Or, nullptr, std::move(names));
         }
-        return result;
     }
 
-    unique_ptr<ast::Statement> ParseNotTest()  // NOLINT
-    {
-        if (lexer_.CurrentToken().Is<TokenType::Not>()) {
-            lexer_.NextToken();
-            return make_unique<ast::Not>(ParseNotTest());  // NOLINT
+    // Приоритет, который должна превышать операция, чтобы взять последний операнд
+    // незавершённой конструкции на вершине стека
+    Precedence OperandPrecedence(size_t base) const {
+        if (pending_.size() == base) {
+            return Precedence::Lowest;
+        }
+        const PendingExpression& pending = pending_.back();
+        switch (pending.kind) {
+            case PendingExpression::Binary:
+                return PrecedenceOf(pending.op);
+            case PendingExpression::Not:
+                return Precedence::Not;
+            case PendingExpression::Negation:
+                return Precedence::Negation;
+            default:
+                return Precedence::Lowest;
         }
-        return ParseComparison();
     }
 
-    // Comparison -> Expr [COMP_OP Expr]
-    unique_ptr<ast::Statement> ParseComparison()  // NOLINT
-    {
-        auto result = ParseExpression();
-
-        const auto tok = lexer_.CurrentToken();
+    ast::Statement* MakeCall(vector<runtime::Symbol> names, const vector<ast::Statement*>& args) {
+        const runtime::Symbol method_name = names.back();
+        names.pop_back();
 
-        if (tok == '<') {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::Less, std::move(result),
-                                                ParseExpression());
-        }
-        if (tok == '>') {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::Greater, std::move(result),
-                                                ParseExpression());
+        if (!names.empty()) {
+            return arena_.Make<ast::MethodCall>(arena_.Make<ast::VariableValue>(arena_.MakeVector(names)),
+                                                method_name, arena_.MakeVector(args));
         }
-        if (tok.Is<TokenType::Eq>()) {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::Equal, std::move(result),
-                                                ParseExpression());
+        if (const runtime::Class* cls = FindClass(method_name)) {
+            return arena_.Make<ast::NewInstance>(*cls, arena_.MakeVector(args));
         }
-        if (tok.Is<TokenType::NotEq>()) {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::NotEqual, std::move(result),
-                                                ParseExpression());
-        }
-        if (tok.Is<TokenType::LessOrEq>()) {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::LessOrEqual, std::move(result),
-                                                ParseExpression());
-        }
-        if (tok.Is<TokenType::GreaterOrEq>()) {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::GreaterOrEqual, std::move(result),
-                                                ParseExpression());
+        if (method_name == STR_FUNCTION) {
+            if (args.size() != 1) {
+                throw ParseError("Function str takes exactly one argument"s);
+            }
+            return arena_.Make<ast::Stringify>(args.front());
         }
-        return result;
+        throw ParseError("Unknown call to "s + method_name.Name() + "()"s);
     }
 
     // Statement -> SimpleStatement Newline
     //           | class ClassDefinition
     //           | if Condition
-    unique_ptr<ast::Statement> ParseStatement()  // NOLINT
+    ast::Statement* ParseStatement()  // NOLINT
     {
         const auto& tok = lexer_.CurrentToken();
 
@@ -419,30 +660,71 @@ private:
     // StatementBody -> return Expression
     //               | print ExpressionList
     //               | AssignmentOrCall
-    unique_ptr<ast::Statement> ParseSimpleStatement() {
+    ast::Statement* ParseSimpleStatement() {
         const auto& tok = lexer_.CurrentToken();
 
         if (tok.Is<TokenType::Return>()) {
             lexer_.NextToken();
-            return make_unique<ast::Return>(ParseTest());
+            return arena_.Make<ast::Return>(ParseTest());
         }
         if (tok.Is<TokenType::Print>()) {
             lexer_.NextToken();
-            vector<unique_ptr<ast::Statement>> args;
+            vector<ast::Statement*> args;
             if (!lexer_.CurrentToken().Is<TokenType::Newline>()) {
                 args = ParseTestList();
             }
-            return make_unique<ast::Print>(std::move(args));
+            return arena_.Make<ast::Print>(arena_.MakeVector(args));
         }
         return ParseAssignmentOrCall();
     }
 
+    // Возвращает объект строки с текстом text из пула констант. Текст копируется в рантайм
+    // один раз на каждую различную константу программы
+    runtime::ObjectHolder StringConstant(string_view text) {
+        if (const auto it = string_constants_.find(text); it != string_constants_.end()) {
+            return it->second;
+        }
+        auto result = runtime::ObjectHolder::Own(runtime::String(string(text)));
+        // Ключ ссылается на текст внутри самого объекта строки, а не на исходный текст программы
+        string_constants_.emplace(result.TryAs<runtime::String>()->GetValue(), result);
+        return result;
+    }
+
+    // Возвращает класс name, видимый в разбираемом тексте, или nullptr
+    const runtime::Class* FindClass(runtime::Symbol name) {
+        scope_.used.push_back(name);
+        if (visible_classes_ != nullptr) {
+            return visible_classes_->Find(name, visible_count_);
+        }
+        const auto it = scope_.classes.find(name);
+        return it != scope_.classes.end() ? static_cast<const runtime::Class*>(it->second.Get()) : nullptr;  // NOLINT
+    }
+
     parse::Lexer& lexer_;
-    runtime::Closure declared_classes_;
+    ClassScope& scope_;
+    ast::Arena& arena_;
+    // Незавершённые конструкции разбираемого выражения
+    vector<PendingExpression> pending_;
+    // Пул строковых констант программы: одинаковые константы разделяют один объект строки
+    unordered_map<string_view, runtime::ObjectHolder> string_constants_;
+    // Объявленные классы для тел методов, разбор которых отложен. Лежит в арене, nullptr,
+    // если тела разбираются сразу
+    ClassHistory* history_;
+    // При разборе отложенного тела имена классов ищутся среди первых visible_count_ классов
+    // истории, а не в scope_
+    const ClassHistory* visible_classes_ = nullptr;
+    size_t visible_count_ = 0;
 };
 
 }  // namespace
 
-unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer) {
-    return Parser{lexer}.ParseProgram();
-}
\ No newline at end of file
+unique_ptr<ast::Program> ParseProgram(parse::Lexer& lexer, BodyParsing bodies) {
+    ClassScope scope;
+    auto arena = make_unique<ast::Arena>();
+    ast::Statement* program = Parser{lexer, scope, *arena, bodies}.ParseProgram();
+    return make_unique<ast::Program>(std::move(arena), program);
+}
+
+vector<ast::Statement*> ParseStatements(parse::Lexer& lexer, ClassScope& scope, ast::Arena& arena, BodyParsing bodies) {
+    return Parser{lexer, scope, arena, bodies}.ParseStatements();
+}
@@ -1,18 +1,47 @@
 #pragma once
 
+#include "statement.h"
+
 #include <memory>
 #include <stdexcept>
+#include <vector>
 
 namespace parse {
 class Lexer;
 }
 
-namespace runtime {
-class Executable;
-}
-
 struct ParseError : std::runtime_error {
     using std::runtime_error::runtime_error;
 };
 
-std::unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer);
\ No newline at end of file
+// Классы, видимые при разборе части программы, и то, как эта часть с ними связана
+struct ClassScope {
+    // Классы, объявленные раньше разбираемого текста. Классы, объявленные в нём, добавляются сюда
+    runtime::Closure classes;
+    // Имена классов, объявленных в разобранном тексте
+    std::vector<runtime::Symbol> declared;
+    // Имена, которые разбор искал среди классов, в том числе не найденные
+    std::vector<runtime::Symbol> used;
+    // Классы, созданные заранее для объявлений в разбираемом тексте. Объявление такого класса
+    // не создаёт новый класс, а задаёт методы заранее созданного и забирает его отсюда
+    runtime::Closure predeclared;
+};
+
+// Когда разбираются тела методов
+enum class BodyParsing {
+    // Вместе с объявлением класса
+    EAGER,
+    // При первом вызове метода (ast::LazyMethodBody). Текст тела пропускается без разбора на
+    // лексемы и копируется, имена классов в нём разрешаются так же, как при разборе на месте.
+    // Ошибки в теле метода выбрасываются только при его вызове. Тела, которые объявляют классы,
+    // разбираются сразу: такие классы видны следующим инструкциям программы
+    LAZY,
+};
+
+// Разбирает программу. Узлы дерева лежат в арене, которой владеет возвращённый объект
+std::unique_ptr<ast::Program> ParseProgram(parse::Lexer& lexer, BodyParsing bodies = BodyParsing::EAGER);
+
+// Разбирает инструкции до конца потока лексем, разрешая имена классов через scope.
+// Узлы создаются в arena и живут, пока она жива
+std::vector<runtime::Executable*> ParseStatements(parse::Lexer& lexer, ClassScope& scope, ast::Arena& arena,
+                                                  BodyParsing bodies = BodyParsing::EAGER);
@@ -244,6 +244,204 @@ print r, c, t1, t2
                  "Rect(10x20) Circle(52) Triangle(3, 4, 5) Wrong triangle\n"s);
 }
 
+void TestStringConstantsAreShared() {
+    const string program = R"(
+x = "same text"
+y = 'same text'
+z = "same\ttext"
+w = 'same\ttext'
+print x, y, z, w
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "same text same text same\ttext same\ttext\n"s);
+    // Одинаковые константы разделяют один объект строки, в том числе константы
+    // с escape-последовательностями
+    ASSERT(closure.at("x"s).Get() == closure.at("y"s).Get());
+    ASSERT(closure.at("z"s).Get() == closure.at("w"s).Get());
+    ASSERT(closure.at("x"s).Get() != closure.at("z"s).Get());
+}
+
+void TestOperatorPrecedence() {
+    const string program = R"(
+print 2 + 3 * 4 - -2 * 3, 20 / 2 / 5, not 1 > 2 and 3 < 4 or False
+print (1 < 2) == True, not not 0 == 0, str(1 + 2) + str(-(3))
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "20 2 True\nTrue True 3-3\n"s);
+
+    // Сравнения не объединяются в цепочки, в том числе после not
+    for (const string& text : {"print 1 < 2 < 3\n"s, "print not 1 < 2 < 3\n"s, "print 1 + not 2\n"s}) {
+        bool failed = false;
+        try {
+            ParseProgramFromString(text);
+        } catch (const std::exception&) {
+            failed = true;
+        }
+        ASSERT(failed);
+    }
+}
+
+void TestDeeplyNestedExpressions() {
+    // Глубина скобок не ограничена стеком потока. Вложенные вызовы, not и унарный минус
+    // создают узлы дерева, поэтому их глубина ограничена рекурсией при выполнении
+    constexpr int depth = 200'000;
+    string calls = "1"s;
+    string nots = "True"s;
+    for (int i = 0; i < 1000; ++i) {
+        calls = "str("s + calls + ")"s;
+        nots = "not "s + nots;
+    }
+    const string program = "x = "s + string(depth, '(') + "1"s + string(depth, ')') + "\n"s + "print x, "s
+                           + string(1000, '-') + "2, "s + calls + ", "s + nots + "\n"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "1 2 1 True\n"s);
+}
+
+unique_ptr<ast::Program> ParseLazily(const string& program) {
+    istringstream is(program);
+    parse::Lexer lexer(is);
+    return ParseProgram(lexer, BodyParsing::LAZY);
+}
+
+// Возвращает тело метода method класса cls, объявление которого выполнено в closure
+runtime::Executable* MethodBodyOf(runtime::Closure& closure, const string& cls, const string& method) {
+    const auto* found = closure.at(cls).TryAs<runtime::ClassInstance>()->GetClass().GetMethod(method);
+    ASSERT(found != nullptr);
+    return found->body.get();
+}
+
+void TestLazyMethodBodies() {
+    const string program = R"(
+class Shape:
+  def __init__(w):
+    self.w = w
+  def area():
+    return self.w * self.w
+  def broken():
+    return self.w +
+class Square(Shape):
+  def __str__():
+    return 'Square ' + str(self.area())
+s = Square(3)
+print s
+)"s;
+
+    bool failed = false;
+    try {
+        ParseProgramFromString(program);
+    } catch (const std::exception&) {
+        failed = true;
+    }
+    ASSERT(failed);
+
+    // Тело метода с ошибкой не разбирается, пока метод не вызван
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    auto tree = ParseLazily(program);
+    tree->Execute(closure, context);
+    ASSERT_EQUAL(context.output.str(), "Square 9\n"s);
+
+    auto* area = dynamic_cast<ast::LazyMethodBody*>(MethodBodyOf(closure, "Shape"s, "area"s));
+    ASSERT(area != nullptr && area->Parsed() != nullptr);
+    auto* broken = dynamic_cast<ast::LazyMethodBody*>(MethodBodyOf(closure, "Shape"s, "broken"s));
+    ASSERT(broken != nullptr && broken->Parsed() == nullptr);
+
+    // Ошибка выбрасывается при каждом вызове
+    auto call = ParseLazily("s.broken()\n"s);
+    for (int i = 0; i < 2; ++i) {
+        failed = false;
+        try {
+            call->Execute(closure, context);
+        } catch (const parse::LexerError&) {
+            failed = true;
+        }
+        ASSERT(failed);
+    }
+}
+
+void TestLazyBodiesSeeEarlierClasses() {
+    // Класс str объявлен после метода, поэтому str в теле метода - встроенная функция
+    const string program = R"(
+class A:
+  def text():
+    return str(1) + '!'
+  def make():
+    return B()
+class str:
+  def __init__(x):
+    self.x = x
+class B:
+  def __init__():
+    self.x = 1
+a = A()
+print a.text()
+)"s;
+
+    bool failed = false;
+    try {
+        ParseProgramFromString(program);
+    } catch (const ParseError&) {
+        failed = true;
+    }
+    ASSERT(failed);
+
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    auto tree = ParseLazily(program);
+    tree->Execute(closure, context);
+    ASSERT_EQUAL(context.output.str(), "1!\n"s);
+
+    // Класс B объявлен после метода make, и при разборе на месте это была бы ошибка разбора
+    failed = false;
+    try {
+        ParseLazily("a.make()\n"s)->Execute(closure, context);
+    } catch (const ParseError&) {
+        failed = true;
+    }
+    ASSERT(failed);
+}
+
+void TestBodiesDeclaringClassesAreParsedEagerly() {
+    const string program = R"(
+class Factory:
+  def make():
+    class Made:
+      def value():
+        return 5
+    return 1
+  def other():
+    return Made()
+m = Made()
+print m.value()
+)"s;
+
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    auto tree = ParseLazily(program);
+    tree->Execute(closure, context);
+    ASSERT_EQUAL(context.output.str(), "5\n"s);
+    ASSERT(dynamic_cast<ast::MethodBody*>(MethodBodyOf(closure, "Factory"s, "make"s)) != nullptr);
+    ASSERT(dynamic_cast<ast::LazyMethodBody*>(MethodBodyOf(closure, "Factory"s, "other"s)) != nullptr);
+}
+
 }  // namespace parse
 
 void TestParseProgram(TestRunner& tr) {
@@ -255,4 +453,10 @@ void TestParseProgram(TestRunner& tr) {
     RUN_TEST(tr, parse::TestRecursion2);
     RUN_TEST(tr, parse::TestComplexLogicalExpression);
     RUN_TEST(tr, parse::TestClassicalPolymorphism);
+    RUN_TEST(tr, parse::TestStringConstantsAreShared);
+    RUN_TEST(tr, parse::TestOperatorPrecedence);
+    RUN_TEST(tr, parse::TestDeeplyNestedExpressions);
+    RUN_TEST(tr, parse::TestLazyMethodBodies);
+    RUN_TEST(tr, parse::TestLazyBodiesSeeEarlierClasses);
+    RUN_TEST(tr, parse::TestBodiesDeclaringClassesAreParsedEagerly);
 }
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "reachability.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+namespace ast {
+
+namespace {
+
+const runtime::Symbol INIT_METHOD = "__init__"sv;
+const runtime::Symbol STR_METHOD = "__str__"sv;
+const runtime::Symbol ADD_METHOD = "__add__"sv;
+const runtime::Symbol EQ_METHOD = "__eq__"sv;
+const runtime::Symbol LT_METHOD = "__lt__"sv;
+
+class Reachability {
+public:
+    // Обходит программу и тела методов, пока находятся новые используемые классы и методы.
+    // Отложенные тела разбираются, только когда метод оказался используемым
+    explicit Reachability(Program& program) {
+        Visit(program.Body());
+        for (bool changed = true; changed && !failed_;) {
+            changed = MarkInstantiated();
+            // Обход тел методов дополняет definitions_, поэтому цикл по индексу
+            for (size_t i = 0; i < definitions_.size(); ++i) {
+                const runtime::Class& cls = definitions_[i]->GetClass();
+                if (read_names_.count(cls.GetSymbol()) > 0) {
+                    changed = MarkUsed(&cls) || changed;
+                }
+            }
+            for (const runtime::Class* cls : vector<const runtime::Class*>(used_.begin(), used_.end())) {
+                for (const runtime::Method& method : cls->GetMethods()) {
+                    if (called_.count(method.name) > 0 && visited_methods_.insert(&method).second) {
+                        VisitMethod(method);
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    void RemoveUnused(Program& program) {
+        if (failed_) {
+            return;
+        }
+        for (ClassDefinition* definition : definitions_) {
+            runtime::Class& cls = definition->GetClass();
+            const bool used = IsUsed(cls);
+            cls.RemoveMethods([this, used](const runtime::Method& method) {
+                return !used || called_.count(method.name) == 0;
+            });
+        }
+        RemoveDefinitions(program.Body());
+        for (const runtime::Class* cls : used_) {
+            for (const runtime::Method& method : cls->GetMethods()) {
+                RemoveDefinitions(method.body.get());
+            }
+        }
+    }
+
+private:
+    // Вызывает action для node и вложенных в него инструкций в том же порядке, что и
+    // рекурсивный обход через ForEachChild. Стек обхода явный, поэтому глубина вложенности
+    // выражений, которую принимает парсер, не ограничена стеком потока
+    template <typename Action>
+    static void ForEachNode(Statement* root, Action action) {
+        vector<Statement*> pending{root};
+        while (!pending.empty()) {
+            Statement* node = pending.back();
+            pending.pop_back();
+            action(node);
+            const size_t first_child = pending.size();
+            ForEachChild(node, [&pending](Statement* child) {
+                pending.push_back(child);
+            });
+            reverse(pending.begin() + static_cast<ptrdiff_t>(first_child), pending.end());
+        }
+    }
+
+    void Visit(Statement* root) {
+        ForEachNode(root, [this](Statement* node) {
+            VisitNode(node);
+        });
+    }
+
+    void VisitNode(Statement* node) {
+        if (auto* variable = dynamic_cast<VariableValue*>(node)) {
+            read_names_.insert(variable->Ids().front());
+        } else if (auto* field_assignment = dynamic_cast<FieldAssignment*>(node)) {
+            read_names_.insert(field_assignment->Object().Ids().front());
+        } else if (auto* call = dynamic_cast<MethodCall*>(node)) {
+            called_.insert(call->GetMethod());
+        } else if (auto* new_instance = dynamic_cast<NewInstance*>(node)) {
+            instantiated_.push_back(&new_instance->GetClass());
+            called_.insert(INIT_METHOD);
+        } else if (dynamic_cast<Print*>(node) != nullptr || dynamic_cast<Stringify*>(node) != nullptr) {
+            called_.insert(STR_METHOD);
+        } else if (dynamic_cast<Add*>(node) != nullptr) {
+            called_.insert(ADD_METHOD);
+        } else if (dynamic_cast<Comparison*>(node) != nullptr) {
+            called_.insert(EQ_METHOD);
+            called_.insert(LT_METHOD);
+        } else if (auto* definition = dynamic_cast<ClassDefinition*>(node)) {
+            definitions_.push_back(definition);
+        }
+    }
+
+    void VisitMethod(const runtime::Method& method) {
+        if (auto* lazy_body = dynamic_cast<LazyMethodBody*>(method.body.get())) {
+            try {
+                lazy_body->Parse();
+            } catch (const std::exception&) {
+                // Неизвестно, что вызывает тело с ошибкой, поэтому ничего не удаляется.
+                // Ошибка будет выброшена при вызове метода
+                failed_ = true;
+                return;
+            }
+        }
+        Visit(method.body.get());
+    }
+
+    // Отмечает используемыми классы, экземпляры которых создаёт найденный код
+    bool MarkInstantiated() {
+        bool changed = false;
+        for (; marked_instantiated_ < instantiated_.size(); ++marked_instantiated_) {
+            changed = MarkUsed(instantiated_[marked_instantiated_]) || changed;
+        }
+        return changed;
+    }
+
+    // Отмечает используемыми класс и его предков. Возвращает true, если нашёлся новый класс
+    bool MarkUsed(const runtime::Class* cls) {
+        bool changed = false;
+        for (; cls != nullptr && used_.insert(cls).second; cls = cls->GetParent()) {
+            changed = true;
+        }
+        return changed;
+    }
+
+    [[nodiscard]] bool IsUsed(const runtime::Class& cls) const {
+        return used_.count(&cls) > 0;
+    }
+
+    // Убирает из node и вложенных в него инструкций объявления неиспользуемых классов
+    void RemoveDefinitions(Statement* root) {
+        ForEachNode(root, [this](Statement* node) {
+            if (auto* compound = dynamic_cast<Compound*>(node)) {
+                auto& statements = compound->Statements();
+                statements.erase(remove_if(statements.begin(), statements.end(),
+                                           [this](Statement* statement) {
+                                               auto* definition = dynamic_cast<ClassDefinition*>(statement);
+                                               return definition != nullptr && !IsUsed(definition->GetClass());
+                                           }),
+                                 statements.end());
+            }
+        });
+    }
+
+    // Имена методов, которые может вызвать достижимый код
+    unordered_set<runtime::Symbol> called_;
+    // Имена переменных, которые читает достижимый код
+    unordered_set<runtime::Symbol> read_names_;
+    vector<const runtime::Class*> instantiated_;
+    size_t marked_instantiated_ = 0;
+    vector<ClassDefinition*> definitions_;
+    unordered_set<const runtime::Class*> used_;
+    unordered_set<const runtime::Method*> visited_methods_;
+    // Тело одного из используемых методов не удалось разобрать
+    bool failed_ = false;
+};
+
+}  // namespace
+
+void RemoveUnusedClasses(Program& program) {
+    Reachability(program).RemoveUnused(program);
+}
+
+}  // namespace ast
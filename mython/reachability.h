@@ -0,0 +1,18 @@
+#pragma once
+
+#include "statement.h"
+
+namespace ast {
+
+// Удаляет из программы классы и методы, которые она не может использовать. Класс используется,
+// если достижимый код создаёт его экземпляр, читает переменную с его именем или класс - предок
+// используемого класса. Метод используемого класса остаётся, если достижимый код вызывает
+// метод с таким именем у какого-либо объекта или выполняет операцию, которая вызывает метод
+// неявно: создание объекта (__init__), print и str (__str__), сложение (__add__) и сравнения
+// (__eq__, __lt__). Достижимый код - инструкции программы и тела оставшихся методов.
+// Объявления неиспользуемых классов не выполняются, тела удалённых методов освобождаются.
+// Отложенные тела (LazyMethodBody) оставшихся методов разбираются. Если разбор тела завершился
+// ошибкой, программа не меняется
+void RemoveUnusedClasses(Program& program);
+
+}  // namespace ast
@@ -0,0 +1,202 @@
+#include "reachability.h"
+#include "test_programs_p.h"
+#include "test_runner_p.h"
+
+#include <algorithm>
+#include <string>
+
+using namespace std;
+
+namespace ast {
+
+namespace {
+using test_programs::ParseText;
+using test_programs::Run;
+
+// Оставшиеся в программе классы и их методы в виде "Class(method1,method2)" в порядке объявления
+string Remaining(const string& text, BodyParsing bodies = BodyParsing::EAGER) {
+    const string expected = Run(*ParseText(text, bodies));
+    auto program = ParseText(text, bodies);
+    RemoveUnusedClasses(*program);
+    ASSERT_EQUAL(Run(*program), expected);
+
+    string result;
+    for (Statement* statement : dynamic_cast<Compound*>(program->Body())->Statements()) {
+        auto* definition = dynamic_cast<ClassDefinition*>(statement);
+        if (definition == nullptr) {
+            continue;
+        }
+        vector<string> methods;
+        for (const runtime::Method& method : definition->GetClass().GetMethods()) {
+            methods.push_back(method.name.Name());
+        }
+        sort(methods.begin(), methods.end());
+        result += definition->GetClass().GetName() + "("s;
+        for (size_t i = 0; i < methods.size(); ++i) {
+            result += (i == 0 ? ""s : ","s) + methods[i];
+        }
+        result += ")"s;
+    }
+    return result;
+}
+
+void TestRemovesUnusedClasses() {
+    ASSERT_EQUAL(Remaining(R"(class Used:
+  def f():
+    return 1
+class Unused:
+  def f():
+    return 2
+u = Used()
+print u.f()
+)"s),
+                 "Used(f)"s);
+}
+
+void TestRemovesUncalledMethods() {
+    // Метод f вызывается и у B, и у A: достаточно совпадения имени
+    ASSERT_EQUAL(Remaining(R"(class A:
+  def __init__():
+    self.x = 1
+  def f():
+    return 1
+  def g():
+    return 2
+  def __str__():
+    return 'A'
+  def __add__(other):
+    return 3
+class B:
+  def f():
+    return A()
+b = B()
+a = b.f()
+print a.f()
+)"s),
+                 "A(__init__,__str__,f)B(f)"s);
+}
+
+void TestOperatorsKeepDunders() {
+    ASSERT_EQUAL(Remaining(R"(class V:
+  def __eq__(other):
+    return True
+  def __lt__(other):
+    return False
+  def __add__(other):
+    return 5
+  def __str__():
+    return 'v'
+  def unused():
+    return 0
+v = V()
+x = v + v
+y = v < v
+)"s),
+                 "V(__add__,__eq__,__lt__)"s);
+}
+
+void TestKeepsBaseClassesAndClassNames() {
+    ASSERT_EQUAL(Remaining(R"(class Base:
+  def f():
+    return 1
+  def g():
+    return 2
+class Derived(Base):
+  def h():
+    return self.f()
+class Named:
+  def k():
+    return 3
+class Unused(Base):
+  def m():
+    return 4
+d = Derived()
+n = Named
+print d.h(), n.k()
+)"s),
+                 "Base(f)Derived(h)Named(k)"s);
+}
+
+void TestFollowsMethodBodies() {
+    // Inner создаётся только в методе, который вызывается, Other - в методе, который не вызывается
+    ASSERT_EQUAL(Remaining(R"(class Inner:
+  def value():
+    return 7
+class Other:
+  def value():
+    return 8
+class Outer:
+  def make():
+    return Inner()
+  def never():
+    return Other()
+o = Outer()
+i = o.make()
+print i.value()
+)"s),
+                 "Inner(value)Outer(make)"s);
+}
+
+void TestParsesOnlyUsedLazyBodies() {
+    // Тела с ошибками не разбираются: их методы не вызываются или классы не используются
+    ASSERT_EQUAL(Remaining(R"(class Helper:
+  def __str__():
+    return 'helper'
+class Used:
+  def f():
+    return Helper()
+  def g():
+    return +
+class Unused:
+  def h():
+    return +
+u = Used()
+print u.f()
+)"s,
+                           BodyParsing::LAZY),
+                 "Helper(__str__)Used(f)"s);
+
+    // Если тело используемого метода не разбирается, ничего не удаляется, а ошибку выбросит вызов
+    ASSERT_EQUAL(Remaining(R"(class Used:
+  def f():
+    return +
+class Unused:
+  def h():
+    return 1
+u = Used()
+print u.f()
+)"s,
+                           BodyParsing::LAZY),
+                 "Used(f)Unused(h)"s);
+}
+
+void TestDeepExpressions() {
+    // Вложенность выражений, которую принимает парсер, не ограничена стеком обхода
+    string text = "class Used:\n  def f():\n    return 1\nclass Unused:\n  def g():\n    return 2\nx = "s;
+    for (int i = 0; i < 200000; ++i) {
+        text += "- "s;
+    }
+    text += "Used()\n"s;
+    auto program = ParseText(text);
+    RemoveUnusedClasses(*program);
+
+    auto& statements = dynamic_cast<Compound*>(program->Body())->Statements();
+    ASSERT_EQUAL(statements.size(), 2U);
+    auto* used = dynamic_cast<ClassDefinition*>(statements.front());
+    ASSERT(used != nullptr);
+    ASSERT_EQUAL(used->GetClass().GetName(), "Used"s);
+}
+
+}  // namespace
+
+void RunReachabilityTests(TestRunner& tr) {
+    RUN_TEST(tr, TestRemovesUnusedClasses);
+    RUN_TEST(tr, TestRemovesUncalledMethods);
+    RUN_TEST(tr, TestOperatorsKeepDunders);
+    RUN_TEST(tr, TestKeepsBaseClassesAndClassNames);
+    RUN_TEST(tr, TestFollowsMethodBodies);
+    RUN_TEST(tr, TestParsesOnlyUsedLazyBodies);
+    RUN_TEST(tr, TestDeepExpressions);
+}
+
+}  // namespace ast
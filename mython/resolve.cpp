@@ -0,0 +1,72 @@
+#include "resolve.h"
+
+#include <unordered_map>
+
+using namespace std;
+
+namespace ast {
+
+void Unassigned::Print(std::ostream& /*os*/, runtime::Context& /*context*/) {
+}
+
+Unassigned UNASSIGNED_OBJECT;
+const runtime::ObjectHolder UNASSIGNED = runtime::ObjectHolder::Share(UNASSIGNED_OBJECT);
+
+namespace {
+
+const runtime::Symbol SELF = "self"sv;
+
+class Resolver {
+public:
+    explicit Resolver(const vector<runtime::Symbol>& formal_params) {
+        for (size_t i = 0; i < formal_params.size(); ++i) {
+            slots_[formal_params[i]] = static_cast<uint32_t>(i);
+        }
+        // Параметр с именем self перекрывает сам объект
+        slots_.emplace(SELF, static_cast<uint32_t>(formal_params.size()));
+        slot_count_ = static_cast<uint32_t>(formal_params.size()) + 1;
+    }
+
+    void Visit(Statement* node) {
+        if (auto* variable = dynamic_cast<VariableValue*>(node)) {
+            variable->SetSlot(SlotOf(variable->Ids().front()));
+        } else if (auto* assignment = dynamic_cast<Assignment*>(node)) {
+            assignment->SetSlot(SlotOf(assignment->GetName()));
+        } else if (auto* field_assignment = dynamic_cast<FieldAssignment*>(node)) {
+            // Объект, полю которого присваивается значение, не входит в дочерние узлы
+            VariableValue& object = field_assignment->Object();
+            object.SetSlot(SlotOf(object.Ids().front()));
+        } else if (auto* definition = dynamic_cast<ClassDefinition*>(node)) {
+            definition->SetSlot(SlotOf(definition->GetClass().GetSymbol()));
+        }
+        ForEachChild(node, [this](Statement* child) {
+            Visit(child);
+        });
+    }
+
+    [[nodiscard]] uint32_t GetSlotCount() const {
+        return slot_count_;
+    }
+
+private:
+    uint32_t SlotOf(runtime::Symbol name) {
+        const auto [it, inserted] = slots_.emplace(name, slot_count_);
+        if (inserted) {
+            ++slot_count_;
+        }
+        return it->second;
+    }
+
+    unordered_map<runtime::Symbol, uint32_t> slots_;
+    uint32_t slot_count_ = 0;
+};
+
+}  // namespace
+
+uint32_t ResolveLocals(Statement* body, const vector<runtime::Symbol>& formal_params) {
+    Resolver resolver(formal_params);
+    resolver.Visit(body);
+    return resolver.GetSlotCount();
+}
+
+}  // namespace ast
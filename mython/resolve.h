@@ -0,0 +1,35 @@
+#pragma once
+
+#include "statement.h"
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Назначение локальным переменным метода ячеек кадра. Метод видит только self, свои параметры
+// и переменные, которым присваивает значения, поэтому все имена, которые читает и пишет тело,
+// известны заранее, и вместо поиска в Closure по имени переменная берётся из массива по номеру
+namespace ast {
+
+// Значение ячейки кадра, которой ещё ничего не присвоено. Отличается от None. Одно для всех
+// исполнителей, которые держат переменные методов в ячейках
+class Unassigned : public runtime::Object {
+public:
+    void Print(std::ostream& os, runtime::Context& context) override;
+};
+
+extern Unassigned UNASSIGNED_OBJECT;
+extern const runtime::ObjectHolder UNASSIGNED;
+
+inline bool IsUnassigned(const runtime::ObjectHolder& value) {
+    return value.Get() == &UNASSIGNED_OBJECT;
+}
+
+// Записывает номера ячеек в узлы VariableValue, Assignment и ClassDefinition тела метода
+// body с параметрами formal_params и возвращает число ячеек. Параметры занимают ячейки
+// 0..formal_params.size()-1 (при повторе имени переменной соответствует последний параметр),
+// self - ячейку formal_params.size(), остальные переменные - следующие ячейки. Тела методов
+// классов, объявленных внутри body, не затрагиваются
+std::uint32_t ResolveLocals(Statement* body, const std::vector<runtime::Symbol>& formal_params);
+
+}  // namespace ast
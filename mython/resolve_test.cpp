@@ -0,0 +1,144 @@
+#include "resolve.h"
+#include "test_programs_p.h"
+#include "test_runner_p.h"
+
+#include <string>
+
+using namespace std;
+
+namespace ast {
+
+namespace {
+using test_programs::ParseText;
+using test_programs::Run;
+
+// Возвращает метод method класса, объявленного на верхнем уровне
+const runtime::Method& MethodOf(Program& program, string_view method) {
+    for (Statement* statement : dynamic_cast<Compound*>(program.Body())->Statements()) {
+        auto* definition = dynamic_cast<ClassDefinition*>(statement);
+        if (definition != nullptr && definition->GetClass().GetMethod(method) != nullptr) {
+            return *definition->GetClass().GetMethod(method);
+        }
+    }
+    throw runtime_error("No method "s + string(method));
+}
+
+void TestAssignsSlots() {
+    auto program = ParseText(R"(class C:
+  def f(a, b):
+    x = a + b
+    self.y = x
+    class Local:
+      def g(x):
+        return x
+    return Local()
+)"s);
+    const runtime::Method& f = MethodOf(*program, "f"sv);
+    auto& statements = dynamic_cast<Compound*>(dynamic_cast<MethodBody&>(*f.body).Body())->Statements();
+
+    // a, b, self, x, Local
+    ASSERT_EQUAL(ResolveLocals(dynamic_cast<MethodBody&>(*f.body).Body(), f.formal_params), 5U);
+    auto* x = dynamic_cast<Assignment*>(statements[0]);
+    ASSERT_EQUAL(x->GetSlot(), 3U);
+    auto* sum = dynamic_cast<Add*>(x->Value());
+    ASSERT_EQUAL(dynamic_cast<VariableValue*>(sum->Lhs())->GetSlot(), 0U);
+    ASSERT_EQUAL(dynamic_cast<VariableValue*>(sum->Rhs())->GetSlot(), 1U);
+
+    // Объект, полю которого присваивается значение, тоже читается из ячейки
+    auto* field = dynamic_cast<FieldAssignment*>(statements[1]);
+    ASSERT_EQUAL(field->Object().GetSlot(), 2U);
+    ASSERT_EQUAL(dynamic_cast<VariableValue*>(field->Value())->GetSlot(), 3U);
+
+    // Тело метода вложенного класса разрешается при его собственном вызове
+    auto* local = dynamic_cast<ClassDefinition*>(statements[2]);
+    ASSERT_EQUAL(local->GetSlot(), 4U);
+    auto& g_body = dynamic_cast<MethodBody&>(*local->GetClass().GetMethod("g"sv)->body);
+    auto* g_value = dynamic_cast<Return*>(dynamic_cast<Compound*>(g_body.Body())->Statements()[0])->Value();
+    ASSERT_EQUAL(dynamic_cast<VariableValue*>(g_value)->GetSlot(), NO_SLOT);
+}
+
+void TestParamsOverrideSelf() {
+    auto program = ParseText(R"(class C:
+  def f(self, a, a):
+    return self + a
+)"s);
+    const runtime::Method& f = MethodOf(*program, "f"sv);
+    Statement* body = dynamic_cast<MethodBody&>(*f.body).Body();
+    ASSERT_EQUAL(ResolveLocals(body, f.formal_params), 4U);
+    auto* sum = dynamic_cast<Add*>(dynamic_cast<Return*>(dynamic_cast<Compound*>(body)->Statements()[0])->Value());
+    ASSERT_EQUAL(dynamic_cast<VariableValue*>(sum->Lhs())->GetSlot(), 0U);
+    // При повторе имени переменной соответствует последний параметр
+    ASSERT_EQUAL(dynamic_cast<VariableValue*>(sum->Rhs())->GetSlot(), 2U);
+}
+
+void TestMethodsRunInFrames() {
+    const string text = R"(class Counter:
+  def __init__(start):
+    self.value = start
+  def add(n):
+    total = self.value + n
+    self.value = total
+    return total
+  def big(n):
+    if n > 10:
+      big = 'big'
+    return big
+  def __str__():
+    return 'Counter(' + str(self.value) + ')'
+x = 5
+c = Counter(x)
+print c.add(1), c.add(2), c
+print c.big(20)
+print c.big(1)
+)"s;
+    for (const BodyParsing bodies : {BodyParsing::EAGER, BodyParsing::LAZY}) {
+        auto program = ParseText(text, bodies);
+        ASSERT_EQUAL(Run(*program), "6 8 Counter(8)\nbig\n<error: No such variable!>"s);
+        // Второй запуск идёт по уже назначенным ячейкам
+        ASSERT_EQUAL(Run(*program), "6 8 Counter(8)\nbig\n<error: No such variable!>"s);
+    }
+
+    // Тело с назначенными ячейками можно выполнить и с параметрами в Closure
+    auto program = ParseText(text);
+    Run(*program);
+    runtime::DummyContext context;
+    runtime::Closure closure{{"n"s, runtime::ObjectHolder::Own(runtime::Number(11))}};
+    const runtime::Method& big = MethodOf(*program, "big"sv);
+    ASSERT(dynamic_cast<MethodBody&>(*big.body).GetSlotCount() != 0);
+    ASSERT_EQUAL(big.body->Execute(closure, context).TryAs<runtime::String>()->GetValue(), "big"s);
+}
+
+void TestDeepRecursion() {
+    // Кадры глубокой рекурсии не помещаются в один блок стека вызовов
+    const string text = R"(class Walker:
+  def down(n, a, b, c, d, e, f, g):
+    if n == 0:
+      return a + b + c + d + e + f + g
+    x = n - 1
+    y = self.down(x, a, b, c, d, e, f, g + 1)
+    return y + n
+  def fail(n):
+    if n == 0:
+      return missing
+    return self.fail(n - 1)
+w = Walker()
+print w.down(700, 1, 2, 3, 4, 5, 6, 0)
+print w.fail(300)
+)"s;
+    auto program = ParseText(text);
+    const string expected = "246071\n<error: No such variable!>"s;
+    ASSERT_EQUAL(Run(*program), expected);
+    // После ошибки в глубине рекурсии стек вызовов снова пуст
+    ASSERT_EQUAL(Run(*program), expected);
+}
+
+}  // namespace
+
+void RunResolveTests(TestRunner& tr) {
+    RUN_TEST(tr, TestAssignsSlots);
+    RUN_TEST(tr, TestParamsOverrideSelf);
+    RUN_TEST(tr, TestMethodsRunInFrames);
+    RUN_TEST(tr, TestDeepRecursion);
+}
+
+}  // namespace ast
@@ -9,9 +9,10 @@ using namespace std;
 namespace runtime {
 
 	namespace {
-		const string EQ_METHOD = "__eq__";
-		const string LT_METHOD = "__lt__";
-		const string STR_METHOD = "__str__"s;
+		const Symbol EQ_METHOD = "__eq__"sv;
+		const Symbol LT_METHOD = "__lt__"sv;
+		const Symbol STR_METHOD = "__str__"sv;
+		const Symbol SELF = "self"sv;
 	}  // namespace
 
 	// -------------------------- ObjectHolder -----------------------------
@@ -24,8 +25,9 @@ namespace runtime {
 	}
 
 	ObjectHolder ObjectHolder::Share(Object& object) {
-		// Возвращаем невладеющий shared_ptr (его deleter ничего не делает)
-		return ObjectHolder(std::shared_ptr<Object>(&object, [](auto* /*p*/) { /* do nothing */ }));
+		// Возвращаем невладеющий shared_ptr: конструктор псевдонима с пустым shared_ptr
+		// не создаёт блок управления, поэтому не обращается к куче
+		return ObjectHolder(std::shared_ptr<Object>(std::shared_ptr<Object>(), &object));
 	}
 
 	ObjectHolder ObjectHolder::None() {
@@ -66,6 +68,17 @@ namespace runtime {
 		return false;
 	}
 
+	ObjectHolder Executable::ExecuteMethod(const std::vector<Symbol>& formal_params, const ObjectHolder& self,
+		const ObjectHolder* actual_args, Context& context) {
+		Closure temp_closure;
+		temp_closure[SELF] = self;
+		// Добавляем аргументы
+		for (size_t i = 0; i < formal_params.size(); ++i) {
+			temp_closure[formal_params[i]] = actual_args[i];
+		}
+		return Execute(temp_closure, context);
+	}
+
 	void ClassInstance::Print(std::ostream& os, Context& context) {		
 		if (HasMethod(STR_METHOD, 0)) {
 			Call(STR_METHOD, {}, context)->Print(os, context);
@@ -75,7 +88,7 @@ namespace runtime {
 		}
 	}
 
-	bool ClassInstance::HasMethod(const std::string& method, size_t argument_count) const {
+	bool ClassInstance::HasMethod(Symbol method, size_t argument_count) const {
 		const Method* method_ptr = cls_.GetMethod(method);
 		if (method_ptr != nullptr && method_ptr->formal_params.size() == argument_count) {
 			return true;
@@ -93,46 +106,67 @@ namespace runtime {
 		return closure_;
 	}
 
+	const Class& ClassInstance::GetClass() const {
+		return cls_;
+	}
+
 	ClassInstance::ClassInstance(const Class& cls)
 		: cls_(cls) {	
 	}
 
-	ObjectHolder ClassInstance::Call(const std::string& method,
+	ObjectHolder ClassInstance::Call(Symbol method,
 		const std::vector<ObjectHolder>& actual_args,
 		Context& context) {
+		return Call(method, actual_args.data(), actual_args.size(), context);
+	}
 
-		if (HasMethod(method, actual_args.size())) {
-			const Method* method_ptr = cls_.GetMethod(method);
-
-			Closure temp_closure;
-			temp_closure["self"] = ObjectHolder::Share(*this);
-			// Добавляем аргументы
-			for (size_t i = 0; i < actual_args.size(); ++i) {
-				temp_closure[method_ptr->formal_params[i]] = actual_args[i];
-			}
-
-			return method_ptr->body->Execute(temp_closure, context);
+	ObjectHolder ClassInstance::Call(Symbol method, const ObjectHolder* actual_args, size_t argument_count,
+		Context& context) {
+		const Method* method_ptr = cls_.GetMethod(method);
+		if (method_ptr != nullptr && method_ptr->formal_params.size() == argument_count) {
+			return method_ptr->body->ExecuteMethod(method_ptr->formal_params, ObjectHolder::Share(*this),
+				actual_args, context);
 		}
 		else {
 			throw std::runtime_error("There is no such method!"s);
 		}
 	}
 
-	Class::Class(std::string name, std::vector<Method> methods, const Class* parent)
+	Class::Class(Symbol name, std::vector<Method> methods, const Class* parent)
 		: name_(name), methods_(std::move(methods)), parent_(parent) {
 		if (parent != nullptr) {
 
 		}
 	}
 
-	const Method* Class::GetMethod(const std::string& name) const {
+	void Class::SetMethods(std::vector<Method> methods) {
+		methods_ = std::move(methods);
+	}
+
+	const std::vector<Method>& Class::GetMethods() const {
+		return methods_;
+	}
+
+	std::vector<Method>& Class::GetMethods() {
+		return methods_;
+	}
+
+	void Class::RemoveMethods(const std::function<bool(const Method&)>& unused) {
+		methods_.erase(std::remove_if(methods_.begin(), methods_.end(), unused), methods_.end());
+	}
+
+	const Class* Class::GetParent() const {
+		return parent_;
+	}
+
+	const Method* Class::GetMethod(Symbol name) const {
 		// Проверяем ввначале в текущем классе а потом в родительских классах
 		auto child = this;
 		while (true) {
 			const auto result = std::find_if(
 				child->methods_.begin(),
 				child->methods_.end(),
-				[this, &name](const Method& method) {
+				[name](const Method& method) {
 					if (method.name == name) {
 						return true;
 					}
@@ -154,6 +188,10 @@ namespace runtime {
 	}
 
 	[[nodiscard]] const std::string& Class::GetName() const {
+		return name_.Name();
+	}
+
+	Symbol Class::GetSymbol() const {
 		return name_;
 	}
 
@@ -174,7 +212,7 @@ namespace runtime {
 		else if (lhs.TryAs<runtime::ClassInstance>() != nullptr) {
 			auto obj_ptr = lhs.TryAs<runtime::ClassInstance>();
 			if (obj_ptr->HasMethod(EQ_METHOD, 1)) {
-				return IsTrue(obj_ptr->Call(EQ_METHOD, { rhs }, context));
+				return IsTrue(obj_ptr->Call(EQ_METHOD, &rhs, 1, context));
 			}
 		}
 		else if (lhs.TryAs<runtime::Number>() != nullptr && rhs.TryAs<runtime::Number>() != nullptr) {
@@ -194,7 +232,7 @@ namespace runtime {
 		if (lhs.TryAs<runtime::ClassInstance>() != nullptr) {
 			auto obj_ptr = lhs.TryAs<runtime::ClassInstance>();
 			if (obj_ptr->HasMethod(LT_METHOD, 1)) {
-				return IsTrue(obj_ptr->Call(LT_METHOD, { rhs }, context));
+				return IsTrue(obj_ptr->Call(LT_METHOD, &rhs, 1, context));
 			}
 		}
 		else if (lhs.TryAs<runtime::Number>() != nullptr && rhs.TryAs<runtime::Number>() != nullptr) {
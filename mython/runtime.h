@@ -1,22 +1,53 @@
 #pragma once
 
+#include "symbol.h"
+
+#include <functional>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include <algorithm>
 
 namespace runtime {
 
+	class ObjectHolder;
+
 	// Контекст исполнения инструкций Mython
 	class Context {
 	public:
 		// Возвращает поток вывода для команд print
 		virtual std::ostream& GetOutputStream() = 0;
 
+		// Ячейки выполняемого метода (параметры, self и локальные переменные) либо nullptr,
+		// если выполняется код верхнего уровня
+		[[nodiscard]] ObjectHolder* GetFrame() const {
+			return frame_;
+		}
+
+		// Делает frame ячейками выполняемого метода и возвращает прежние ячейки
+		ObjectHolder* SwapFrame(ObjectHolder* frame) {
+			return std::exchange(frame_, frame);
+		}
+
+		// Истина, если в выполняемом методе выполнилась инструкция return: остальные его
+		// инструкции пропускаются, а составные инструкции возвращают значение return
+		[[nodiscard]] bool IsReturning() const {
+			return returning_;
+		}
+
+		void SetReturning(bool returning) {
+			returning_ = returning;
+		}
+
 	protected:
 		~Context() = default;
+
+	private:
+		ObjectHolder* frame_ = nullptr;
+		bool returning_ = false;
 	};
 
 	// Базовый класс для всех объектов языка Mython
@@ -76,7 +107,7 @@ namespace runtime {
 	class ValueObject : public Object {
 	public:
 		ValueObject(T v)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
-			: value_(v) {
+			: value_(std::move(v)) {
 		}
 
 		void Print(std::ostream& os, [[maybe_unused]] Context& context) override {
@@ -92,7 +123,7 @@ namespace runtime {
 	};
 
 	// Таблица символов, связывающая имя объекта с его значением
-	using Closure = std::unordered_map<std::string, ObjectHolder>;
+	using Closure = std::unordered_map<Symbol, ObjectHolder>;
 
 	// Проверяет, содержится ли в object значение, приводимое к True
 	// Для отличных от нуля чисел, True и непустых строк возвращается true. В остальных случаях - false.
@@ -105,6 +136,12 @@ namespace runtime {
 		// Выполняет действие над объектами внутри closure, используя context
 		// Возвращает результирующее значение либо None
 		virtual ObjectHolder Execute(Closure& closure, Context& context) = 0;
+
+		// Выполняет тело метода, вызванного у объекта self с параметрами formal_params.
+		// actual_args указывает на formal_params.size() значений параметров.
+		// По умолчанию собирает self и параметры в Closure и вызывает Execute
+		virtual ObjectHolder ExecuteMethod(const std::vector<Symbol>& formal_params, const ObjectHolder& self,
+			const ObjectHolder* actual_args, Context& context);
 	};
 
 	// Строковое значение
@@ -123,9 +160,9 @@ namespace runtime {
 	// Метод класса
 	struct Method {
 		// Имя метода
-		std::string name;
+		Symbol name;
 		// Имена формальных параметров метода
-		std::vector<std::string> formal_params;
+		std::vector<Symbol> formal_params;
 		// Тело метода
 		std::unique_ptr<Executable> body;
 	};
@@ -135,18 +172,36 @@ namespace runtime {
 	public:
 		// Создаёт класс с именем name и набором методов methods, унаследованный от класса parent
 		// Если parent равен nullptr, то создаётся базовый класс
-		explicit Class(std::string name, std::vector<Method> methods, const Class* parent);
+		explicit Class(Symbol name, std::vector<Method> methods, const Class* parent);
+
+		// Заменяет методы класса. Позволяет создать класс заранее, чтобы на него можно было
+		// сослаться, и добавить методы, когда их тела будут разобраны
+		void SetMethods(std::vector<Method> methods);
+
+		// Возвращает методы, объявленные в самом классе, без унаследованных
+		[[nodiscard]] const std::vector<Method>& GetMethods() const;
+		// Возвращает методы класса для замены их тел
+		[[nodiscard]] std::vector<Method>& GetMethods();
+
+		// Удаляет из класса методы, для которых unused возвращает true
+		void RemoveMethods(const std::function<bool(const Method&)>& unused);
+
+		// Возвращает родительский класс или nullptr, если класс базовый
+		[[nodiscard]] const Class* GetParent() const;
 
 		// Возвращает указатель на метод name или nullptr, если метод с таким именем отсутствует
-		[[nodiscard]] const Method* GetMethod(const std::string& name) const;
+		[[nodiscard]] const Method* GetMethod(Symbol name) const;
 
 		// Возвращает имя класса
 		[[nodiscard]] const std::string& GetName() const;
 
+		// Возвращает имя класса в виде символа
+		[[nodiscard]] Symbol GetSymbol() const;
+
 		// Выводит в os строку "Class <имя класса>", например "Class cat"
 		void Print(std::ostream& os, Context& context) override;
 	private:
-		std::string name_;
+		Symbol name_;
 		std::vector<Method> methods_;
 		const Class* parent_;
 	};
@@ -168,16 +223,22 @@ namespace runtime {
 		 * Если ни сам класс, ни его родители не содержат метод method, метод выбрасывает исключение
 		 * runtime_error
 		 */
-		ObjectHolder Call(const std::string& method, const std::vector<ObjectHolder>& actual_args,
+		ObjectHolder Call(Symbol method, const std::vector<ObjectHolder>& actual_args,
+			Context& context);
+		// То же, но argument_count значений параметров лежат подряд начиная с actual_args
+		ObjectHolder Call(Symbol method, const ObjectHolder* actual_args, size_t argument_count,
 			Context& context);
 
 		// Возвращает true, если объект имеет метод method, принимающий argument_count параметров
-		[[nodiscard]] bool HasMethod(const std::string& method, size_t argument_count) const;
+		[[nodiscard]] bool HasMethod(Symbol method, size_t argument_count) const;
 
 		// Возвращает ссылку на Closure, содержащий поля объекта
 		[[nodiscard]] Closure& Fields();
 		// Возвращает константную ссылку на Closure, содержащую поля объекта
 		[[nodiscard]] const Closure& Fields() const;
+
+		// Возвращает класс объекта
+		[[nodiscard]] const Class& GetClass() const;
 	private:
 		// Ссылка на класс
 		const Class& cls_;
@@ -0,0 +1,291 @@
+#include "bench_runner_p.h"
+#include "runtime.h"
+
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Микробенчмарки примитивов рантайма: ObjectHolder::Share, ObjectHolder::TryAs,
+// поиск в Closure и Class::GetMethod. Каждый примитив замеряется отдельно на разных размерах
+namespace {
+
+using runtime::Class;
+using runtime::ClassInstance;
+using runtime::Closure;
+using runtime::Context;
+using runtime::Method;
+using runtime::ObjectHolder;
+
+template <typename T>
+struct TypeTag {
+    using type = T;
+};
+
+class NoopBody : public runtime::Executable {
+public:
+    ObjectHolder Execute(Closure& /*closure*/, Context& /*context*/) override {
+        return {};
+    }
+};
+
+// Замер: name - имя примитива, params - размеры, run(iterations) - выполняет примитив
+// iterations раз
+struct Case {
+    string name;
+    vector<pair<string, int>> params;
+    function<void(size_t)> run;
+
+    [[nodiscard]] string FullName() const {
+        string result = name;
+        for (const auto& [key, value] : params) {
+            result += '/';
+            result += key;
+            result += '=';
+            result += to_string(value);
+        }
+        return result;
+    }
+};
+
+// Строит идентификатор длины length, уникальный для index
+string MakeId(size_t index, size_t length) {
+    string result = "v"s + to_string(index) + "_"s;
+    while (result.size() < length) {
+        result += static_cast<char>('a' + result.size() % 26);
+    }
+    return result;
+}
+
+vector<Method> MakeMethods(size_t count, const string& prefix) {
+    vector<Method> methods;
+    for (size_t i = 0; i < count; ++i) {
+        methods.push_back({MakeId(i, 8) + prefix, {}, make_unique<NoopBody>()});
+    }
+    return methods;
+}
+
+void AddHolderCases(vector<Case>& cases) {
+    auto number = make_shared<runtime::Number>(42);
+    cases.push_back({"share"s, {}, [number](size_t iterations) {
+                         for (size_t i = 0; i < iterations; ++i) {
+                             ObjectHolder holder = ObjectHolder::Share(*number);
+                             bench::DoNotOptimize(holder);
+                         }
+                     }});
+    cases.push_back({"own_number"s, {}, [](size_t iterations) {
+                         for (size_t i = 0; i < iterations; ++i) {
+                             auto holder = ObjectHolder::Own(runtime::Number(static_cast<int>(i)));
+                             bench::DoNotOptimize(holder);
+                         }
+                     }});
+    cases.push_back({"copy_holder"s, {}, [](size_t iterations) {
+                         const ObjectHolder original = ObjectHolder::Own(runtime::Number(1));
+                         for (size_t i = 0; i < iterations; ++i) {
+                             ObjectHolder copy = original;
+                             bench::DoNotOptimize(copy);
+                         }
+                     }});
+
+    auto cls = make_shared<Class>("Dummy"s, vector<Method>{}, nullptr);
+    auto instance = make_shared<ClassInstance>(*cls);
+
+    // Удачное и неудачное приведение для значения и для экземпляра класса
+    auto try_as = [](ObjectHolder holder, auto tag) {
+        using Target = typename decltype(tag)::type;
+        return [holder](size_t iterations) {
+            for (size_t i = 0; i < iterations; ++i) {
+                auto* ptr = holder.TryAs<Target>();
+                bench::DoNotOptimize(ptr);
+            }
+        };
+    };
+    const ObjectHolder number_holder = ObjectHolder::Share(*number);
+    const ObjectHolder instance_holder = ObjectHolder::Share(*instance);
+    cases.push_back({"try_as_number_hit"s, {}, try_as(number_holder, TypeTag<runtime::Number>{})});
+    cases.push_back({"try_as_number_miss"s, {}, try_as(number_holder, TypeTag<ClassInstance>{})});
+    cases.push_back({"try_as_instance_hit"s, {}, try_as(instance_holder, TypeTag<ClassInstance>{})});
+    cases.push_back({"try_as_instance_miss"s, {}, try_as(instance_holder, TypeTag<runtime::String>{})});
+
+    // Держим объекты живыми, пока живы замеры
+    cases.push_back({"is_true"s, {}, [number, cls, instance](size_t iterations) {
+                         const ObjectHolder holder = ObjectHolder::Share(*number);
+                         for (size_t i = 0; i < iterations; ++i) {
+                             bool result = runtime::IsTrue(holder);
+                             bench::DoNotOptimize(result);
+                         }
+                     }});
+}
+
+void AddClosureCases(vector<Case>& cases) {
+    for (int fields : {1, 4, 16, 64, 256}) {
+        for (int id_length : {1, 8, 32, 128}) {
+            auto closure = make_shared<Closure>();
+            // Ключи интернируются заранее, как это делает лексер
+            auto keys = make_shared<vector<runtime::Symbol>>();
+            for (int i = 0; i < fields; ++i) {
+                keys->emplace_back(MakeId(i, id_length));
+                (*closure)[keys->back()] = ObjectHolder::Own(runtime::Number(i));
+            }
+            const vector<pair<string, int>> params = {{"fields"s, fields}, {"id_length"s, id_length}};
+
+            cases.push_back({"closure_find"s, params, [closure, keys](size_t iterations) {
+                                 for (size_t i = 0; i < iterations; ++i) {
+                                     auto it = closure->find((*keys)[i % keys->size()]);
+                                     bench::DoNotOptimize(it);
+                                 }
+                             }});
+            // Так устроен VariableValue::Execute: count(), а затем at()
+            cases.push_back({"closure_count_at"s, params, [closure, keys](size_t iterations) {
+                                 for (size_t i = 0; i < iterations; ++i) {
+                                     const runtime::Symbol key = (*keys)[i % keys->size()];
+                                     if (closure->count(key) != 0) {
+                                         auto& value = closure->at(key);
+                                         bench::DoNotOptimize(value);
+                                     }
+                                 }
+                             }});
+            cases.push_back({"closure_assign"s, params, [closure, keys](size_t iterations) {
+                                 const ObjectHolder value = ObjectHolder::Own(runtime::Number(1));
+                                 for (size_t i = 0; i < iterations; ++i) {
+                                     (*closure)[(*keys)[i % keys->size()]] = value;
+                                 }
+                             }});
+        }
+    }
+}
+
+void AddMethodCases(vector<Case>& cases) {
+    // Поиск в одном классе с разным числом методов: первый и последний метод в списке
+    for (int methods : {1, 4, 16, 64}) {
+        auto cls = make_shared<Class>("Wide"s, MakeMethods(methods, ""s), nullptr);
+        const runtime::Symbol first = MakeId(0, 8);
+        const runtime::Symbol last = MakeId(methods - 1, 8);
+
+        cases.push_back({"get_method_first"s, {{"methods"s, methods}}, [cls, first](size_t iterations) {
+                             for (size_t i = 0; i < iterations; ++i) {
+                                 const Method* method = cls->GetMethod(first);
+                                 bench::DoNotOptimize(method);
+                             }
+                         }});
+        cases.push_back({"get_method_last"s, {{"methods"s, methods}}, [cls, last](size_t iterations) {
+                             for (size_t i = 0; i < iterations; ++i) {
+                                 const Method* method = cls->GetMethod(last);
+                                 bench::DoNotOptimize(method);
+                             }
+                         }});
+        const runtime::Symbol missing = "__missing__"sv;
+        cases.push_back({"get_method_missing"s, {{"methods"s, methods}}, [cls, missing](size_t iterations) {
+                             for (size_t i = 0; i < iterations; ++i) {
+                                 const Method* method = cls->GetMethod(missing);
+                                 bench::DoNotOptimize(method);
+                             }
+                         }});
+    }
+
+    // Метод объявлен только в корне цепочки наследования глубины depth
+    for (int depth : {1, 4, 16, 64}) {
+        auto chain = make_shared<vector<unique_ptr<Class>>>();
+        chain->push_back(make_unique<Class>("Root"s, MakeMethods(4, "_root"s), nullptr));
+        for (int i = 1; i < depth; ++i) {
+            const string level = to_string(i);
+            chain->push_back(
+                make_unique<Class>("Level"s + level, MakeMethods(4, "_"s + level), chain->back().get()));
+        }
+        const runtime::Symbol root_method = MakeId(3, 8) + "_root"s;
+
+        cases.push_back({"get_method_inherited"s, {{"depth"s, depth}}, [chain, root_method](size_t iterations) {
+                             const Class& leaf = *chain->back();
+                             for (size_t i = 0; i < iterations; ++i) {
+                                 const Method* method = leaf.GetMethod(root_method);
+                                 bench::DoNotOptimize(method);
+                             }
+                         }});
+        cases.push_back({"call_inherited"s, {{"depth"s, depth}}, [chain, root_method](size_t iterations) {
+                             runtime::DummyContext context;
+                             ClassInstance instance(*chain->back());
+                             for (size_t i = 0; i < iterations; ++i) {
+                                 ObjectHolder result = instance.Call(root_method, {}, context);
+                                 bench::DoNotOptimize(result);
+                             }
+                         }});
+    }
+}
+
+void RunBenchmarks(const bench::Options& options, size_t iterations, ostream& report) {
+    vector<Case> cases;
+    AddHolderCases(cases);
+    AddClosureCases(cases);
+    AddMethodCases(cases);
+
+    bench::JsonWriter json(report);
+    json.BeginObject();
+    json.Key("benchmark").Value("mython_runtime_primitives");
+    json.Key("warmup").Value(options.warmup);
+    json.Key("repeat").Value(options.repeat);
+    json.Key("iterations").Value(iterations);
+    json.Key("results").BeginArray();
+
+    for (const Case& c : cases) {
+        const string full_name = c.FullName();
+        if (!options.Selected(full_name)) {
+            continue;
+        }
+        for (int i = 0; i < options.warmup; ++i) {
+            c.run(iterations);
+        }
+        vector<double> samples;
+        for (int i = 0; i < options.repeat; ++i) {
+            const double ms = bench::MeasureMs([&c, iterations] {
+                c.run(iterations);
+            });
+            samples.push_back(ms * 1e6 / static_cast<double>(iterations));
+        }
+
+        json.BeginObject();
+        json.Key("name").Value(full_name);
+        json.Key("primitive").Value(c.name);
+        json.Key("params").BeginObject();
+        for (const auto& [key, value] : c.params) {
+            json.Key(key).Value(value);
+        }
+        json.EndObject();
+        json.Key("per_op").Value(bench::Summarize(std::move(samples)), "_ns");
+        json.EndObject();
+    }
+
+    json.EndArray();
+    json.EndObject();
+    report << endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        size_t iterations = 100000;
+        auto extra = [&iterations](string_view arg, const char* next) -> bool {
+            if (arg == "--iterations"sv && next != nullptr) {
+                iterations = max<size_t>(1, stoul(next));
+                return true;
+            }
+            throw invalid_argument("Unknown option "s + string(arg));
+        };
+        const bench::Options options = bench::ParseOptions(argc, argv, {}, extra);
+
+        if (options.out.empty()) {
+            RunBenchmarks(options, iterations, cout);
+        } else {
+            ofstream report(options.out);
+            RunBenchmarks(options, iterations, report);
+        }
+    } catch (const std::exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
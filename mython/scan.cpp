@@ -0,0 +1,209 @@
+#include "scan.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define MYTHON_HAS_X86_SIMD 1
+#endif
+
+namespace parse {
+
+	namespace {
+
+		inline bool IsIdentifierByte(char c) {
+			const auto u = static_cast<unsigned char>(c);
+			return static_cast<unsigned char>((u | 0x20) - 'a') < 26 || static_cast<unsigned char>(u - '0') < 10 || c == '_';
+		}
+
+		// ----------------------------- Скалярные ядра ------------------------------
+
+		const char* SkipSpacesScalar(const char* pos, const char* end) {
+			while (pos != end && *pos == ' ') {
+				++pos;
+			}
+			return pos;
+		}
+
+		const char* FindIdentifierEndScalar(const char* pos, const char* end) {
+			while (pos != end && IsIdentifierByte(*pos)) {
+				++pos;
+			}
+			return pos;
+		}
+
+		const char* FindQuoteOrBackslashScalar(const char* pos, const char* end, char quote) {
+			while (pos != end && *pos != quote && *pos != '\\') {
+				++pos;
+			}
+			return pos;
+		}
+
+		constexpr ScanKernels SCALAR_KERNELS = {
+			SkipSpacesScalar,
+			FindIdentifierEndScalar,
+			FindQuoteOrBackslashScalar,
+		};
+
+#ifdef MYTHON_HAS_X86_SIMD
+		// Векторные ядра обрабатывают текст целыми блоками, пока блок помещается в [pos, end),
+		// а остаток короче блока досматривают скалярным ядром. Маска movemask содержит по биту на
+		// байт блока, бит установлен у байтов, на которых участок заканчивается
+
+		// ------------------------------- SSE2 ----------------------------------------
+
+		// Байты-буквы, цифры и '_'. Проверка диапазона c - lo < n делается знаковым сравнением
+		// после сдвига на 0x80, так как в SSE2 нет беззнаковых сравнений байтов
+		inline __m128i IdentifierMask128(__m128i v) {
+			const __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+			const __m128i alpha = _mm_cmplt_epi8(_mm_add_epi8(lower, _mm_set1_epi8(static_cast<char>(0x80 - 'a'))),
+				_mm_set1_epi8(static_cast<char>(-128 + 26)));
+			const __m128i digit = _mm_cmplt_epi8(_mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(0x80 - '0'))),
+				_mm_set1_epi8(static_cast<char>(-128 + 10)));
+			const __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+			return _mm_or_si128(_mm_or_si128(alpha, digit), underscore);
+		}
+
+		const char* SkipSpacesSse2(const char* pos, const char* end) {
+			const __m128i space = _mm_set1_epi8(' ');
+			for (; end - pos >= 16; pos += 16) {
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+				const auto stop = static_cast<unsigned>(~_mm_movemask_epi8(_mm_cmpeq_epi8(v, space))) & 0xFFFFu;
+				if (stop != 0) {
+					return pos + __builtin_ctz(stop);
+				}
+			}
+			return SkipSpacesScalar(pos, end);
+		}
+
+		const char* FindIdentifierEndSse2(const char* pos, const char* end) {
+			for (; end - pos >= 16; pos += 16) {
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+				const auto stop = static_cast<unsigned>(~_mm_movemask_epi8(IdentifierMask128(v))) & 0xFFFFu;
+				if (stop != 0) {
+					return pos + __builtin_ctz(stop);
+				}
+			}
+			return FindIdentifierEndScalar(pos, end);
+		}
+
+		const char* FindQuoteOrBackslashSse2(const char* pos, const char* end, char quote) {
+			const __m128i quotes = _mm_set1_epi8(quote);
+			const __m128i backslashes = _mm_set1_epi8('\\');
+			for (; end - pos >= 16; pos += 16) {
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+				const auto stop = static_cast<unsigned>(_mm_movemask_epi8(
+					_mm_or_si128(_mm_cmpeq_epi8(v, quotes), _mm_cmpeq_epi8(v, backslashes))));
+				if (stop != 0) {
+					return pos + __builtin_ctz(stop);
+				}
+			}
+			return FindQuoteOrBackslashScalar(pos, end, quote);
+		}
+
+		constexpr ScanKernels SSE2_KERNELS = {
+			SkipSpacesSse2,
+			FindIdentifierEndSse2,
+			FindQuoteOrBackslashSse2,
+		};
+
+		// ------------------------------- AVX2 ----------------------------------------
+		// Функции собираются с поддержкой AVX2 независимо от флагов сборки, а вызываются,
+		// только если процессор её поддерживает
+
+#define MYTHON_AVX2 __attribute__((target("avx2")))
+
+		MYTHON_AVX2 inline __m256i IdentifierMask256(__m256i v) {
+			const __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+			const __m256i alpha = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(-128 + 26)),
+				_mm256_add_epi8(lower, _mm256_set1_epi8(static_cast<char>(0x80 - 'a'))));
+			const __m256i digit = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(-128 + 10)),
+				_mm256_add_epi8(v, _mm256_set1_epi8(static_cast<char>(0x80 - '0'))));
+			const __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+			return _mm256_or_si256(_mm256_or_si256(alpha, digit), underscore);
+		}
+
+		MYTHON_AVX2 const char* SkipSpacesAvx2(const char* pos, const char* end) {
+			const __m256i space = _mm256_set1_epi8(' ');
+			for (; end - pos >= 32; pos += 32) {
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+				const auto stop = ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, space)));
+				if (stop != 0) {
+					return pos + __builtin_ctz(stop);
+				}
+			}
+			return SkipSpacesSse2(pos, end);
+		}
+
+		MYTHON_AVX2 const char* FindIdentifierEndAvx2(const char* pos, const char* end) {
+			for (; end - pos >= 32; pos += 32) {
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+				const auto stop = ~static_cast<unsigned>(_mm256_movemask_epi8(IdentifierMask256(v)));
+				if (stop != 0) {
+					return pos + __builtin_ctz(stop);
+				}
+			}
+			return FindIdentifierEndSse2(pos, end);
+		}
+
+		MYTHON_AVX2 const char* FindQuoteOrBackslashAvx2(const char* pos, const char* end, char quote) {
+			const __m256i quotes = _mm256_set1_epi8(quote);
+			const __m256i backslashes = _mm256_set1_epi8('\\');
+			for (; end - pos >= 32; pos += 32) {
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+				const auto stop = static_cast<unsigned>(_mm256_movemask_epi8(
+					_mm256_or_si256(_mm256_cmpeq_epi8(v, quotes), _mm256_cmpeq_epi8(v, backslashes))));
+				if (stop != 0) {
+					return pos + __builtin_ctz(stop);
+				}
+			}
+			return FindQuoteOrBackslashSse2(pos, end, quote);
+		}
+
+#undef MYTHON_AVX2
+
+		constexpr ScanKernels AVX2_KERNELS = {
+			SkipSpacesAvx2,
+			FindIdentifierEndAvx2,
+			FindQuoteOrBackslashAvx2,
+		};
+#endif
+
+		ScanLevel SelectScanLevel() {
+#ifdef MYTHON_HAS_X86_SIMD
+			if (__builtin_cpu_supports("avx2")) {
+				return ScanLevel::AVX2;
+			}
+			// SSE2 входит в базовый набор инструкций x86-64
+			return ScanLevel::SSE2;
+#else
+			return ScanLevel::SCALAR;
+#endif
+		}
+
+	}  // namespace
+
+	const ScanKernels* GetScanKernels(ScanLevel level) {
+		switch (level) {
+		case ScanLevel::SCALAR:
+			return &SCALAR_KERNELS;
+#ifdef MYTHON_HAS_X86_SIMD
+		case ScanLevel::SSE2:
+			return &SSE2_KERNELS;
+		case ScanLevel::AVX2:
+			return __builtin_cpu_supports("avx2") ? &AVX2_KERNELS : nullptr;
+#endif
+		default:
+			return nullptr;
+		}
+	}
+
+	ScanLevel ActiveScanLevel() {
+		static const ScanLevel level = SelectScanLevel();
+		return level;
+	}
+
+	const ScanKernels& ActiveScanKernels() {
+		static const ScanKernels& kernels = *GetScanKernels(ActiveScanLevel());
+		return kernels;
+	}
+
+}  // namespace parse
@@ -0,0 +1,32 @@
+#pragma once
+
+namespace parse {
+
+	// Ядра сканирования для лексера: каждое находит конец однородного участка текста в [pos, end)
+	// и возвращает указатель на первый символ, который участку уже не принадлежит (или end).
+	// Векторные версии проверяют 16 (SSE2) или 32 (AVX2) байта за одну операцию
+	struct ScanKernels {
+		// Первый символ, отличный от пробела
+		const char* (*skip_spaces)(const char* pos, const char* end);
+		// Первый символ, который не может входить в идентификатор: не буква, не цифра и не '_'
+		const char* (*find_identifier_end)(const char* pos, const char* end);
+		// Первая кавычка quote или обратная косая черта
+		const char* (*find_quote_or_backslash)(const char* pos, const char* end, char quote);
+	};
+
+	enum class ScanLevel {
+		SCALAR,
+		SSE2,
+		AVX2,
+	};
+
+	// Возвращает ядра заданного уровня или nullptr, если процессор или сборка их не поддерживают
+	const ScanKernels* GetScanKernels(ScanLevel level);
+
+	// Возвращает самые быстрые ядра, доступные на этом процессоре. Выбор делается один раз
+	const ScanKernels& ActiveScanKernels();
+
+	// Возвращает уровень ядер, которые возвращает ActiveScanKernels()
+	ScanLevel ActiveScanLevel();
+
+}  // namespace parse
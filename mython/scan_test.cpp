@@ -0,0 +1,81 @@
+#include "scan.h"
+#include "test_runner_p.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace parse {
+
+namespace {
+vector<const ScanKernels*> AvailableKernels() {
+    vector<const ScanKernels*> result;
+    for (auto level : {ScanLevel::SCALAR, ScanLevel::SSE2, ScanLevel::AVX2}) {
+        if (const ScanKernels* kernels = GetScanKernels(level)) {
+            result.push_back(kernels);
+        }
+    }
+    return result;
+}
+
+void TestScalarKernelsAreAlwaysAvailable() {
+    ASSERT(GetScanKernels(ScanLevel::SCALAR) != nullptr);
+    ASSERT(GetScanKernels(ActiveScanLevel()) == &ActiveScanKernels());
+}
+
+void TestKernelsFindRunEnds() {
+    const string text = "    x"s + string(40, ' ') + "abc_XYZ_09"s + string(70, 'q') + "+tail\\rest\"end"s;
+    const char* begin = text.data();
+    const char* end = text.data() + text.size();
+
+    for (const ScanKernels* kernels : AvailableKernels()) {
+        ASSERT_EQUAL(kernels->skip_spaces(begin, end) - begin, 4);
+        ASSERT_EQUAL(kernels->skip_spaces(begin + 5, end) - begin, 45);
+        ASSERT_EQUAL(kernels->find_identifier_end(begin + 45, end) - begin, 125);
+        ASSERT_EQUAL(kernels->find_quote_or_backslash(begin, end, '"') - begin, 130);
+        ASSERT_EQUAL(kernels->find_quote_or_backslash(begin + 131, end, '"') - begin, 135);
+        ASSERT_EQUAL(kernels->find_quote_or_backslash(begin + 136, end, '\''), end);
+        ASSERT_EQUAL(kernels->skip_spaces(end, end), end);
+    }
+}
+
+// Все уровни должны давать тот же результат, что и скалярные ядра, при любом положении
+// конца участка относительно границ блоков
+void TestKernelsAgreeWithScalar() {
+    const ScanKernels& scalar = *GetScanKernels(ScanLevel::SCALAR);
+    const string alphabet = " aZ_09\\\"'\n#+\x80\xff"s;
+
+    mt19937 generator(57);
+    for (int iteration = 0; iteration < 2000; ++iteration) {
+        string text(generator() % 100, ' ');
+        // Длинные однородные участки перемежаются случайными символами
+        const char fill = alphabet[generator() % 4];
+        for (char& c : text) {
+            c = generator() % 8 == 0 ? alphabet[generator() % alphabet.size()] : fill;
+        }
+        const char* begin = text.data();
+        const char* end = text.data() + text.size();
+        const size_t start = text.empty() ? 0 : generator() % text.size();
+
+        for (const ScanKernels* kernels : AvailableKernels()) {
+            ASSERT_EQUAL(kernels->skip_spaces(begin + start, end), scalar.skip_spaces(begin + start, end));
+            ASSERT_EQUAL(kernels->find_identifier_end(begin + start, end),
+                         scalar.find_identifier_end(begin + start, end));
+            ASSERT_EQUAL(kernels->find_quote_or_backslash(begin + start, end, '"'),
+                         scalar.find_quote_or_backslash(begin + start, end, '"'));
+            ASSERT_EQUAL(kernels->find_quote_or_backslash(begin + start, end, '\''),
+                         scalar.find_quote_or_backslash(begin + start, end, '\''));
+        }
+    }
+}
+}  // namespace
+
+void RunScanTests(TestRunner& tr) {
+    RUN_TEST(tr, parse::TestScalarKernelsAreAlwaysAvailable);
+    RUN_TEST(tr, parse::TestKernelsFindRunEnds);
+    RUN_TEST(tr, parse::TestKernelsAgreeWithScalar);
+}
+
+}  // namespace parse
@@ -0,0 +1,109 @@
+#include "source_file.h"
+
+#include <cstdio>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MYTHON_HAS_MMAP 1
+#endif
+
+using namespace std;
+
+namespace parse {
+
+namespace {
+
+// Считывает файл целиком блоками в буфер
+void ReadAll(FILE* file, const string& path, string& buffer) {
+    char chunk[1 << 16];
+    size_t read = 0;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        buffer.append(chunk, read);
+    }
+    if (ferror(file) != 0) {
+        throw runtime_error("Cannot read file "s + path);
+    }
+}
+
+#ifdef MYTHON_HAS_MMAP
+// Отображает обычный непустой файл в память. Возвращает nullptr, если файл отобразить нельзя,
+// тогда его следует прочитать обычным образом
+const char* MapFile(int fd, size_t& size) {
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) {
+        return nullptr;
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    // Лексер проходит текст один раз от начала до конца
+    madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+    size = static_cast<size_t>(info.st_size);
+    return static_cast<const char*>(data);
+}
+#endif
+
+}  // namespace
+
+SourceFile::SourceFile(const string& path) {
+    if (path == "-"s) {
+        ReadAll(stdin, path, buffer_);
+        return;
+    }
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        throw runtime_error("Cannot open file "s + path);
+    }
+#ifdef MYTHON_HAS_MMAP
+    // Отображение остаётся действительным и после закрытия файла
+    mapped_ = MapFile(fileno(file), mapped_size_);
+#endif
+    try {
+        if (mapped_ == nullptr) {
+            ReadAll(file, path, buffer_);
+        }
+    } catch (...) {
+        fclose(file);
+        throw;
+    }
+    fclose(file);
+}
+
+SourceFile::SourceFile(SourceFile&& other) noexcept
+    : mapped_(exchange(other.mapped_, nullptr))
+    , mapped_size_(exchange(other.mapped_size_, 0))
+    , buffer_(std::move(other.buffer_)) {
+}
+
+SourceFile& SourceFile::operator=(SourceFile&& other) noexcept {
+    if (this != &other) {
+        Unmap();
+        mapped_ = exchange(other.mapped_, nullptr);
+        mapped_size_ = exchange(other.mapped_size_, 0);
+        buffer_ = std::move(other.buffer_);
+    }
+    return *this;
+}
+
+SourceFile::~SourceFile() {
+    Unmap();
+}
+
+void SourceFile::Unmap() noexcept {
+#ifdef MYTHON_HAS_MMAP
+    if (mapped_ != nullptr) {
+        munmap(const_cast<char*>(mapped_), mapped_size_);
+    }
+#endif
+    mapped_ = nullptr;
+    mapped_size_ = 0;
+}
+
+}  // namespace parse
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace parse {
+
+// Текст программы, загруженный из файла. Обычный файл отображается в память только для чтения,
+// и лексер читает его прямо из отображения без копирования. Стандартный ввод, каналы и прочие
+// файлы, которые нельзя отобразить, считываются в собственный буфер
+class SourceFile {
+public:
+    // Загружает файл path. Путь "-" означает стандартный ввод.
+    // Выбрасывает std::runtime_error, если файл не удалось открыть или прочитать
+    explicit SourceFile(const std::string& path);
+
+    SourceFile(SourceFile&& other) noexcept;
+    SourceFile& operator=(SourceFile&& other) noexcept;
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    ~SourceFile();
+
+    // Текст остаётся действительным, пока жив объект SourceFile
+    [[nodiscard]] std::string_view Text() const {
+        return mapped_ != nullptr ? std::string_view{mapped_, mapped_size_} : std::string_view{buffer_};
+    }
+
+    // Возвращает true, если текст читается из отображения файла в память
+    [[nodiscard]] bool IsMapped() const {
+        return mapped_ != nullptr;
+    }
+
+private:
+    void Unmap() noexcept;
+
+    const char* mapped_ = nullptr;
+    std::size_t mapped_size_ = 0;
+    std::string buffer_;
+};
+
+}  // namespace parse
@@ -0,0 +1,83 @@
+#include "lexer.h"
+#include "source_file.h"
+#include "test_runner_p.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace parse {
+
+namespace {
+// Временный файл, удаляемый при выходе из области видимости
+class TempFile {
+public:
+    explicit TempFile(const string& content)
+        : path_(filesystem::temp_directory_path()
+                / ("mython_source_file_test_"s + to_string(reinterpret_cast<uintptr_t>(this)))) {
+        ofstream(path_, ios::binary) << content;
+    }
+
+    ~TempFile() {
+        error_code ignored;
+        filesystem::remove(path_, ignored);
+    }
+
+    [[nodiscard]] string Path() const {
+        return path_.string();
+    }
+
+private:
+    filesystem::path path_;
+};
+
+void TestRegularFileIsMapped() {
+    const string content = "x = 42\nprint \"hello\", x\n"s;
+    TempFile file(content);
+
+    SourceFile source(file.Path());
+    ASSERT(source.IsMapped());
+    ASSERT_EQUAL(source.Text(), content);
+
+    Lexer lexer(source.Text());
+    ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{"x"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{'='}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{42}));
+}
+
+void TestEmptyFile() {
+    TempFile file(""s);
+
+    SourceFile source(file.Path());
+    ASSERT(source.Text().empty());
+
+    Lexer lexer(source.Text());
+    ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Eof{}));
+}
+
+void TestMovedSourceKeepsText() {
+    const string content = "print 1\n"s;
+    TempFile file(content);
+
+    SourceFile source(file.Path());
+    SourceFile moved(std::move(source));
+    ASSERT_EQUAL(moved.Text(), content);
+}
+
+void TestMissingFileThrows() {
+    ASSERT_THROWS(SourceFile("/nonexistent/mython/script.my"s), runtime_error);
+}
+}  // namespace
+
+void RunSourceFileTests(TestRunner& tr) {
+    RUN_TEST(tr, parse::TestRegularFileIsMapped);
+    RUN_TEST(tr, parse::TestEmptyFile);
+    RUN_TEST(tr, parse::TestMovedSourceKeepsText);
+    RUN_TEST(tr, parse::TestMissingFileThrows);
+}
+
+}  // namespace parse
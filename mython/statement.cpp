@@ -1,6 +1,10 @@
 #include "statement.h"
+#include "resolve.h"
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <sstream>
 
 using namespace std;
@@ -12,51 +16,210 @@ namespace ast {
 	using runtime::ObjectHolder;
 
 	namespace {
-		const string ADD_METHOD = "__add__"s;
-		const string INIT_METHOD = "__init__"s;
-		const string STR_METHOD = "__str__"s;
+		const runtime::Symbol ADD_METHOD = "__add__"sv;
+		const runtime::Symbol INIT_METHOD = "__init__"sv;
+		const runtime::Symbol STR_METHOD = "__str__"sv;
+		const runtime::Symbol SELF = "self"sv;
+
+		// Стек вызовов обхода дерева: аргументы вызовов и кадры методов. Ячейки выделяются подряд
+		// из блоков, которые не перемещаются и не освобождаются, поэтому после первых вызовов
+		// вызов метода не обращается к куче, а ячейки живого кадра не меняют адрес
+		class CallStack {
+		public:
+			// Вершина стека
+			struct Mark {
+				size_t block;
+				size_t top;
+			};
+
+			[[nodiscard]] Mark GetMark() const {
+				return { block_, top_ };
+			}
+
+			// Выделяет count пустых ячеек подряд
+			ObjectHolder* Allocate(size_t count) {
+				if (blocks_.empty() || top_ + count > blocks_[block_].size) {
+					NextBlock(count);
+				}
+				ObjectHolder* cells = blocks_[block_].cells.get() + top_;
+				top_ += count;
+				return cells;
+			}
+
+			// Возвращает вершину стека в mark. Освобождаемые ячейки должны быть пустыми
+			void Release(Mark mark) {
+				block_ = mark.block;
+				top_ = mark.top;
+			}
+
+		private:
+			static constexpr size_t BLOCK_SIZE = 4096;
+
+			struct Block {
+				std::unique_ptr<ObjectHolder[]> cells;
+				size_t size;
+			};
+
+			// Переходит к следующему блоку, в котором помещается count ячеек
+			void NextBlock(size_t count) {
+				size_t next = blocks_.empty() ? 0 : block_ + 1;
+				while (next < blocks_.size() && blocks_[next].size < count) {
+					++next;
+				}
+				if (next == blocks_.size()) {
+					const size_t size = std::max(BLOCK_SIZE, count);
+					blocks_.push_back({ std::make_unique<ObjectHolder[]>(size), size });
+				}
+				block_ = next;
+				top_ = 0;
+			}
+
+			std::vector<Block> blocks_;
+			size_t block_ = 0;
+			size_t top_ = 0;
+		};
+
+		CallStack& Stack() {
+			thread_local CallStack stack;
+			return stack;
+		}
+
+		// Ячейки стека вызовов, которые освобождаются при выходе из области видимости
+		class StackCells {
+		public:
+			explicit StackCells(size_t count)
+				: mark_(Stack().GetMark()), cells_(Stack().Allocate(count)), count_(count) {
+			}
+
+			StackCells(const StackCells&) = delete;
+			StackCells& operator=(const StackCells&) = delete;
+
+			~StackCells() {
+				// Значения, оставшиеся в ячейках, не должны жить дольше вызова
+				std::fill(cells_, cells_ + count_, ObjectHolder());
+				Stack().Release(mark_);
+			}
+
+			ObjectHolder* Get() const {
+				return cells_;
+			}
+		private:
+			CallStack::Mark mark_;
+			ObjectHolder* cells_;
+			size_t count_;
+		};
+
+		// Выполняет тело метода body. Возвращает значение выполненной в нём инструкции return
+		// либо None
+		ObjectHolder ExecuteBody(Statement* body, Closure& closure, Context& context) {
+			ObjectHolder result = body->Execute(closure, context);
+			if (context.IsReturning()) {
+				context.SetReturning(false);
+				return result;
+			}
+			return {};
+		}
+
+		// Делает frame ячейками выполняемого метода и возвращает прежние ячейки при выходе
+		class FrameGuard {
+		public:
+			FrameGuard(Context& context, ObjectHolder* frame)
+				: context_(context), previous_(context.SwapFrame(frame)) {
+			}
+
+			FrameGuard(const FrameGuard&) = delete;
+			FrameGuard& operator=(const FrameGuard&) = delete;
+
+			~FrameGuard() {
+				context_.SwapFrame(previous_);
+			}
+		private:
+			Context& context_;
+			ObjectHolder* previous_;
+		};
 	}  // namespace
 
+	StringConst::StringConst(runtime::String value)
+		: value_(ObjectHolder::Own(std::move(value))) {
+	}
+
+	StringConst::StringConst(ObjectHolder value)
+		: value_(std::move(value)) {
+	}
+
+	ObjectHolder StringConst::Execute(Closure& /*closure*/, Context& /*context*/) {
+		return value_;
+	}
+
 	ObjectHolder Assignment::Execute(Closure& closure, Context& context ) {		
-		return closure[var_] = rv_.get()->Execute(closure, context);		
+		if (slot_ != NO_SLOT) {
+			return context.GetFrame()[slot_] = rv_->Execute(closure, context);
+		}
+		return closure[var_] = rv_->Execute(closure, context);
+	}
+
+	Assignment::Assignment(runtime::Symbol var, Statement* rv)
+		: var_(var), rv_(rv) {
+	}
+
+	VariableValue::VariableValue(runtime::Symbol var_name)
+		: ids_{ var_name } {
 	}
 
-	Assignment::Assignment(std::string var, std::unique_ptr<Statement> rv)
-		: var_(var), rv_(std::move(rv)) {
+	VariableValue::VariableValue(std::pmr::vector<runtime::Symbol> dotted_ids)
+		: ids_(std::move(dotted_ids)) {		
 	}
 
-	VariableValue::VariableValue(const std::string& var_name)
-		: ids_{ var_name } {
-	}
-
-	VariableValue::VariableValue(std::vector<std::string> dotted_ids)
-		: ids_(dotted_ids) {		
+	VariableValue::VariableValue(const std::vector<std::string>& dotted_ids)
+		: ids_(dotted_ids.begin(), dotted_ids.end()) {
 	}
 
 	ObjectHolder VariableValue::Execute(Closure& closure, Context& context) {
-		if (closure.count(ids_[0]) == 0) {
-			throw runtime_error("No such variable!");
+		// Спускаемся по цепочке полей id1.id2.id3, не копируя её
+		Closure* scope = &closure;
+		size_t i = 0;
+		if (slot_ != NO_SLOT) {
+			const ObjectHolder& value = context.GetFrame()[slot_];
+			if (IsUnassigned(value)) {
+				throw runtime_error("No such variable!");
+			}
+			if (ids_.size() == 1) {
+				return value;
+			}
+			auto obj = value.TryAs<runtime::ClassInstance>();
+			if (obj == nullptr) {
+				throw runtime_error("No such variable!");
+			}
+			scope = &obj->Fields();
+			i = 1;
 		}
-		
-		auto& result = closure.at(ids_[0]);
-		if (ids_.size() > 1) {		
-			auto obj = result.TryAs<runtime::ClassInstance>();
-			return VariableValue( std::vector<std::string>{ ids_.begin() + 1, ids_.end() } ).Execute(obj->Fields(), context);
+		for (;; ++i) {
+			const auto it = scope->find(ids_[i]);
+			if (it == scope->end()) {
+				throw runtime_error("No such variable!");
+			}
+			if (i + 1 == ids_.size()) {
+				return it->second;
+			}
+			auto obj = it->second.TryAs<runtime::ClassInstance>();
+			if (obj == nullptr) {
+				throw runtime_error("No such variable!");
+			}
+			scope = &obj->Fields();
 		}
-
-		return result;
 	}
 
-	unique_ptr<Print> Print::Variable(const std::string& name) {
-		
-		return std::move(make_unique<Print>(make_unique<VariableValue>(name)));
+	Print* Print::Variable(runtime::Symbol name, Arena& arena) {
+		StatementList args(&arena);
+		args.push_back(arena.Make<VariableValue>(std::pmr::vector<runtime::Symbol>({ name }, &arena)));
+		return arena.Make<Print>(std::move(args));
 	}
 
-	Print::Print(unique_ptr<Statement> argument) {
-		args_.push_back(std::move(argument));
+	Print::Print(Statement* argument) {
+		args_.push_back(argument);
 	}
 
-	Print::Print(vector<unique_ptr<Statement>> args)
+	Print::Print(StatementList args)
 		: args_(std::move(args)) {
 	}
 
@@ -81,19 +244,18 @@ namespace ast {
 		return {};
 	}
 
-	MethodCall::MethodCall(std::unique_ptr<Statement> object, std::string method,
-		std::vector<std::unique_ptr<Statement>> args)
-		: object_(std::move(object)), method_(method), args_(std::move(args)) {
+	MethodCall::MethodCall(Statement* object, runtime::Symbol method, StatementList args)
+		: object_(object), method_(method), args_(std::move(args)) {
 	}
 
 	ObjectHolder MethodCall::Execute(Closure& closure, Context& context) {
-		vector<ObjectHolder> obj_args;
-		for (const auto& arg : args_) {
-			obj_args.push_back(arg->Execute(closure, context));
+		StackCells obj_args(args_.size());
+		for (size_t i = 0; i < args_.size(); ++i) {
+			obj_args.Get()[i] = args_[i]->Execute(closure, context);
 		}
 
 		auto obj = object_->Execute(closure, context);
-		return obj.TryAs<runtime::ClassInstance>()->Call(method_, obj_args, context);	
+		return obj.TryAs<runtime::ClassInstance>()->Call(method_, obj_args.Get(), args_.size(), context);	
 	}
 
 	ObjectHolder Stringify::Execute(Closure& closure, Context& context) {
@@ -137,7 +299,7 @@ namespace ast {
 		else if (lhs_obj.TryAs<runtime::ClassInstance>() != nullptr) {
 			auto lhs_class_obj = lhs_obj.TryAs<runtime::ClassInstance>();
 			if (lhs_class_obj->HasMethod(ADD_METHOD, 1)) {
-				return lhs_class_obj->Call(ADD_METHOD, { rhs_obj }, context);
+				return lhs_class_obj->Call(ADD_METHOD, &rhs_obj, 1, context);
 			}
 		}
 
@@ -168,6 +330,15 @@ namespace ast {
 		throw std::runtime_error("Wrong types!");
 	}
 
+	ObjectHolder Negate::Execute(Closure& closure, Context& context) {
+		auto obj = argument_->Execute(closure, context);
+		if (const auto* number = obj.TryAs<runtime::Number>()) {
+			return ObjectHolder::Own(runtime::Number{ -number->GetValue() });
+		}
+
+		throw std::runtime_error("Wrong types!");
+	}
+
 	ObjectHolder Div::Execute(Closure& closure, Context& context) {
 		auto lhs_obj = lhs_->Execute(closure, context);
 		auto rhs_obj = rhs_->Execute(closure, context);
@@ -184,31 +355,60 @@ namespace ast {
 		throw std::runtime_error("Wrong types!");
 	}
 
+	void Compound::ReplaceStatements(size_t pos, size_t count, const std::vector<Statement*>& stmts) {
+		const auto first = stmts_.begin() + static_cast<std::ptrdiff_t>(pos);
+		const auto common = std::min(count, stmts.size());
+		// Общая часть заменяется на месте, остаток вставляется или удаляется одним сдвигом
+		std::copy(stmts.begin(), stmts.begin() + static_cast<std::ptrdiff_t>(common), first);
+		if (count > common) {
+			stmts_.erase(first + static_cast<std::ptrdiff_t>(common), first + static_cast<std::ptrdiff_t>(count));
+		} else {
+			stmts_.insert(first + static_cast<std::ptrdiff_t>(common),
+				stmts.begin() + static_cast<std::ptrdiff_t>(common), stmts.end());
+		}
+	}
+
 	ObjectHolder Compound::Execute(Closure& closure, Context& context) {
-		for (const auto& stmt : stmts_) {
-			stmt->Execute(closure, context);
+		for (Statement* stmt : stmts_) {
+			ObjectHolder result = stmt->Execute(closure, context);
+			if (context.IsReturning()) {
+				return result;
+			}
 		}
 
 		return None{}.Execute(closure, context);
 	}
 
 	ObjectHolder Return::Execute(Closure& closure, Context& context) {
-		throw ReturnException(std::move(statement_->Execute(closure, context)));
+		ObjectHolder result = statement_->Execute(closure, context);
+		context.SetReturning(true);
+		return result;
 	}
 
 	ClassDefinition::ClassDefinition(ObjectHolder cls)
 		:  cls_(cls) {
 	}
 
-	ObjectHolder ClassDefinition::Execute(Closure& closure, Context& /*context*/) {		
+	const runtime::Class& ClassDefinition::GetClass() const {
+		return *cls_.TryAs<runtime::Class>();
+	}
+
+	runtime::Class& ClassDefinition::GetClass() {
+		return *cls_.TryAs<runtime::Class>();
+	}
+
+	ObjectHolder ClassDefinition::Execute(Closure& closure, Context& context) {		
 		runtime::ClassInstance new_inst{ *cls_.TryAs<runtime::Class>() };
 
-		return closure[cls_.TryAs<runtime::Class>()->GetName()] = ObjectHolder::Own(std::move(new_inst));		
+		if (slot_ != NO_SLOT) {
+			return context.GetFrame()[slot_] = ObjectHolder::Own(std::move(new_inst));
+		}
+		return closure[cls_.TryAs<runtime::Class>()->GetSymbol()] = ObjectHolder::Own(std::move(new_inst));		
 	}
 
-	FieldAssignment::FieldAssignment(VariableValue object, std::string field_name,
-		std::unique_ptr<Statement> rv)
-		: object_(object), field_name_(field_name), rv_(std::move(rv)) {
+	FieldAssignment::FieldAssignment(VariableValue object, runtime::Symbol field_name,
+		Statement* rv)
+		: object_(std::move(object)), field_name_(field_name), rv_(rv) {
 	}
 
 	ObjectHolder FieldAssignment::Execute(Closure& closure, Context& context) {		
@@ -217,8 +417,8 @@ namespace ast {
 		return cls->Fields()[field_name_] = rv_->Execute(closure, context);
 	}
 
-	IfElse::IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> if_body, std::unique_ptr<Statement> else_body)
-		: condition_(std::move(condition)), if_body_(std::move(if_body)), else_body_(std::move(else_body)) {
+	IfElse::IfElse(Statement* condition, Statement* if_body, Statement* else_body)
+		: condition_(condition), if_body_(if_body), else_body_(else_body) {
 	}
 
 	ObjectHolder IfElse::Execute(Closure& closure, Context& context) {
@@ -251,17 +451,21 @@ namespace ast {
 		return ObjectHolder::Own(runtime::Bool(result));
 	}
 
-	Comparison::Comparison(Comparator cmp, unique_ptr<Statement> lhs, unique_ptr<Statement> rhs)
-		: BinaryOperation(std::move(lhs), std::move(rhs)), cmp_(cmp) {		
+	Comparison::Comparison(Comparator cmp, Statement* lhs, Statement* rhs)
+		: BinaryOperation(lhs, rhs), cmp_(cmp) {
 	}
 
 	ObjectHolder Comparison::Execute(Closure& closure, Context& context) {		
-		bool result = cmp_(lhs_->Execute(closure, context), rhs_->Execute(closure, context), context);
+		// Порядок вычисления аргументов функции не задан, поэтому аргументы сравнения
+		// вычисляются отдельно: сначала левый, затем правый, как у остальных операций
+		const auto lhs_obj = lhs_->Execute(closure, context);
+		const auto rhs_obj = rhs_->Execute(closure, context);
+		bool result = cmp_(lhs_obj, rhs_obj, context);
 
 		return ObjectHolder::Own(runtime::Bool(result));
 	}
 
-	NewInstance::NewInstance(const runtime::Class& class_, std::vector<std::unique_ptr<Statement>> args)
+	NewInstance::NewInstance(const runtime::Class& class_, StatementList args)
 		: class_instance_{ class_ }, args_{ std::move(args) } {
 	}
 
@@ -270,29 +474,98 @@ namespace ast {
 	}
 
 	ObjectHolder NewInstance::Execute(Closure& closure, Context& context) {		
-		if (class_instance_.HasMethod(INIT_METHOD, args_.size())) {
-			std::vector<runtime::ObjectHolder> actual_args;
-			for (auto& arg : args_) {
-				actual_args.push_back(arg->Execute(closure, context));
-			}
-			class_instance_.Call(INIT_METHOD, actual_args, context);
-		}
+		if (class_instance_.HasMethod(INIT_METHOD, args_.size())) {
+			StackCells actual_args(args_.size());
+			for (size_t i = 0; i < args_.size(); ++i) {
+				actual_args.Get()[i] = args_[i]->Execute(closure, context);
+			}
+			class_instance_.Call(INIT_METHOD, actual_args.Get(), args_.size(), context);
+		}
 		return runtime::ObjectHolder::Share(class_instance_);
 	}
 
-	MethodBody::MethodBody(std::unique_ptr<Statement>&& body)
-		: body_(std::move(body)) {
-	}	
+	MethodBody::MethodBody(Statement* body)
+		: body_(body) {
+	}
 
 	ObjectHolder MethodBody::Execute(Closure& closure, Context& context) {
-		try	{
-			body_->Execute(closure, context);
-		}
-		catch (const ReturnException& exception_result) {
-			return exception_result.GetStatement();
+		if (slot_count_ != 0) {
+			// Ячейки уже назначены, и тело читает переменные из кадра, а не из closure
+			StackCells frame(slot_count_);
+			std::fill(frame.Get(), frame.Get() + slot_count_, UNASSIGNED);
+			for (size_t i = 0; i <= formal_params_.size(); ++i) {
+				const auto it = closure.find(i < formal_params_.size() ? formal_params_[i] : SELF);
+				if (it != closure.end()) {
+					frame.Get()[i] = it->second;
+				}
+			}
+			return Run(frame.Get(), context);
 		}
 
-		return None{}.Execute(closure, context);
+		return ExecuteBody(body_, closure, context);
+	}
+
+	ObjectHolder MethodBody::ExecuteMethod(const std::vector<runtime::Symbol>& formal_params,
+		const ObjectHolder& self, const ObjectHolder* actual_args, Context& context) {
+		ResolveSlots(formal_params);
+
+		const size_t argument_count = formal_params.size();
+		StackCells frame(slot_count_);
+		std::copy(actual_args, actual_args + argument_count, frame.Get());
+		frame.Get()[argument_count] = self;
+		std::fill(frame.Get() + argument_count + 1, frame.Get() + slot_count_, UNASSIGNED);
+		return Run(frame.Get(), context);
+	}
+
+	std::uint32_t MethodBody::ResolveSlots(const std::vector<runtime::Symbol>& formal_params) {
+		if (slot_count_ == 0) {
+			formal_params_ = formal_params;
+			slot_count_ = ResolveLocals(body_, formal_params_);
+		}
+		return slot_count_;
+	}
+
+	ObjectHolder MethodBody::Run(ObjectHolder* frame, Context& context) {
+		FrameGuard guard(context, frame);
+		// Переменные метода лежат в кадре, и closure остаётся пустым
+		Closure closure;
+		return ExecuteBody(body_, closure, context);
+	}
+
+	LazyMethodBody::LazyMethodBody(std::function<Statement*()> parse)
+		: parse_(std::move(parse)) {
+	}
+
+	ObjectHolder LazyMethodBody::Execute(Closure& closure, Context& context) {
+		return Parse().Execute(closure, context);
+	}
+
+	ObjectHolder LazyMethodBody::ExecuteMethod(const std::vector<runtime::Symbol>& formal_params,
+		const ObjectHolder& self, const ObjectHolder* actual_args, Context& context) {
+		return Parse().ExecuteMethod(formal_params, self, actual_args, context);
+	}
+
+	MethodBody& LazyMethodBody::Parse() {
+		if (!parsed_) {
+			parsed_.emplace(parse_());
+			// Текст тела больше не нужен
+			parse_ = nullptr;
+		}
+		return *parsed_;
+	}
+
+	Program::Program(std::unique_ptr<Arena> arena, Statement* body)
+		: arena_(std::move(arena)), body_(body) {
+	}
+
+	ObjectHolder Program::Execute(Closure& closure, Context& context) {
+		ObjectHolder result = body_->Execute(closure, context);
+		if (context.IsReturning()) {
+			// return вне метода завершает программу исключением
+			context.SetReturning(false);
+			throw ReturnException(std::move(result));
+		}
+		return result;
 	}
 
 }  // namespace ast
\ No newline at end of file
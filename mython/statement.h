@@ -1,14 +1,28 @@
 #pragma once
 
+#include "arena.h"
 #include "runtime.h"
 
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <memory_resource>
+#include <optional>
+#include <type_traits>
 
 namespace ast {	
 
+	// Узлы дерева программы создаются в арене (ast::Arena) и ссылаются на дочерние узлы
+	// указателями, не владея ими. Массивы дочерних узлов лежат в той же арене.
+	// Дочерние узлы доступны по ссылке, чтобы проходы оптимизации могли заменять их
 	using Statement = runtime::Executable;
+	using StatementList = std::pmr::vector<Statement*>;
 
-	// Исключение для Return
+	// Номер ячейки переменной в кадре метода (см. ResolveLocals). Переменные с номером NO_SLOT
+	// хранятся в Closure по именам
+	inline constexpr std::uint32_t NO_SLOT = std::numeric_limits<std::uint32_t>::max();
+
+	// Исключение, которым инструкция return вне метода завершает программу
 	class ReturnException : public std::runtime_error {
 	public:		
 
@@ -37,14 +51,34 @@ namespace ast {
 			return runtime::ObjectHolder::Share(value_);
 		}
 
+		[[nodiscard]] const T& GetValue() const {
+			return value_;
+		}
+
 	private:
 		T value_;
 	};
 
 	using NumericConst = ValueStatement<runtime::Number>;
-	using StringConst = ValueStatement<runtime::String>;
 	using BoolConst = ValueStatement<runtime::Bool>;
 
+	// Строковая константа. Объект строки может разделяться несколькими константами с одинаковым
+	// текстом, поэтому константа хранит его через ObjectHolder
+	class StringConst : public Statement {
+	public:
+		explicit StringConst(runtime::String value);
+		// value должен содержать объект runtime::String
+		explicit StringConst(runtime::ObjectHolder value);
+
+		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const runtime::ObjectHolder& GetValue() const {
+			return value_;
+		}
+	private:
+		runtime::ObjectHolder value_;
+	};
+
 	/*
 	Вычисляет значение переменной либо цепочки вызовов полей объектов id1.id2.id3.
 	Например, выражение circle.center.x - цепочка вызовов полей объектов в инструкции:
@@ -52,35 +86,81 @@ namespace ast {
 	*/
 	class VariableValue : public Statement {
 	public:
-		explicit VariableValue(const std::string& var_name);
-		explicit VariableValue(std::vector<std::string> dotted_ids);
+		explicit VariableValue(runtime::Symbol var_name);
+		explicit VariableValue(std::pmr::vector<runtime::Symbol> dotted_ids);
+		explicit VariableValue(const std::vector<std::string>& dotted_ids);
 
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		// Имя переменной и следующие за ним имена полей
+		std::pmr::vector<runtime::Symbol>& Ids() {
+			return ids_;
+		}
+
+		// Ячейка переменной ids_[0]
+		[[nodiscard]] std::uint32_t GetSlot() const {
+			return slot_;
+		}
+
+		void SetSlot(std::uint32_t slot) {
+			slot_ = slot;
+		}
 	private:		
-		std::vector<std::string> ids_;
+		std::pmr::vector<runtime::Symbol> ids_;
+		std::uint32_t slot_ = NO_SLOT;
 	};
 
 	// Присваивает переменной, имя которой задано в параметре var, значение выражения rv
 	class Assignment : public Statement {
 	public:
-		Assignment(std::string var, std::unique_ptr<Statement> rv);
+		Assignment(runtime::Symbol var, Statement* rv);
 
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] runtime::Symbol GetName() const {
+			return var_;
+		}
+
+		Statement*& Value() {
+			return rv_;
+		}
+
+		// Ячейка переменной var
+		[[nodiscard]] std::uint32_t GetSlot() const {
+			return slot_;
+		}
+
+		void SetSlot(std::uint32_t slot) {
+			slot_ = slot;
+		}
 	private:
-		std::string var_;
-		std::unique_ptr<Statement> rv_;
+		runtime::Symbol var_;
+		Statement* rv_;
+		std::uint32_t slot_ = NO_SLOT;
 	};
 
 	// Присваивает полю object.field_name значение выражения rv
 	class FieldAssignment : public Statement {
 	public:
-		FieldAssignment(VariableValue object, std::string field_name, std::unique_ptr<Statement> rv);
+		FieldAssignment(VariableValue object, runtime::Symbol field_name, Statement* rv);
 
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		VariableValue& Object() {
+			return object_;
+		}
+
+		[[nodiscard]] runtime::Symbol GetFieldName() const {
+			return field_name_;
+		}
+
+		Statement*& Value() {
+			return rv_;
+		}
 	private:
 		VariableValue object_;
-		std::string field_name_;
-		std::unique_ptr<Statement> rv_;
+		runtime::Symbol field_name_;
+		Statement* rv_;
 	};
 
 	// Значение None
@@ -96,31 +176,46 @@ namespace ast {
 	class Print : public Statement {
 	public:
 		// Инициализирует команду print для вывода значения выражения argument
-		explicit Print(std::unique_ptr<Statement> argument);
+		explicit Print(Statement* argument);
 		// Инициализирует команду print для вывода списка значений args
-		explicit Print(std::vector<std::unique_ptr<Statement>> args);
+		explicit Print(StatementList args);
 
-		// Инициализирует команду print для вывода значения переменной name
-		static std::unique_ptr<Print> Variable(const std::string& name);
+		// Создаёт в arena команду print для вывода значения переменной name
+		static Print* Variable(runtime::Symbol name, Arena& arena);
 
 		// Во время выполнения команды print вывод должен осуществляться в поток, возвращаемый из
 		// context.GetOutputStream()
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		StatementList& Args() {
+			return args_;
+		}
 	private:
-		std::vector<std::unique_ptr<Statement>> args_;		
+		StatementList args_;
 	};
 
 	// Вызывает метод object.method со списком параметров args
 	class MethodCall : public Statement {
 	public:
-		MethodCall(std::unique_ptr<Statement> object, std::string method,
-			std::vector<std::unique_ptr<Statement>> args);
+		MethodCall(Statement* object, runtime::Symbol method, StatementList args);
 
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		Statement*& Object() {
+			return object_;
+		}
+
+		[[nodiscard]] runtime::Symbol GetMethod() const {
+			return method_;
+		}
+
+		StatementList& Args() {
+			return args_;
+		}
 	private:
-		std::unique_ptr<Statement> object_;
-		std::string method_;
-		std::vector<std::unique_ptr<Statement>> args_;
+		Statement* object_;
+		runtime::Symbol method_;
+		StatementList args_;
 	};
 
 	/*
@@ -139,23 +234,40 @@ namespace ast {
 	class NewInstance : public Statement {
 	public:
 		explicit NewInstance(const runtime::Class& class_);
-		NewInstance(const runtime::Class& class_, std::vector<std::unique_ptr<Statement>> args);
+		NewInstance(const runtime::Class& class_, StatementList args);
 		// Возвращает объект, содержащий значение типа ClassInstance
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const runtime::Class& GetClass() const {
+			return class_instance_.GetClass();
+		}
+
+		StatementList& Args() {
+			return args_;
+		}
+
+		// Объект, который возвращает каждое выполнение этой инструкции
+		runtime::ClassInstance& Instance() {
+			return class_instance_;
+		}
 	private:
 		runtime::ClassInstance class_instance_;
-		std::vector<std::unique_ptr<Statement>> args_;
+		StatementList args_;
 	};
 
 	// Базовый класс для унарных операций
 	class UnaryOperation : public Statement {
 	public:
-		explicit UnaryOperation(std::unique_ptr<Statement> argument)
-			: argument_(std::move(argument)) {
+		explicit UnaryOperation(Statement* argument)
+			: argument_(argument) {
+		}
+
+		Statement*& Argument() {
+			return argument_;
 		}
 
 	protected:
-		std::unique_ptr<Statement> argument_;
+		Statement* argument_;
 	};
 
 	// Операция str, возвращающая строковое значение своего аргумента
@@ -168,12 +280,21 @@ namespace ast {
 	// Родительский класс Бинарная операция с аргументами lhs и rhs
 	class BinaryOperation : public Statement {
 	public:
-		BinaryOperation(std::unique_ptr<Statement> lhs, std::unique_ptr<Statement> rhs)
-			: lhs_(std::move(lhs)), rhs_(std::move(rhs)) {
+		BinaryOperation(Statement* lhs, Statement* rhs)
+			: lhs_(lhs), rhs_(rhs) {
+		}
+
+		Statement*& Lhs() {
+			return lhs_;
 		}
-		
+
+		Statement*& Rhs() {
+			return rhs_;
+		}
+
 	protected:
-		std::unique_ptr<Statement> lhs_, rhs_;
+		Statement* lhs_;
+		Statement* rhs_;
 
 	};
 
@@ -224,6 +345,15 @@ namespace ast {
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
 	};
 
+	// Возвращает число, противоположное значению аргумента
+	class Negate : public UnaryOperation {
+	public:
+		using UnaryOperation::UnaryOperation;
+
+		// Если аргумент - не число, выбрасывается исключение runtime_error
+		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+	};
+
 	// Возвращает результат вычисления логической операции or над lhs и rhs
 	class Or : public BinaryOperation {
 	public:
@@ -252,48 +382,121 @@ namespace ast {
 	// Составная инструкция (например: тело метода, содержимое ветки if, либо else)
 	class Compound : public Statement {
 	public:
-		// Конструирует Compound из нескольких инструкций типа unique_ptr<Statement>
-		template <typename... Args>
-		explicit Compound(Args&&... args) {	
-			(stmts_.push_back(std::move(args)), ...);
+		// Конструирует Compound из нескольких инструкций типа Statement*
+		template <typename... Args,
+			typename = std::enable_if_t<(std::is_convertible_v<Args, Statement*> && ...)>>
+		explicit Compound(Args... args) {
+			(stmts_.push_back(args), ...);
+		}
+
+		explicit Compound(StatementList stmts)
+			: stmts_(std::move(stmts)) {
 		}
 
 		// Добавляет очередную инструкцию в конец составной инструкции
-		void AddStatement(std::unique_ptr<Statement> stmt) {
-			stmts_.push_back(std::move(stmt));
+		void AddStatement(Statement* stmt) {
+			stmts_.push_back(stmt);
+		}
+
+		// Заменяет count инструкций, начиная с позиции pos, инструкциями stmts
+		void ReplaceStatements(size_t pos, size_t count, const std::vector<Statement*>& stmts);
+
+		[[nodiscard]] size_t GetStatementCount() const {
+			return stmts_.size();
+		}
+
+		StatementList& Statements() {
+			return stmts_;
 		}
 
-		// Последовательно выполняет добавленные инструкции. Возвращает None
+		// Последовательно выполняет добавленные инструкции. Возвращает None, а если выполнилась
+		// инструкция return - её значение, не выполняя оставшиеся инструкции
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
 	private:
-		std::vector<std::unique_ptr<Statement>> stmts_;
+		StatementList stmts_;
 	};
 
 	// Тело метода. Как правило, содержит составную инструкцию
 	class MethodBody : public Statement {
 	public:
-		explicit MethodBody(std::unique_ptr<Statement>&& body);
+		explicit MethodBody(Statement* body);
 
 		// Вычисляет инструкцию, переданную в качестве body.
 		// Если внутри body была выполнена инструкция return, возвращает результат return
 		// В противном случае возвращает None
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		// Выполняет тело в кадре: параметры, self и локальные переменные лежат в массиве ячеек,
+		// а не в Closure. Ячейки назначаются при первом вызове, поэтому после него тело не следует
+		// изменять (например, оптимизировать)
+		runtime::ObjectHolder ExecuteMethod(const std::vector<runtime::Symbol>& formal_params,
+			const runtime::ObjectHolder& self, const runtime::ObjectHolder* actual_args,
+			runtime::Context& context) override;
+
+		// Назначает ячейки кадра переменным тела с параметрами formal_params (см. ResolveLocals),
+		// если они ещё не назначены, и возвращает число ячеек. Исполнители, компилирующие тело,
+		// берут номера ячеек из его узлов, поэтому раскладка кадра у всех исполнителей одна
+		std::uint32_t ResolveSlots(const std::vector<runtime::Symbol>& formal_params);
+
+		Statement*& Body() {
+			return body_;
+		}
+
+		// Число ячеек кадра или 0, если ячейки ещё не назначены
+		[[nodiscard]] std::uint32_t GetSlotCount() const {
+			return slot_count_;
+		}
 	private:
-		std::unique_ptr<Statement> body_;
+		// Выполняет тело в кадре frame
+		runtime::ObjectHolder Run(runtime::ObjectHolder* frame, runtime::Context& context);
+
+		Statement* body_;
+		std::vector<runtime::Symbol> formal_params_;
+		std::uint32_t slot_count_ = 0;
+	};
+
+	// Тело метода, разбор которого отложен до первого вызова. parse разбирает текст тела и
+	// возвращает его инструкции, разобранное тело сохраняется и выполняется при следующих вызовах.
+	// Если разбор завершился ошибкой, она выбрасывается при каждом вызове метода
+	class LazyMethodBody : public Statement {
+	public:
+		explicit LazyMethodBody(std::function<Statement*()> parse);
+
+		// Разбирает тело, если оно ещё не разобрано, и выполняет его
+		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+		runtime::ObjectHolder ExecuteMethod(const std::vector<runtime::Symbol>& formal_params,
+			const runtime::ObjectHolder& self, const runtime::ObjectHolder* actual_args,
+			runtime::Context& context) override;
+
+		// Разбирает тело, если оно ещё не разобрано, и возвращает его
+		MethodBody& Parse();
+
+		// Возвращает разобранное тело или nullptr, если тело ещё не разбиралось
+		MethodBody* Parsed() {
+			return parsed_ ? &*parsed_ : nullptr;
+		}
+	private:
+		std::function<Statement*()> parse_;
+		std::optional<MethodBody> parsed_;
 	};
 
 	// Выполняет инструкцию return с выражением statement
 	class Return : public Statement {
 	public:
-		explicit Return(std::unique_ptr<Statement> statement)
-			: statement_(std::move(statement)) {
+		explicit Return(Statement* statement)
+			: statement_(statement) {
 		}
 
 		// Останавливает выполнение текущего метода. После выполнения инструкции return метод,
 		// внутри которого она была исполнена, должен вернуть результат вычисления выражения statement.
+		// Возвращает этот результат и отмечает в context, что метод завершается (Context::IsReturning)
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		Statement*& Value() {
+			return statement_;
+		}
 	private:
-		std::unique_ptr<Statement> statement_;
+		Statement* statement_;
 	};
 
 	// Объявляет класс
@@ -305,32 +508,63 @@ namespace ast {
 		// Создаёт внутри closure новый объект, совпадающий с именем класса и значением, переданным в
 		// конструктор
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const runtime::Class& GetClass() const;
+		runtime::Class& GetClass();
+
+		// Ячейка переменной с именем класса
+		[[nodiscard]] std::uint32_t GetSlot() const {
+			return slot_;
+		}
+
+		void SetSlot(std::uint32_t slot) {
+			slot_ = slot;
+		}
 	private:
 		runtime::ObjectHolder cls_;
+		std::uint32_t slot_ = NO_SLOT;
 	};
 
 	// Инструкция if <condition> <if_body> else <else_body>
 	class IfElse : public Statement {
 	public:
 		// Параметр else_body может быть равен nullptr
-		IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> if_body,
-			std::unique_ptr<Statement> else_body);
+		IfElse(Statement* condition, Statement* if_body, Statement* else_body);
 
+		// Выполняет одну из веток и возвращает её значение, чтобы значение выполненной в ветке
+		// инструкции return дошло до составной инструкции, в которую входит if
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		Statement*& Condition() {
+			return condition_;
+		}
+
+		Statement*& IfBody() {
+			return if_body_;
+		}
+
+		// Равен nullptr, если ветки else нет
+		Statement*& ElseBody() {
+			return else_body_;
+		}
 	private:
-		std::unique_ptr<Statement> condition_;
-		std::unique_ptr<Statement> if_body_;
-		std::unique_ptr<Statement> else_body_;
+		Statement* condition_;
+		Statement* if_body_;
+		Statement* else_body_;
 	};
 
 	// Операция сравнения
 	class Comparison : public BinaryOperation {
 	public:
 		// Comparator задаёт функцию, выполняющую сравнение значений аргументов
-		using Comparator = std::function<bool(const runtime::ObjectHolder&,
-			const runtime::ObjectHolder&, runtime::Context&)>;
+		using Comparator = bool (*)(const runtime::ObjectHolder&, const runtime::ObjectHolder&,
+			runtime::Context&);
 
-		Comparison(Comparator cmp, std::unique_ptr<Statement> lhs, std::unique_ptr<Statement> rhs);
+		Comparison(Comparator cmp, Statement* lhs, Statement* rhs);
+
+		[[nodiscard]] Comparator GetComparator() const {
+			return cmp_;
+		}
 
 		// Вычисляет значение выражений lhs и rhs и возвращает результат работы comparator,
 		// приведённый к типу runtime::Bool
@@ -339,4 +573,94 @@ namespace ast {
 		Comparator cmp_;
 	};
 
+	// Программа: корневая инструкция и арена, в которой лежат узлы дерева. Узлы освобождаются
+	// вместе с ареной
+	class Program : public Statement {
+	public:
+		Program(std::unique_ptr<Arena> arena, Statement* body);
+
+		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		// Арена программы. Узлы, созданные в ней, живут столько же, сколько программа
+		Arena& GetArena() {
+			return *arena_;
+		}
+
+		Statement*& Body() {
+			return body_;
+		}
+	private:
+		std::unique_ptr<Arena> arena_;
+		Statement* body_;
+	};
+
+	// Узлы, которые не владеют ничем, кроме памяти арены, арена освобождает без вызова деструкторов
+	template <> struct ArenaNeedsDestructor<NumericConst> : std::false_type {};
+	template <> struct ArenaNeedsDestructor<BoolConst> : std::false_type {};
+	template <> struct ArenaNeedsDestructor<Assignment> : std::false_type {};
+	template <> struct ArenaNeedsDestructor<None> : std::false_type {};
+	template <> struct ArenaNeedsDestructor<Stringify> : std::false_type {};
+	template <> struct ArenaNeedsDestructor<Add> : std::false_type {};
+	template <> struct ArenaNeedsDestructor<Sub> : std::false_type {};
+	template <> struct ArenaNeedsDestructor<Mult> : std::false_type {};
+	template <> struct ArenaNeedsDestructor<Div> : std::false_type {};
+	template <> struct ArenaNeedsDestructor<Negate> : std::false_type {};
+	template <> struct ArenaNeedsDestructor<Or> : std::false_type {};
+	template <> struct ArenaNeedsDestructor<And> : std::false_type {};
+	template <> struct ArenaNeedsDestructor<Not> : std::false_type {};
+	template <> struct ArenaNeedsDestructor<Return> : std::false_type {};
+	template <> struct ArenaNeedsDestructor<IfElse> : std::false_type {};
+	template <> struct ArenaNeedsDestructor<Comparison> : std::false_type {};
+
+	// Вызывает visit для каждого дочернего узла node в том порядке, в котором они вычисляются.
+	// Тела методов класса не входят в ClassDefinition как дочерние узлы и не обходятся
+	template <typename Visitor>
+	void ForEachChild(Statement* node, Visitor&& visit) {
+		if (auto* binary = dynamic_cast<BinaryOperation*>(node)) {
+			visit(binary->Lhs());
+			visit(binary->Rhs());
+		} else if (auto* unary = dynamic_cast<UnaryOperation*>(node)) {
+			visit(unary->Argument());
+		} else if (auto* compound = dynamic_cast<Compound*>(node)) {
+			for (Statement*& statement : compound->Statements()) {
+				visit(statement);
+			}
+		} else if (auto* assignment = dynamic_cast<Assignment*>(node)) {
+			visit(assignment->Value());
+		} else if (auto* field_assignment = dynamic_cast<FieldAssignment*>(node)) {
+			visit(field_assignment->Value());
+		} else if (auto* print = dynamic_cast<Print*>(node)) {
+			for (Statement*& arg : print->Args()) {
+				visit(arg);
+			}
+		} else if (auto* call = dynamic_cast<MethodCall*>(node)) {
+			// Аргументы вычисляются раньше объекта
+			for (Statement*& arg : call->Args()) {
+				visit(arg);
+			}
+			visit(call->Object());
+		} else if (auto* new_instance = dynamic_cast<NewInstance*>(node)) {
+			for (Statement*& arg : new_instance->Args()) {
+				visit(arg);
+			}
+		} else if (auto* ret = dynamic_cast<Return*>(node)) {
+			visit(ret->Value());
+		} else if (auto* if_else = dynamic_cast<IfElse*>(node)) {
+			visit(if_else->Condition());
+			visit(if_else->IfBody());
+			if (if_else->ElseBody() != nullptr) {
+				visit(if_else->ElseBody());
+			}
+		} else if (auto* method_body = dynamic_cast<MethodBody*>(node)) {
+			visit(method_body->Body());
+		} else if (auto* lazy_body = dynamic_cast<LazyMethodBody*>(node)) {
+			// У тела, которое ещё не разобрано, дочерних узлов нет
+			if (MethodBody* parsed = lazy_body->Parsed()) {
+				visit(parsed->Body());
+			}
+		} else if (auto* program = dynamic_cast<Program*>(node)) {
+			visit(program->Body());
+		}
+	}
+
 }  // namespace ast
\ No newline at end of file
@@ -80,10 +80,11 @@ void TestVariable() {
 }
 
 void TestAssignment() {
+    Arena arena;
     runtime::DummyContext context;
 
-    Assignment assign_x("x"s, make_unique<NumericConst>(runtime::Number(57)));
-    Assignment assign_y("y"s, make_unique<StringConst>(runtime::String("Hello"s)));
+    Assignment assign_x("x"s, arena.Make<NumericConst>(runtime::Number(57)));
+    Assignment assign_y("y"s, arena.Make<StringConst>(runtime::String("Hello"s)));
 
     Closure closure = {{"y"s, ObjectHolder::Own(runtime::Number(42))}};
 
@@ -107,14 +108,15 @@ void TestAssignment() {
 }
 
 void TestFieldAssignment() {
+    Arena arena;
     runtime::DummyContext context;
 
     runtime::Class empty("Empty"s, {}, nullptr);
     runtime::ClassInstance object{empty};
 
     FieldAssignment assign_x(VariableValue{"self"s}, "x"s,
-                             make_unique<NumericConst>(runtime::Number(57)));
-    FieldAssignment assign_y(VariableValue{"self"s}, "y"s, make_unique<NewInstance>(empty));
+                             arena.Make<NumericConst>(runtime::Number(57)));
+    FieldAssignment assign_y(VariableValue{"self"s}, "y"s, arena.Make<NewInstance>(empty));
 
     Closure closure = {{"self"s, ObjectHolder::Share(object)}};
 
@@ -129,7 +131,7 @@ void TestFieldAssignment() {
     assign_y.Execute(closure, context);
     FieldAssignment assign_yz(
         VariableValue{vector<string>{"self"s, "y"s}}, "z"s,
-        make_unique<StringConst>(runtime::String("Hello, world! Hooray! Yes-yes!!!"s)));
+        arena.Make<StringConst>(runtime::String("Hello, world! Hooray! Yes-yes!!!"s)));
     {
         ObjectHolder o = assign_yz.Execute(closure, context);
         ASSERT(o);
@@ -145,27 +147,29 @@ void TestFieldAssignment() {
 }
 
 void TestPrintVariable() {
+    Arena arena;
     runtime::DummyContext context;
 
     Closure closure = {{"y"s, ObjectHolder::Own(runtime::Number(42))}};
 
-    auto print_statement = Print::Variable("y"s);
+    auto print_statement = Print::Variable("y"s, arena);
     print_statement->Execute(closure, context);
 
     ASSERT_EQUAL(context.output.str(), "42\n"s);
 }
 
 void TestPrintMultipleStatements() {
+    Arena arena;
     runtime::DummyContext context;
 
     runtime::String hello("hello"s);
     Closure closure = {{"word"s, ObjectHolder::Share(hello)}, {"empty"s, ObjectHolder::None()}};
 
-    vector<unique_ptr<Statement>> args;
-    args.push_back(make_unique<VariableValue>("word"s));
-    args.push_back(make_unique<NumericConst>(57));
-    args.push_back(make_unique<StringConst>("Python"s));
-    args.push_back(make_unique<VariableValue>("empty"s));
+    StatementList args;
+    args.push_back(arena.Make<VariableValue>("word"s));
+    args.push_back(arena.Make<NumericConst>(57));
+    args.push_back(arena.Make<StringConst>("Python"s));
+    args.push_back(arena.Make<VariableValue>("empty"s));
 
     Print(std::move(args)).Execute(closure, context);
 
@@ -173,17 +177,18 @@ void TestPrintMultipleStatements() {
 }
 
 void TestStringify() {
+    Arena arena;
     runtime::DummyContext context;
 
     Closure empty;
 
     {
-        auto result = Stringify(make_unique<NumericConst>(57)).Execute(empty, context);
+        auto result = Stringify(arena.Make<NumericConst>(57)).Execute(empty, context);
         ASSERT_OBJECT_VALUE_EQUAL(result, "57"s);
         ASSERT(result.TryAs<runtime::String>());
     }
     {
-        auto result = Stringify(make_unique<StringConst>("Wazzup!"s)).Execute(empty, context);
+        auto result = Stringify(arena.Make<StringConst>("Wazzup!"s)).Execute(empty, context);
         ASSERT_OBJECT_VALUE_EQUAL(result, "Wazzup!"s);
         ASSERT(result.TryAs<runtime::String>());
     }
@@ -193,7 +198,7 @@ void TestStringify() {
 
         runtime::Class cls("BoxedValue"s, std::move(methods), nullptr);
 
-        auto result = Stringify(make_unique<NewInstance>(cls)).Execute(empty, context);
+        auto result = Stringify(arena.Make<NewInstance>(cls)).Execute(empty, context);
         ASSERT_OBJECT_VALUE_EQUAL(result, "842"s);
         ASSERT(result.TryAs<runtime::String>());
     }
@@ -204,11 +209,11 @@ void TestStringify() {
         std::ostringstream expected_output;
         expected_output << closure.at("x"s).Get();
 
-        Stringify str(make_unique<VariableValue>("x"s));
+        Stringify str(arena.Make<VariableValue>("x"s));
         ASSERT_OBJECT_VALUE_EQUAL(str.Execute(closure, context), expected_output.str());
     }
     {
-        Stringify str(make_unique<None>());
+        Stringify str(arena.Make<None>());
         ASSERT_OBJECT_VALUE_EQUAL(str.Execute(empty, context), "None"s);
     }
 
@@ -216,9 +221,10 @@ void TestStringify() {
 }
 
 void TestNumbersAddition() {
+    Arena arena;
     runtime::DummyContext context;
 
-    Add sum(make_unique<NumericConst>(23), make_unique<NumericConst>(34));
+    Add sum(arena.Make<NumericConst>(23), arena.Make<NumericConst>(34));
 
     Closure empty;
     ASSERT_OBJECT_VALUE_EQUAL(sum.Execute(empty, context), 57);
@@ -227,9 +233,10 @@ void TestNumbersAddition() {
 }
 
 void TestStringsAddition() {
+    Arena arena;
     runtime::DummyContext context;
 
-    Add sum(make_unique<StringConst>("23"s), make_unique<StringConst>("34"s));
+    Add sum(arena.Make<StringConst>("23"s), arena.Make<StringConst>("34"s));
 
     Closure empty;
     ASSERT_OBJECT_VALUE_EQUAL(sum.Execute(empty, context), "2334"s);
@@ -238,37 +245,39 @@ void TestStringsAddition() {
 }
 
 void TestBadAddition() {
+    Arena arena;
     runtime::DummyContext context;
 
     Closure empty;
 
     ASSERT_THROWS(
-        Add(make_unique<NumericConst>(42), make_unique<StringConst>("4"s)).Execute(empty, context),
+        Add(arena.Make<NumericConst>(42), arena.Make<StringConst>("4"s)).Execute(empty, context),
         std::runtime_error);
     ASSERT_THROWS(
-        Add(make_unique<StringConst>("4"s), make_unique<NumericConst>(42)).Execute(empty, context),
+        Add(arena.Make<StringConst>("4"s), arena.Make<NumericConst>(42)).Execute(empty, context),
         std::runtime_error);
-    ASSERT_THROWS(Add(make_unique<None>(), make_unique<StringConst>("4"s)).Execute(empty, context),
+    ASSERT_THROWS(Add(arena.Make<None>(), arena.Make<StringConst>("4"s)).Execute(empty, context),
                   std::runtime_error);
-    ASSERT_THROWS(Add(make_unique<None>(), make_unique<None>()).Execute(empty, context),
+    ASSERT_THROWS(Add(arena.Make<None>(), arena.Make<None>()).Execute(empty, context),
                   std::runtime_error);
 
     ASSERT(context.output.str().empty());
 }
 
 void TestSuccessfulClassInstanceAdd() {
+    Arena arena;
     runtime::DummyContext context;
 
     vector<runtime::Method> methods;
     methods.push_back({"__add__"s,
                        {"value_"s},
-                       make_unique<Add>(make_unique<StringConst>("hello, "s),
-                                        make_unique<VariableValue>("value_"s))});
+                       make_unique<Add>(arena.Make<StringConst>("hello, "s),
+                                        arena.Make<VariableValue>("value_"s))});
 
     runtime::Class cls("BoxedValue"s, std::move(methods), nullptr);
 
     Closure empty;
-    auto result = Add(make_unique<NewInstance>(cls), make_unique<StringConst>("world"s))
+    auto result = Add(arena.Make<NewInstance>(cls), arena.Make<StringConst>("world"s))
                       .Execute(empty, context);
     ASSERT_OBJECT_VALUE_EQUAL(result, "hello, world"s);
 
@@ -276,24 +285,26 @@ void TestSuccessfulClassInstanceAdd() {
 }
 
 void TestClassInstanceAddWithoutMethod() {
+    Arena arena;
     runtime::DummyContext context;
 
     runtime::Class cls("BoxedValue"s, {}, nullptr);
 
     Closure empty;
-    Add addition(make_unique<NewInstance>(cls), make_unique<StringConst>("world"s));
+    Add addition(arena.Make<NewInstance>(cls), arena.Make<StringConst>("world"s));
     ASSERT_THROWS(addition.Execute(empty, context), std::runtime_error);
 
     ASSERT(context.output.str().empty());
 }
 
 void TestCompound() {
+    Arena arena;
     runtime::DummyContext context;
 
     Compound cpd{
-        make_unique<Assignment>("x"s, make_unique<StringConst>("one"s)),
-        make_unique<Assignment>("y"s, make_unique<NumericConst>(2)),
-        make_unique<Assignment>("z"s, make_unique<VariableValue>("x"s)),
+        arena.Make<Assignment>("x"s, arena.Make<StringConst>("one"s)),
+        arena.Make<Assignment>("y"s, arena.Make<NumericConst>(2)),
+        arena.Make<Assignment>("z"s, arena.Make<VariableValue>("x"s)),
     };
 
     Closure closure;
@@ -308,7 +319,39 @@ void TestCompound() {
     ASSERT(context.output.str().empty());
 }
 
+void TestCompoundStopsOnReturn() {
+    Arena arena;
+    runtime::DummyContext context;
+
+    Compound cpd{
+        arena.Make<Assignment>("x"s, arena.Make<NumericConst>(1)),
+        arena.Make<IfElse>(arena.Make<VariableValue>("x"s),
+                           arena.Make<Compound>(arena.Make<Return>(arena.Make<StringConst>("early"s))), nullptr),
+        arena.Make<Assignment>("y"s, arena.Make<NumericConst>(2)),
+    };
+
+    Closure closure;
+    auto result = cpd.Execute(closure, context);
+
+    // Инструкции после return не выполняются, а составная инструкция возвращает значение return
+    ASSERT_OBJECT_VALUE_EQUAL(result, "early"s);
+    ASSERT(context.IsReturning());
+    ASSERT(closure.count("y"s) == 0);
+
+    // return вне метода завершает программу исключением
+    context.SetReturning(false);
+    Program program(std::make_unique<Arena>(), &cpd);
+    try {
+        program.Execute(closure, context);
+        ASSERT(false);
+    } catch (const ReturnException& e) {
+        ASSERT_OBJECT_VALUE_EQUAL(e.GetStatement(), "early"s);
+    }
+    ASSERT(!context.IsReturning());
+}
+
 void TestFields() {
+    Arena arena;
     runtime::DummyContext context;
 
     vector<runtime::Method> methods;
@@ -316,7 +359,7 @@ void TestFields() {
     methods.push_back({"__init__"s,
                        {},
                        {make_unique<FieldAssignment>(VariableValue{"self"s}, "value"s,
-                                                     make_unique<NumericConst>(0))}});
+                                                     arena.Make<NumericConst>(0))}});
     methods.push_back(
         {"value"s, {}, {make_unique<VariableValue>(vector<string>{"self"s, "value"s})}});
     methods.push_back(
@@ -324,8 +367,8 @@ void TestFields() {
          {"x"s},
          {make_unique<FieldAssignment>(
              VariableValue{"self"s}, "value"s,
-             make_unique<Add>(make_unique<VariableValue>(vector<string>{"self"s, "value"s}),
-                              make_unique<VariableValue>("x"s)))}});
+             arena.Make<Add>(arena.Make<VariableValue>(vector<string>{"self"s, "value"s}),
+                              arena.Make<VariableValue>("x"s)))}});
 
     runtime::Class cls("BoxedValue"s, std::move(methods), nullptr);
     runtime::ClassInstance inst(cls);
@@ -345,12 +388,13 @@ void TestFields() {
 }
 
 void TestBaseClass() {
+    Arena arena;
     vector<runtime::Method> methods;
     methods.push_back({"GetValue"s, {}, make_unique<VariableValue>(vector{"self"s, "value"s})});
     methods.push_back({"SetValue"s,
                        {"x"s},
                        make_unique<FieldAssignment>(VariableValue{"self"s}, "value"s,
-                                                    make_unique<ast::VariableValue>("x"s))});
+                                                    arena.Make<ast::VariableValue>("x"s))});
 
     runtime::Class cls("BoxedValue"s, move(methods), nullptr);
 
@@ -371,12 +415,13 @@ void TestBaseClass() {
 }
 
 void TestInheritance() {
+    Arena arena;
     vector<runtime::Method> methods;
     methods.push_back({"GetValue"s, {}, make_unique<VariableValue>(vector{"self"s, "value"s})});
     methods.push_back({"SetValue"s,
                        {"x"s},
                        make_unique<FieldAssignment>(VariableValue{"self"s}, "value"s,
-                                                    make_unique<VariableValue>("x"s))});
+                                                    arena.Make<VariableValue>("x"s))});
 
     runtime::Class base("BoxedValue"s, std::move(methods), nullptr);
 
@@ -409,7 +454,8 @@ void TestInheritance() {
 
 void TestOr() {
     auto test_or = [](bool lhs, bool rhs) {
-        Or or_statement{make_unique<BoolConst>(lhs), make_unique<BoolConst>(rhs)};
+        Arena arena;
+        Or or_statement{arena.Make<BoolConst>(lhs), arena.Make<BoolConst>(rhs)};
         Closure closure;
         runtime::DummyContext context;
         ASSERT_EQUAL(runtime::Equal(or_statement.Execute(closure, context),
@@ -425,7 +471,8 @@ void TestOr() {
 
 void TestAnd() {
     auto test_and = [](bool lhs, bool rhs) {
-        And and_statement{make_unique<BoolConst>(lhs), make_unique<BoolConst>(rhs)};
+        Arena arena;
+        And and_statement{arena.Make<BoolConst>(lhs), arena.Make<BoolConst>(rhs)};
         Closure closure;
         runtime::DummyContext context;
         ASSERT_EQUAL(runtime::Equal(and_statement.Execute(closure, context),
@@ -441,7 +488,8 @@ void TestAnd() {
 
 void TestNot() {
     auto test_not = [](bool arg) {
-        Not not_statement{make_unique<BoolConst>(arg)};
+        Arena arena;
+        Not not_statement{arena.Make<BoolConst>(arg)};
         Closure closure;
         runtime::DummyContext context;
         ASSERT_EQUAL(runtime::Equal(not_statement.Execute(closure, context),
@@ -470,6 +518,7 @@ void RunUnitTests(TestRunner& tr) {
     RUN_TEST(tr, ast::TestSuccessfulClassInstanceAdd);
     RUN_TEST(tr, ast::TestClassInstanceAddWithoutMethod);
     RUN_TEST(tr, ast::TestCompound);
+    RUN_TEST(tr, ast::TestCompoundStopsOnReturn);
     RUN_TEST(tr, ast::TestFields);
     RUN_TEST(tr, ast::TestBaseClass);
     RUN_TEST(tr, ast::TestInheritance);
@@ -0,0 +1,79 @@
+#include "symbol.h"
+
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+namespace runtime {
+
+	namespace {
+		class SymbolTable {
+		public:
+			SymbolTable() {
+				// Номер 0 зарезервирован за пустым именем, его возвращает Symbol()
+				names_.emplace_back();
+				ids_.emplace(names_.back(), 0);
+			}
+
+			uint32_t Intern(string_view name) {
+				{
+					shared_lock lock(mutex_);
+					if (const auto it = ids_.find(name); it != ids_.end()) {
+						return it->second;
+					}
+				}
+
+				unique_lock lock(mutex_);
+				// Пока блокировка не была захвачена, имя мог добавить другой поток
+				if (const auto it = ids_.find(name); it != ids_.end()) {
+					return it->second;
+				}
+				if (names_.size() > numeric_limits<uint32_t>::max()) {
+					throw length_error("Too many symbols"s);
+				}
+				const auto id = static_cast<uint32_t>(names_.size());
+				// deque не перемещает элементы при добавлении в конец, поэтому ключи-string_view
+				// остаются действительными
+				names_.emplace_back(name);
+				ids_.emplace(names_.back(), id);
+				return id;
+			}
+
+			const string& Name(uint32_t id) const {
+				shared_lock lock(mutex_);
+				return names_[id];
+			}
+
+		private:
+			mutable shared_mutex mutex_;
+			deque<string> names_;
+			unordered_map<string_view, uint32_t> ids_;
+		};
+
+		SymbolTable& GetSymbolTable() {
+			// Таблица создаётся при первом обращении, поэтому глобальные константы-символы
+			// из других единиц трансляции можно инициализировать в любом порядке
+			static SymbolTable table;
+			return table;
+		}
+	}  // namespace
+
+	Symbol::Symbol(string_view name)
+		: id_(GetSymbolTable().Intern(name)) {
+	}
+
+	const string& Symbol::Name() const {
+		return GetSymbolTable().Name(id_);
+	}
+
+	ostream& operator<<(ostream& os, Symbol symbol) {
+		return os << symbol.Name();
+	}
+
+}  // namespace runtime
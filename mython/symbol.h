@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace runtime {
+
+	// Интернированный идентификатор. Каждое имя хранится в глобальной таблице символов один раз,
+	// а Symbol содержит только его 32-битный номер. Поэтому символы сравниваются и хешируются
+	// как целые числа, без обращения к тексту имени.
+	// Таблица символов потокобезопасна, символы можно создавать из нескольких потоков
+	class Symbol {
+	public:
+		// Пустое имя
+		Symbol() = default;
+
+		// Интернирует name. Конструкторы неявные, чтобы символ можно было передать везде,
+		// где раньше передавалась строка
+		Symbol(std::string_view name);  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+		Symbol(const std::string& name)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+			: Symbol(std::string_view{ name }) {
+		}
+		Symbol(const char* name)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+			: Symbol(std::string_view{ name }) {
+		}
+
+		// Восстанавливает символ по номеру, ранее полученному из Id()
+		[[nodiscard]] static constexpr Symbol FromId(std::uint32_t id) {
+			Symbol result;
+			result.id_ = id;
+			return result;
+		}
+
+		// Возвращает номер символа в таблице символов
+		[[nodiscard]] constexpr std::uint32_t Id() const {
+			return id_;
+		}
+
+		// Возвращает текст имени. Ссылка действительна до конца работы программы
+		[[nodiscard]] const std::string& Name() const;
+
+		friend bool operator==(Symbol lhs, Symbol rhs) {
+			return lhs.id_ == rhs.id_;
+		}
+
+		friend bool operator!=(Symbol lhs, Symbol rhs) {
+			return lhs.id_ != rhs.id_;
+		}
+
+	private:
+		std::uint32_t id_ = 0;
+	};
+
+	std::ostream& operator<<(std::ostream& os, Symbol symbol);
+
+}  // namespace runtime
+
+namespace std {
+
+	template <>
+	struct hash<runtime::Symbol> {
+		size_t operator()(runtime::Symbol symbol) const noexcept {
+			return symbol.Id();
+		}
+	};
+
+}  // namespace std
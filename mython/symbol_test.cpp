@@ -0,0 +1,70 @@
+#include "symbol.h"
+#include "test_runner_p.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+void TestSameNameGivesSameSymbol() {
+    const Symbol a = "symbol_test_name"s;
+    const Symbol b = "symbol_test_name"sv;
+    const Symbol c = "symbol_test_other";
+
+    ASSERT(a == b);
+    ASSERT_EQUAL(a.Id(), b.Id());
+    ASSERT(a != c);
+    ASSERT_EQUAL(a.Name(), "symbol_test_name"s);
+    ASSERT_EQUAL(c.Name(), "symbol_test_other"s);
+}
+
+void TestEmptySymbol() {
+    ASSERT(Symbol() == Symbol(""s));
+    ASSERT_EQUAL(Symbol().Name(), ""s);
+}
+
+void TestPrint() {
+    ostringstream out;
+    out << Symbol("symbol_test_print"s);
+    ASSERT_EQUAL(out.str(), "symbol_test_print"s);
+}
+
+void TestConcurrentInterning() {
+    constexpr int thread_count = 4;
+    constexpr int name_count = 1000;
+
+    vector<vector<Symbol>> results(thread_count);
+    vector<thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&results, t] {
+            for (int i = 0; i < name_count; ++i) {
+                results[t].emplace_back("symbol_test_thread_"s + to_string(i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (int t = 1; t < thread_count; ++t) {
+        ASSERT(results[t] == results[0]);
+    }
+    for (int i = 0; i < name_count; ++i) {
+        ASSERT_EQUAL(results[0][i].Name(), "symbol_test_thread_"s + to_string(i));
+    }
+}
+}  // namespace
+
+void RunSymbolTests(TestRunner& tr) {
+    RUN_TEST(tr, runtime::TestSameNameGivesSameSymbol);
+    RUN_TEST(tr, runtime::TestEmptySymbol);
+    RUN_TEST(tr, runtime::TestPrint);
+    RUN_TEST(tr, runtime::TestConcurrentInterning);
+}
+
+}  // namespace runtime
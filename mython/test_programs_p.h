@@ -0,0 +1,54 @@
+#pragma once
+
+#include "lexer.h"
+#include "optimize.h"
+#include "parse.h"
+#include "runtime.h"
+#include "test_runner_p.h"
+
+#include <exception>
+#include <initializer_list>
+#include <memory>
+#include <sstream>
+#include <string>
+
+// Общие вспомогательные функции тестов, которые разбирают и выполняют программы на Mython
+namespace test_programs {
+
+// Разбирает текст программы
+inline std::unique_ptr<ast::Program> ParseText(const std::string& text, BodyParsing bodies = BodyParsing::EAGER) {
+    std::istringstream input(text);
+    parse::Lexer lexer(input);
+    return ParseProgram(lexer, bodies);
+}
+
+// Выполняет программу и возвращает её вывод. Ошибка выполнения дописывается в конец вывода
+inline std::string Run(runtime::Executable& program) {
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    try {
+        program.Execute(closure, context);
+    } catch (const std::exception& e) {
+        context.output << "<error: " << e.what() << '>';
+    }
+    return context.output.str();
+}
+
+// Выполняет программу обходом дерева и программой, которую строит из дерева compile (с отложенным
+// разбором тел и без него, с оптимизацией и без неё), проверяет, что вывод совпадает, и возвращает его
+template <typename CompileFunction>
+std::string RunBoth(const std::string& text, CompileFunction compile) {
+    const std::string expected = Run(*ParseText(text));
+    for (const BodyParsing bodies : {BodyParsing::EAGER, BodyParsing::LAZY}) {
+        for (const bool optimize : {false, true}) {
+            auto tree = ParseText(text, bodies);
+            if (optimize) {
+                ast::Optimize(*tree);
+            }
+            ASSERT_EQUAL(Run(*compile(*tree)), expected);
+        }
+    }
+    return expected;
+}
+
+}  // namespace test_programs
@@ -0,0 +1,183 @@
+#include "bytecode.h"
+#include "closure_compiler.h"
+#include "lexer.h"
+#include "parse.h"
+#include "runtime.h"
+#include "statement.h"
+#include "test_runner_p.h"
+
+#include <iostream>
+#include <iterator>
+
+using namespace std;
+
+namespace parse {
+void RunOpenLexerTests(TestRunner& tr);
+void RunSourceFileTests(TestRunner& tr);
+void RunScanTests(TestRunner& tr);
+void RunIncrementalTests(TestRunner& tr);
+void RunParallelParseTests(TestRunner& tr);
+}  // namespace parse
+
+namespace ast {
+void RunArenaTests(TestRunner& tr);
+void RunOptimizeTests(TestRunner& tr);
+void RunDataflowTests(TestRunner& tr);
+void RunReachabilityTests(TestRunner& tr);
+void RunResolveTests(TestRunner& tr);
+void RunUnitTests(TestRunner& tr);
+}  // namespace ast
+namespace runtime {
+void RunObjectHolderTests(TestRunner& tr);
+void RunObjectsTests(TestRunner& tr);
+void RunSymbolTests(TestRunner& tr);
+}  // namespace runtime
+namespace engine {
+void RunEngineTests(TestRunner& tr);
+}  // namespace engine
+namespace vm {
+void RunBytecodeTests(TestRunner& tr);
+}  // namespace vm
+namespace closure_compiler {
+void RunClosureCompilerTests(TestRunner& tr);
+}  // namespace closure_compiler
+
+void TestParseProgram(TestRunner& tr);
+
+namespace {
+
+// Разбирает text и выполняет программу, скомпилированную функцией compile
+template <typename Compile>
+string RunText(const string& text, Compile compile) {
+    istringstream source(text);
+    parse::Lexer lexer(source);
+    auto program = ParseProgram(lexer);
+    ostringstream output;
+    runtime::SimpleContext context{output};
+    runtime::Closure closure;
+    compile(*program)->Execute(closure, context);
+    return output.str();
+}
+
+// Выполняет программу обходом дерева и проверяет, что байт-код и замыкания выводят то же самое
+void RunMythonProgram(istream& input, ostream& output) {
+    const string text{istreambuf_iterator<char>(input), istreambuf_iterator<char>()};
+    const string tree_output = RunText(text, [](ast::Program& program) {
+        return &program;
+    });
+    ASSERT_EQUAL(RunText(text, vm::Compile), tree_output);
+    ASSERT_EQUAL(RunText(text, closure_compiler::Compile), tree_output);
+    output << tree_output;
+}
+
+void TestSimplePrints() {
+    istringstream input(R"(
+print 57
+print 10, 24, -8
+print 'hello'
+print "world"
+print True, False
+print
+print None
+)");
+
+    ostringstream output;
+    RunMythonProgram(input, output);
+
+    ASSERT_EQUAL(output.str(), "57\n10 24 -8\nhello\nworld\nTrue False\n\nNone\n");
+}
+
+void TestAssignments() {
+    istringstream input(R"(
+x = 57
+print x
+x = 'C++ black belt'
+print x
+y = False
+x = y
+print x
+x = None
+print x, y
+)");
+
+    ostringstream output;
+    RunMythonProgram(input, output);
+
+    ASSERT_EQUAL(output.str(), "57\nC++ black belt\nFalse\nNone False\n");
+}
+
+void TestArithmetics() {
+    istringstream input("print 1+2+3+4+5, 1*2*3*4*5, 1-2-3-4-5, 36/4/3, 2*5+10/2");
+
+    ostringstream output;
+    RunMythonProgram(input, output);
+
+    ASSERT_EQUAL(output.str(), "15 120 -13 3 15\n");
+}
+
+void TestVariablesArePointers() {
+    istringstream input(R"(
+class Counter:
+  def __init__():
+    self.value = 0
+
+  def add():
+    self.value = self.value + 1
+
+class Dummy:
+  def do_add(counter):
+    counter.add()
+
+x = Counter()
+y = x
+
+x.add()
+y.add()
+
+print x.value
+
+d = Dummy()
+d.do_add(x)
+
+print y.value
+)");
+
+    ostringstream output;
+    RunMythonProgram(input, output);
+
+    ASSERT_EQUAL(output.str(), "2\n3\n");
+}
+
+void TestAll() {
+    TestRunner tr;
+    parse::RunOpenLexerTests(tr);
+    parse::RunSourceFileTests(tr);
+    parse::RunScanTests(tr);
+    runtime::RunObjectHolderTests(tr);
+    runtime::RunObjectsTests(tr);
+    runtime::RunSymbolTests(tr);
+    ast::RunArenaTests(tr);
+    ast::RunUnitTests(tr);
+    TestParseProgram(tr);
+    ast::RunOptimizeTests(tr);
+    ast::RunDataflowTests(tr);
+    ast::RunReachabilityTests(tr);
+    ast::RunResolveTests(tr);
+    parse::RunIncrementalTests(tr);
+    parse::RunParallelParseTests(tr);
+    engine::RunEngineTests(tr);
+    vm::RunBytecodeTests(tr);
+    closure_compiler::RunClosureCompilerTests(tr);
+
+    RUN_TEST(tr, TestSimplePrints);
+    RUN_TEST(tr, TestAssignments);
+    RUN_TEST(tr, TestArithmetics);
+    RUN_TEST(tr, TestVariablesArePointers);
+}
+
+}  // namespace
+
+int main() {
+    TestAll();
+    return 0;
+}
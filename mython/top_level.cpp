@@ -0,0 +1,67 @@
+#include "top_level.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace parse {
+
+namespace {
+
+bool IsIdentifierChar(char c) {
+    const auto u = static_cast<unsigned char>(c);
+    return static_cast<unsigned char>((u | 0x20) - 'a') < 26 || static_cast<unsigned char>(u - '0') < 10
+           || c == '_';
+}
+
+// Строка, которая начинается с line, открывает новую инструкцию верхнего уровня: у неё нет отступа,
+// она не пустая, не комментарий и не ветка else инструкции if
+bool IsStatementStart(string_view line) {
+    const char c = line.front();
+    if (c == ' ' || c == '\n' || c == '#') {
+        return false;
+    }
+    constexpr string_view ELSE = "else"sv;
+    return !(line.substr(0, ELSE.size()) == ELSE
+             && (line.size() == ELSE.size() || !IsIdentifierChar(line[ELSE.size()])));
+}
+
+}  // namespace
+
+TopLevelSplit SplitTopLevel(string_view text) {
+    TopLevelSplit result;
+    char quote = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        if (quote == 0 && IsStatementStart(text.substr(pos))) {
+            if (pos == 0) {
+                result.leading_statement = true;
+            } else {
+                result.starts.push_back(pos);
+            }
+        }
+        // Дочитываем строку до конца, следя за строковыми константами
+        while (pos < text.size()) {
+            const char c = text[pos++];
+            if (quote != 0) {
+                if (c == '\\') {
+                    pos += pos < text.size() ? 1 : 0;
+                } else if (c == quote) {
+                    quote = 0;
+                } else if (c == '\n') {
+                    break;
+                }
+            } else if (c == '\n') {
+                break;
+            } else if (c == '\'' || c == '"') {
+                quote = c;
+            } else if (c == '#') {
+                pos = min(text.find('\n', pos), text.size());
+            }
+        }
+    }
+    result.ends_in_string = quote != 0;
+    return result;
+}
+
+}  // namespace parse
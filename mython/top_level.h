@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace parse {
+
+// Деление текста программы на инструкции верхнего уровня. Инструкция верхнего уровня начинается
+// со строки без отступа и продолжается до следующей такой строки: строки else, пустые строки,
+// комментарии и строковые константы, переходящие на новую строку, остаются в ней
+struct TopLevelSplit {
+    // Смещения начал инструкций. Первая инструкция всегда начинается с 0
+    std::vector<std::size_t> starts{0};
+    // Текст начинается с инструкции верхнего уровня
+    bool leading_statement = false;
+    // Текст заканчивается внутри незакрытой строковой константы
+    bool ends_in_string = false;
+};
+
+// Делит text, который начинается вне строковой константы, на инструкции верхнего уровня.
+// Комментарии и строковые константы пропускаются по тем же правилам, что и в лексере
+TopLevelSplit SplitTopLevel(std::string_view text);
+
+}  // namespace parse